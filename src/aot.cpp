@@ -0,0 +1,657 @@
+#include "aot.h"
+
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+namespace aot {
+
+	namespace {
+
+		// Вспомогательные функции сгенерированного кода. Повторяют семантику узлов ast
+		// в терминах runtime.h, так что сгенерированная программа не зависит от дерева
+		const char PRELUDE[] = R"(#include "runtime.h"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std::literals;
+
+namespace {
+
+	using runtime::Closure;
+	using runtime::Context;
+	using runtime::ObjectHolder;
+
+	// Операнды бинарной операции. Списочная инициализация вычисляет lhs раньше rhs
+	struct Operands {
+		ObjectHolder lhs;
+		ObjectHolder rhs;
+	};
+
+	ObjectHolder LoadVariable(const Closure& closure, const std::string& name) {
+		const auto it = closure.find(name);
+		if (it == closure.end()) {
+			throw std::runtime_error("Variable "s + name + " not found"s);
+		}
+		return it->second;
+	}
+
+	ObjectHolder LoadField(const ObjectHolder& object, const std::string& owner, const std::string& field) {
+		runtime::ClassInstance* instance = object.TryAs<runtime::ClassInstance>();
+		if (!instance) {
+			throw std::runtime_error("Variable "s + owner + " is not a class instance"s);
+		}
+		const auto it = instance->Fields().find(field);
+		if (it == instance->Fields().end()) {
+			throw std::runtime_error("Variable "s + field + " not found"s);
+		}
+		return it->second;
+	}
+
+	void Assign(Closure& closure, const std::string& name, ObjectHolder value) {
+		closure[name] = std::move(value);
+	}
+
+	int RangeBound(const ObjectHolder& value) {
+		if (const auto* number = value.TryAs<runtime::Number>()) {
+			return number->GetValue();
+		}
+		throw std::runtime_error("range() bounds must be numbers"s);
+	}
+
+	template <typename MakeValue>
+	void AssignField(const ObjectHolder& object, const std::string& field, MakeValue make_value) {
+		if (runtime::ClassInstance* instance = object.TryAs<runtime::ClassInstance>()) {
+			ObjectHolder value = make_value();
+			instance->Fields()[field] = std::move(value);
+		}
+	}
+
+	void PrintValue(std::ostream& os, const ObjectHolder& value, Context& context) {
+		if (value) {
+			value->Print(os, context);
+		}
+		else {
+			os << "None"s;
+		}
+	}
+
+	void PrintLine(std::stringstream& line, Context& context) {
+		line << "\n"s;
+		runtime::String(line.str()).Print(context.GetOutputStream(), context);
+	}
+
+	ObjectHolder Stringify(const ObjectHolder& value, Context& context) {
+		std::stringstream ss;
+		PrintValue(ss, value, context);
+		return ObjectHolder::Own(runtime::String(ss.str()));
+	}
+
+	ObjectHolder MakeBool(bool value) {
+		return ObjectHolder::Own(runtime::Bool(value));
+	}
+
+	ObjectHolder Add(const Operands& operands, Context& context) {
+		const auto* lhs_number = operands.lhs.TryAs<runtime::Number>();
+		const auto* rhs_number = operands.rhs.TryAs<runtime::Number>();
+		if (lhs_number && rhs_number) {
+			return ObjectHolder::Own(runtime::Number(lhs_number->GetValue() + rhs_number->GetValue()));
+		}
+		const auto* lhs_string = operands.lhs.TryAs<runtime::String>();
+		const auto* rhs_string = operands.rhs.TryAs<runtime::String>();
+		if (lhs_string && rhs_string) {
+			return ObjectHolder::Own(runtime::String(lhs_string->GetValue() + rhs_string->GetValue()));
+		}
+		if (runtime::ClassInstance* instance = operands.lhs.TryAs<runtime::ClassInstance>()) {
+			if (const runtime::Method* method = instance->FindMethod(runtime::SpecialMethod::Add, 1u)) {
+				return instance->Call(*method, runtime::Arguments(&operands.rhs, 1u), context);
+			}
+		}
+		throw std::runtime_error("Cannot add arguments"s);
+	}
+
+	ObjectHolder Sub(const Operands& operands) {
+		const auto* lhs = operands.lhs.TryAs<runtime::Number>();
+		const auto* rhs = operands.rhs.TryAs<runtime::Number>();
+		if (lhs && rhs) {
+			return ObjectHolder::Own(runtime::Number(lhs->GetValue() - rhs->GetValue()));
+		}
+		throw std::runtime_error("Cannot subtract arguments"s);
+	}
+
+	ObjectHolder Mult(const Operands& operands) {
+		const auto* lhs = operands.lhs.TryAs<runtime::Number>();
+		const auto* rhs = operands.rhs.TryAs<runtime::Number>();
+		if (lhs && rhs) {
+			return ObjectHolder::Own(runtime::Number(lhs->GetValue() * rhs->GetValue()));
+		}
+		throw std::runtime_error("Cannot multiply arguments"s);
+	}
+
+	ObjectHolder Div(const Operands& operands) {
+		const auto* lhs = operands.lhs.TryAs<runtime::Number>();
+		const auto* rhs = operands.rhs.TryAs<runtime::Number>();
+		if (lhs && rhs) {
+			if (rhs->GetValue() == 0) {
+				throw std::runtime_error("Zero division"s);
+			}
+			return ObjectHolder::Own(runtime::Number(lhs->GetValue() / rhs->GetValue()));
+		}
+		throw std::runtime_error("Cannot divide arguments"s);
+	}
+
+	ObjectHolder Comparison(runtime::CompareOp op, const Operands& operands, Context& context) {
+		return MakeBool(runtime::Compare(op, operands.lhs, operands.rhs, context));
+	}
+
+	// Для встроенного метода (см. runtime::HasBuiltinMethod) возвращает nullptr
+	const runtime::Method* ResolveMethod(const ObjectHolder& object, const std::string& name, size_t argc) {
+		const runtime::ClassInstance* instance = object.TryAs<runtime::ClassInstance>();
+		if (const runtime::Method* method = instance ? instance->FindMethod(name, argc) : nullptr) {
+			return method;
+		}
+		if (runtime::HasBuiltinMethod(object, name, argc)) {
+			return nullptr;
+		}
+		throw std::runtime_error("Object is not a class instance"s);
+	}
+
+	template <typename MakeArgs>
+	ObjectHolder CallMethod(const ObjectHolder& object, const std::string& name, size_t argc,
+		MakeArgs make_args, Context& context) {
+		const runtime::Method* method = ResolveMethod(object, name, argc);
+		const std::vector<ObjectHolder> args = make_args();
+		if (!method) {
+			return runtime::CallBuiltinMethod(object, name, args);
+		}
+		return object.TryAs<runtime::ClassInstance>()->Call(*method, args, context);
+	}
+
+	// return object.name(args) внутри метода: вызов выполняется в кадре текущего метода
+	template <typename MakeArgs>
+	ObjectHolder TailCall(ObjectHolder object, const std::string& name, size_t argc,
+		MakeArgs make_args, Context& context) {
+		const runtime::Method* method = ResolveMethod(object, name, argc);
+		std::vector<ObjectHolder> args = make_args();
+		if (!method) {
+			return runtime::CallBuiltinMethod(object, name, args);
+		}
+		context.SetTailCall(std::move(object), *method, args);
+		return ObjectHolder::None();
+	}
+
+	ObjectHolder MakeList(std::vector<ObjectHolder> items) {
+		return ObjectHolder::Own(runtime::List(std::move(items)));
+	}
+
+	// Ключи и значения литерала словаря вычисляются по очереди: ключ, затем значение
+	ObjectHolder MakeDict(const std::vector<ObjectHolder>& keys_and_values) {
+		runtime::Dict dict;
+		dict.Reserve(keys_and_values.size() / 2u);
+		for (size_t i = 0; i < keys_and_values.size(); i += 2u) {
+			dict.Set(keys_and_values[i], keys_and_values[i + 1u]);
+		}
+		return ObjectHolder::Own(std::move(dict));
+	}
+
+	ObjectHolder Length(const ObjectHolder& value) {
+		return ObjectHolder::Own(runtime::Number(runtime::GetLength(value)));
+	}
+
+	// Возвращает стандартную встроенную функцию name
+	const runtime::BuiltinFunction& GetBuiltin(const std::string& name) {
+		const runtime::BuiltinFunction* function = runtime::StandardBuiltins().Find(name);
+		if (!function) {
+			throw std::runtime_error("Unknown builtin function "s + name);
+		}
+		return *function;
+	}
+
+	ObjectHolder CallBuiltin(const runtime::BuiltinFunction& function, const std::vector<ObjectHolder>& args,
+		Context& context) {
+		return function.callable(args, context);
+	}
+
+	// operands.lhs[operands.rhs]
+	ObjectHolder Subscript(const Operands& operands) {
+		return runtime::GetItem(operands.lhs, operands.rhs);
+	}
+
+	// operands.lhs[operands.rhs] = make_value()
+	template <typename MakeValue>
+	void AssignItem(const Operands& operands, MakeValue make_value) {
+		ObjectHolder value = make_value();
+		runtime::SetItem(operands.lhs, operands.rhs, std::move(value));
+	}
+
+	template <typename MakeArgs>
+	ObjectHolder NewInstance(const runtime::Class& cls, size_t argc, MakeArgs make_args, Context& context) {
+		ObjectHolder holder = cls.CreateInstance();
+		auto& instance = *holder.TryAs<runtime::ClassInstance>();
+		if (const runtime::Method* init = instance.FindMethod(runtime::SpecialMethod::Init, argc)) {
+			const std::vector<ObjectHolder> args = make_args();
+			instance.Call(*init, args, context);
+		}
+		return holder;
+	}
+
+}  // namespace
+)";
+
+		// Возвращает строковый литерал C++ с тем же содержимым, что и value
+		string Quote(const string& value) {
+			ostringstream out;
+			out << '"';
+			for (const char c : value) {
+				switch (c) {
+				case '"':
+					out << "\\\""sv;
+					break;
+				case '\\':
+					out << "\\\\"sv;
+					break;
+				case '\n':
+					out << "\\n"sv;
+					break;
+				case '\t':
+					out << "\\t"sv;
+					break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) {
+						// Восьмеричная запись не поглощает следующие за ней символы, в отличие от \x
+						out << '\\' << oct << setw(3) << setfill('0') << static_cast<int>(static_cast<unsigned char>(c))
+							<< dec;
+					}
+					else {
+						out << c;
+					}
+				}
+			}
+			out << "\"s"sv;
+			return out.str();
+		}
+
+		string CompareOpName(runtime::CompareOp op) {
+			switch (op) {
+			case runtime::CompareOp::Equal:
+				return "Equal"s;
+			case runtime::CompareOp::NotEqual:
+				return "NotEqual"s;
+			case runtime::CompareOp::Less:
+				return "Less"s;
+			case runtime::CompareOp::Greater:
+				return "Greater"s;
+			case runtime::CompareOp::LessOrEqual:
+				return "LessOrEqual"s;
+			case runtime::CompareOp::GreaterOrEqual:
+				return "GreaterOrEqual"s;
+			}
+			throw runtime_error("Unknown comparison"s);
+		}
+
+		class Transpiler {
+		public:
+			void Run(const ast::Statement& program, ostream& out) {
+				CollectClasses(program);
+
+				ostringstream methods;
+				ostringstream classes;
+				for (size_t i = 0; i < classes_.size(); ++i) {
+					const runtime::Class& cls = *classes_[i];
+					classes << "\t\t{\n"sv
+						<< "\t\t\tstd::vector<runtime::Method> methods;\n"sv;
+					for (const runtime::Method& method : cls.GetOwnMethods()) {
+						const size_t index = method_count_++;
+						EmitMethodBody(methods, index, method);
+						classes << "\t\t\tmethods.push_back({ "sv << Quote(method.name) << ", { "sv;
+						for (const string& param : method.formal_params) {
+							classes << Quote(param) << ", "sv;
+						}
+						classes << "}, std::make_unique<MethodBody"sv << index << ">() });\n"sv;
+					}
+					classes << "\t\t\tclass_holder_"sv << i << " = ObjectHolder::Own(runtime::Class("sv << Quote(cls.GetName())
+						<< ", std::move(methods), "sv;
+					if (cls.GetParent()) {
+						classes << "class_"sv << ClassIndex(*cls.GetParent());
+					}
+					else {
+						classes << "nullptr"sv;
+					}
+					classes << "));\n"sv
+						<< "\t\t\tclass_"sv << i << " = class_holder_"sv << i << ".TryAs<runtime::Class>();\n"sv
+						<< "\t\t}\n"sv;
+				}
+
+				ostringstream main_body;
+				EmitStatement(main_body, program, 2, false);
+
+				out << "// Сгенерировано транспилятором Mython (mython --aot)\n"sv << PRELUDE << "\nnamespace {\n\n"sv;
+				for (size_t i = 0; i < classes_.size(); ++i) {
+					out << "\tObjectHolder class_holder_"sv << i << ";\n"sv
+						<< "\tconst runtime::Class* class_"sv << i << " = nullptr;\n"sv;
+				}
+				out << declarations_.str() << '\n' << methods.str()
+					<< "\tvoid CreateClasses() {\n"sv << classes.str() << "\t}\n\n"sv
+					<< "\tvoid RunProgram([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) {\n"sv
+					<< main_body.str() << "\t}\n\n"sv
+					<< "}  // namespace\n\n"sv
+					<< "int main() {\n"sv
+					<< "\ttry {\n"sv
+					<< "\t\tCreateClasses();\n"sv
+					<< "\t\truntime::SimpleContext context{ std::cout };\n"sv
+					<< "\t\tClosure closure;\n"sv
+					<< "\t\tRunProgram(closure, context);\n"sv
+					<< "\t}\n"sv
+					<< "\tcatch (const std::exception& e) {\n"sv
+					<< "\t\tstd::cerr << e.what() << std::endl;\n"sv
+					<< "\t\treturn 1;\n"sv
+					<< "\t}\n"sv
+					<< "\treturn 0;\n"sv
+					<< "}\n"sv;
+			}
+
+		private:
+			static string Indent(int level) {
+				return string(level, '\t');
+			}
+
+			// Находит все определения классов. Родительский класс в Mython определяется раньше
+			// наследника, поэтому порядок обхода годится для создания классов
+			void CollectClasses(const ast::Statement& statement) {
+				if (const auto* compound = dynamic_cast<const ast::Compound*>(&statement)) {
+					for (const auto& child : compound->GetStatements()) {
+						CollectClasses(*child);
+					}
+				}
+				else if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&statement)) {
+					CollectClasses(if_else->GetIfBody());
+					if (const ast::Statement* else_body = if_else->GetElseBody()) {
+						CollectClasses(*else_body);
+					}
+				}
+				else if (const auto* definition = dynamic_cast<const ast::ClassDefinition*>(&statement)) {
+					const runtime::Class& cls = definition->GetClass();
+					if (class_indices_.emplace(&cls, classes_.size()).second) {
+						classes_.push_back(&cls);
+					}
+				}
+			}
+
+			size_t ClassIndex(const runtime::Class& cls) const {
+				const auto it = class_indices_.find(&cls);
+				if (it == class_indices_.end()) {
+					throw runtime_error("Class "s + cls.GetName() + " is not defined in the program"s);
+				}
+				return it->second;
+			}
+
+			void EmitMethodBody(ostream& out, size_t index, const runtime::Method& method) {
+				const auto* body = dynamic_cast<const ast::MethodBody*>(method.body.get());
+				if (!body) {
+					throw runtime_error("Unsupported method body"s);
+				}
+				out << "\t// "sv << method.name << '\n'
+					<< "\tclass MethodBody"sv << index << " final : public runtime::Executable {\n"sv
+					<< "\tpublic:\n"sv
+					<< "\t\tObjectHolder Execute([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& context) override {\n"sv;
+				EmitStatement(out, body->GetBody(), 3, true);
+				out << "\t\t\treturn ObjectHolder::None();\n"sv
+					<< "\t\t}\n"sv
+					<< "\t};\n\n"sv;
+			}
+
+			void EmitStatement(ostream& out, const ast::Statement& statement, int level, bool in_method) {
+				const string indent = Indent(level);
+				if (const auto* compound = dynamic_cast<const ast::Compound*>(&statement)) {
+					for (const auto& child : compound->GetStatements()) {
+						EmitStatement(out, *child, level, in_method);
+					}
+				}
+				else if (const auto* assignment = dynamic_cast<const ast::Assignment*>(&statement)) {
+					out << indent << "Assign(closure, "sv << Quote(assignment->GetVariableName()) << ", "sv
+						<< Expression(assignment->GetValue()) << ");\n"sv;
+				}
+				else if (const auto* field_assignment = dynamic_cast<const ast::FieldAssignment*>(&statement)) {
+					out << indent << "AssignField("sv << Expression(field_assignment->GetObject()) << ", "sv
+						<< Quote(field_assignment->GetFieldName()) << ", [&] { return "sv
+						<< Expression(field_assignment->GetValue()) << "; });\n"sv;
+				}
+				else if (const auto* print = dynamic_cast<const ast::Print*>(&statement)) {
+					out << indent << "{\n"sv
+						<< indent << "\tstd::stringstream line;\n"sv;
+					bool first = true;
+					for (const auto& arg : print->GetArgs()) {
+						if (!first) {
+							out << indent << "\tline << \" \"s;\n"sv;
+						}
+						first = false;
+						out << indent << "\tPrintValue(line, "sv << Expression(*arg) << ", context);\n"sv;
+					}
+					out << indent << "\tPrintLine(line, context);\n"sv
+						<< indent << "}\n"sv;
+				}
+				else if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&statement)) {
+					out << indent << "if (runtime::IsTrue("sv << Expression(if_else->GetCondition()) << ")) {\n"sv;
+					EmitStatement(out, if_else->GetIfBody(), level + 1, in_method);
+					out << indent << "}\n"sv;
+					if (const ast::Statement* else_body = if_else->GetElseBody()) {
+						out << indent << "else {\n"sv;
+						EmitStatement(out, *else_body, level + 1, in_method);
+						out << indent << "}\n"sv;
+					}
+				}
+				else if (const auto* loop = dynamic_cast<const ast::While*>(&statement)) {
+					out << indent << "while (runtime::IsTrue("sv << Expression(loop->GetCondition()) << ")) {\n"sv;
+					EmitStatement(out, loop->GetBody(), level + 1, in_method);
+					out << indent << "}\n"sv;
+				}
+				else if (const auto* loop = dynamic_cast<const ast::ForRange*>(&statement)) {
+					const string index = to_string(loop_count_++);
+					const string counter = "i"s + index;
+					out << indent << "{\n"sv
+						<< indent << "\tconst int begin"sv << index << " = RangeBound("sv << Expression(loop->GetBegin()) << ");\n"sv
+						<< indent << "\tconst int end"sv << index << " = RangeBound("sv << Expression(loop->GetEnd()) << ");\n"sv
+						<< indent << "\tfor (int "sv << counter << " = begin"sv << index << "; "sv << counter << " < end"sv << index
+						<< "; ++"sv << counter << ") {\n"sv
+						<< indent << "\t\tAssign(closure, "sv << Quote(loop->GetVariable()) << ", ObjectHolder::Own(runtime::Number("sv
+						<< counter << ")));\n"sv;
+					EmitStatement(out, loop->GetBody(), level + 2, in_method);
+					out << indent << "\t}\n"sv
+						<< indent << "}\n"sv;
+				}
+				else if (const auto* loop = dynamic_cast<const ast::ForEach*>(&statement)) {
+					const string index = to_string(loop_count_++);
+					const string counter = "i"s + index;
+					const string iterable = "iterable"s + index;
+					out << indent << "{\n"sv
+						<< indent << "\tconst ObjectHolder "sv << iterable << " = "sv << Expression(loop->GetIterable()) << ";\n"sv
+						<< indent << "\tfor (size_t "sv << counter << " = 0; "sv << counter << " < runtime::GetIterationSize("sv
+						<< iterable << "); ++"sv << counter << ") {\n"sv
+						<< indent << "\t\tAssign(closure, "sv << Quote(loop->GetVariable()) << ", runtime::GetIterationItem("sv
+						<< iterable << ", "sv << counter << "));\n"sv;
+					EmitStatement(out, loop->GetBody(), level + 2, in_method);
+					out << indent << "\t}\n"sv
+						<< indent << "}\n"sv;
+				}
+				else if (const auto* assignment = dynamic_cast<const ast::IndexAssignment*>(&statement)) {
+					out << indent << "AssignItem(Operands{ "sv << Expression(assignment->GetObject()) << ", "sv
+						<< Expression(assignment->GetIndex()) << " }, [&] { return "sv
+						<< Expression(assignment->GetValue()) << "; });\n"sv;
+				}
+				else if (const auto* return_statement = dynamic_cast<const ast::Return*>(&statement)) {
+					const ast::Statement& value = return_statement->GetStatement();
+					const auto* call = dynamic_cast<const ast::MethodCall*>(&value);
+					if (!in_method) {
+						// return вне метода завершает выполнение программы
+						out << indent << "static_cast<void>("sv << Expression(value) << ");\n"sv
+							<< indent << "return;\n"sv;
+					}
+					else if (call) {
+						out << indent << "return TailCall("sv << CallArguments(*call) << ");\n"sv;
+					}
+					else {
+						out << indent << "return "sv << Expression(value) << ";\n"sv;
+					}
+				}
+				else if (const auto* definition = dynamic_cast<const ast::ClassDefinition*>(&statement)) {
+					const size_t index = ClassIndex(definition->GetClass());
+					out << indent << "Assign(closure, "sv << Quote(definition->GetClass().GetName()) << ", class_holder_"sv
+						<< index << ");\n"sv;
+				}
+				else {
+					out << indent << "static_cast<void>("sv << Expression(statement) << ");\n"sv;
+				}
+			}
+
+			// Аргументы функций CallMethod и TailCall: объект, имя метода, число аргументов,
+			// функция вычисления аргументов и контекст
+			string CallArguments(const ast::MethodCall& call) {
+				return Expression(call.GetObject()) + ", "s + Quote(call.GetMethodName()) + ", "s
+					+ to_string(call.GetArgs().size()) + ", "s + ArgsLambda(call.GetArgs()) + ", context"s;
+			}
+
+			string ArgsLambda(const vector<unique_ptr<ast::Statement>>& args) {
+				string result = "[&] { return std::vector<ObjectHolder>{ "s;
+				for (size_t i = 0; i < args.size(); ++i) {
+					if (i > 0) {
+						result += ", "s;
+					}
+					result += Expression(*args[i]);
+				}
+				return result + " }; }"s;
+			}
+
+			// Вызов встроенной функции. Сгенерированная программа находит функцию в таблице стандартных
+			// функций один раз, при первом вызове
+			string BuiltinCall(const ast::BuiltinCall& call) {
+				const runtime::BuiltinFunction& function = call.GetFunction();
+				const runtime::BuiltinFunction* standard = runtime::StandardBuiltins().Find(function.name);
+				if (!standard || standard->arity != function.arity) {
+					throw runtime_error("Builtin function "s + function.name + " is not a standard function"s);
+				}
+				const string name = "Builtin"s + to_string(builtin_count_++);
+				declarations_ << "\tconst runtime::BuiltinFunction& "sv << name << "() {\n"sv
+					<< "\t\tstatic const runtime::BuiltinFunction& function = GetBuiltin("sv << Quote(function.name) << ");\n"sv
+					<< "\t\treturn function;\n"sv
+					<< "\t}\n"sv;
+				return "CallBuiltin("s + name + "(), "s + ArgsLambda(call.GetArgs()) + "(), context)"s;
+			}
+
+			string Operands(const ast::BinaryOperation& operation) {
+				return "Operands{ "s + Expression(operation.GetLhs()) + ", "s + Expression(operation.GetRhs()) + " }"s;
+			}
+
+			// Объявляет глобальную константу и возвращает её имя
+			template <typename T>
+			string DeclareConstant(const string& type, const T& value) {
+				const string name = "constant_"s + to_string(constant_count_++);
+				declarations_ << "\t"sv << type << ' ' << name << "{ "sv << value << " };\n"sv;
+				return name;
+			}
+
+			string Expression(const ast::Statement& expression) {
+				if (const auto* number = dynamic_cast<const ast::NumericConst*>(&expression)) {
+					return "ObjectHolder::Share("s
+						+ DeclareConstant("runtime::Number"s, number->GetValue().GetValue()) + ")"s;
+				}
+				if (const auto* str = dynamic_cast<const ast::StringConst*>(&expression)) {
+					return "ObjectHolder::Share("s
+						+ DeclareConstant("runtime::String"s, Quote(str->GetValue().GetValue())) + ")"s;
+				}
+				if (const auto* boolean = dynamic_cast<const ast::BoolConst*>(&expression)) {
+					return "ObjectHolder::Share("s
+						+ DeclareConstant("runtime::Bool"s, boolean->GetValue().GetValue() ? "true"s : "false"s) + ")"s;
+				}
+				if (dynamic_cast<const ast::None*>(&expression)) {
+					return "ObjectHolder::None()"s;
+				}
+				if (const auto* variable = dynamic_cast<const ast::VariableValue*>(&expression)) {
+					const auto& ids = variable->GetDottedIds();
+					string result = "LoadVariable(closure, "s + Quote(ids[0]) + ")"s;
+					for (size_t i = 1; i < ids.size(); ++i) {
+						result = "LoadField("s + result + ", "s + Quote(ids[i - 1]) + ", "s + Quote(ids[i]) + ")"s;
+					}
+					return result;
+				}
+				if (const auto* call = dynamic_cast<const ast::MethodCall*>(&expression)) {
+					return "CallMethod("s + CallArguments(*call) + ")"s;
+				}
+				if (const auto* new_instance = dynamic_cast<const ast::NewInstance*>(&expression)) {
+					return "NewInstance(*class_"s + to_string(ClassIndex(new_instance->GetClass())) + ", "s
+						+ to_string(new_instance->GetArgs().size()) + ", "s + ArgsLambda(new_instance->GetArgs()) + ", context)"s;
+				}
+				if (const auto* stringify = dynamic_cast<const ast::Stringify*>(&expression)) {
+					return "Stringify("s + Expression(stringify->GetArgument()) + ", context)"s;
+				}
+				if (const auto* length = dynamic_cast<const ast::Length*>(&expression)) {
+					return "Length("s + Expression(length->GetArgument()) + ")"s;
+				}
+				if (const auto* builtin = dynamic_cast<const ast::BuiltinCall*>(&expression)) {
+					return BuiltinCall(*builtin);
+				}
+				if (const auto* list = dynamic_cast<const ast::ListLiteral*>(&expression)) {
+					return "MakeList("s + ArgsLambda(list->GetItems()) + "())"s;
+				}
+				if (const auto* dict = dynamic_cast<const ast::DictLiteral*>(&expression)) {
+					string result = "MakeDict(std::vector<ObjectHolder>{ "s;
+					for (size_t i = 0; i < dict->GetItems().size(); ++i) {
+						const auto& [key, value] = dict->GetItems()[i];
+						result += (i > 0 ? ", "s : ""s) + Expression(*key) + ", "s + Expression(*value);
+					}
+					return result + " })"s;
+				}
+				if (const auto* index = dynamic_cast<const ast::Index*>(&expression)) {
+					return "Subscript(Operands{ "s + Expression(index->GetObject()) + ", "s + Expression(index->GetIndex())
+						+ " })"s;
+				}
+				if (const auto* add = dynamic_cast<const ast::Add*>(&expression)) {
+					return "Add("s + Operands(*add) + ", context)"s;
+				}
+				if (const auto* sub = dynamic_cast<const ast::Sub*>(&expression)) {
+					return "Sub("s + Operands(*sub) + ")"s;
+				}
+				if (const auto* mult = dynamic_cast<const ast::Mult*>(&expression)) {
+					return "Mult("s + Operands(*mult) + ")"s;
+				}
+				if (const auto* div = dynamic_cast<const ast::Div*>(&expression)) {
+					return "Div("s + Operands(*div) + ")"s;
+				}
+				if (const auto* comparison = dynamic_cast<const ast::Comparison*>(&expression)) {
+					return "Comparison(runtime::CompareOp::"s + CompareOpName(comparison->GetOp()) + ", "s
+						+ Operands(*comparison) + ", context)"s;
+				}
+				if (const auto* or_operation = dynamic_cast<const ast::Or*>(&expression)) {
+					return "MakeBool(runtime::IsTrue("s + Expression(or_operation->GetLhs()) + ") || runtime::IsTrue("s
+						+ Expression(or_operation->GetRhs()) + "))"s;
+				}
+				if (const auto* and_operation = dynamic_cast<const ast::And*>(&expression)) {
+					return "MakeBool(runtime::IsTrue("s + Expression(and_operation->GetLhs()) + ") && runtime::IsTrue("s
+						+ Expression(and_operation->GetRhs()) + "))"s;
+				}
+				if (const auto* not_operation = dynamic_cast<const ast::Not*>(&expression)) {
+					return "MakeBool(!runtime::IsTrue("s + Expression(not_operation->GetArgument()) + "))"s;
+				}
+				throw runtime_error("Unsupported expression"s);
+			}
+
+			vector<const runtime::Class*> classes_;
+			unordered_map<const runtime::Class*, size_t> class_indices_;
+			ostringstream declarations_;
+			size_t method_count_ = 0;
+			size_t constant_count_ = 0;
+			size_t builtin_count_ = 0;
+			size_t loop_count_ = 0;
+		};
+
+	}  // namespace
+
+	void Transpile(const ast::Statement& program, ostream& out) {
+		Transpiler().Run(program, out);
+	}
+
+}  // namespace aot
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "statement.h"
+
+#include <ostream>
+
+namespace aot {
+
+	/*
+	Транслирует программу Mython в самостоятельную единицу трансляции C++17.
+
+	Классы программы создаются в сгенерированном коде как runtime::Class, тела методов
+	становятся наследниками runtime::Executable, а инструкции верхнего уровня - функцией,
+	вызываемой из main. Сгенерированный код использует только runtime.h и собирается
+	вместе с библиотекой mython_runtime:
+
+	  mython --aot < program.my > program.cpp
+	  c++ -std=c++17 -O2 -I<каталог src> program.cpp <сборка>/src/libmython_runtime.a -o program
+
+	Полученная программа выводит то же, что и интерпретатор. Встроенные функции берутся из
+	runtime::StandardBuiltins. Если в дереве встретится неизвестный узел или вызов функции,
+	зарегистрированной программой-хозяином, выбрасывается runtime_error
+	*/
+	void Transpile(const ast::Statement& program, std::ostream& out);
+
+}  // namespace aot
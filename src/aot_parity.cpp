@@ -0,0 +1,83 @@
+#include "aot.h"
+#include "aot_test_programs.h"
+#include "lexer.h"
+#include "parse.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+	// Выполняет программу интерпретатором и возвращает её вывод либо текст ошибки
+	string Interpret(const string& program) {
+		ostringstream output;
+		try {
+			istringstream input(program);
+			parse::Lexer lexer(input);
+			auto tree = ParseProgram(lexer);
+			runtime::SimpleContext context{ output };
+			runtime::Closure closure;
+			tree->Execute(closure, context);
+		}
+		catch (const exception& e) {
+			output << e.what() << '\n';
+		}
+		return output.str();
+	}
+
+	// Переводит программу на C++, собирает её с mython_runtime компилятором MYTHON_CXX_COMPILER
+	// (задаётся при сборке, см. src/CMakeLists.txt) в каталоге work_dir, выполняет
+	// и возвращает её вывод. Если собрать программу не удалось, выбрасывает runtime_error
+	string CompileAndRun(const string& name, const string& program, const string& work_dir) {
+		const string base = work_dir + "/"s + name;
+		{
+			istringstream input(program);
+			parse::Lexer lexer(input);
+			auto tree = ParseProgram(lexer);
+			ofstream source(base + ".cpp"s);
+			aot::Transpile(*tree, source);
+		}
+		const string compile = "\""s + MYTHON_CXX_COMPILER + "\" -std=c++17 -I\""s + MYTHON_SOURCE_DIR + "\" \""s + base
+			+ ".cpp\" \""s + MYTHON_RUNTIME_LIBRARY + "\" -o \""s + base + "\""s;
+		if (system(compile.c_str()) != 0) {
+			throw runtime_error("Failed to compile "s + base + ".cpp"s);
+		}
+		// Сообщение об ошибке выполнения сгенерированная программа выводит в stderr
+		const string run = "\""s + base + "\" > \""s + base + ".out\" 2>&1"s;
+		if (system(run.c_str()) == -1) {
+			throw runtime_error("Failed to run "s + base);
+		}
+		ifstream result(base + ".out"s);
+		return { istreambuf_iterator<char>(result), istreambuf_iterator<char>() };
+	}
+
+}  // namespace
+
+// Сравнивает вывод интерпретатора и программ, переведённых на C++ (--aot), на программах
+// тестов транслятора: mython_aot_parity <рабочий каталог>
+int main(int argc, char* argv[]) {
+	const string work_dir = argc > 1 ? argv[1] : "."s;
+	int failures = 0;
+	try {
+		for (const auto& [name, program] : aot::TEST_PROGRAMS) {
+			const string expected = Interpret(*program);
+			const string actual = CompileAndRun(name, *program, work_dir);
+			if (actual == expected) {
+				cout << name << " OK"sv << endl;
+				continue;
+			}
+			++failures;
+			cout << name << " differs\n--- interpreter:\n"sv << expected << "--- compiled:\n"sv << actual << endl;
+		}
+	}
+	catch (const exception& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#include "aot.h"
+#include "aot_test_programs.h"
+#include "lexer.h"
+#include "parse.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace aot {
+
+	namespace {
+
+		string TranspileString(const string& program) {
+			istringstream is(program);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+			ostringstream out;
+			Transpile(*tree, out);
+			return out.str();
+		}
+
+		void TestTranspileProgram() {
+			const string code = TranspileString(CLASSES_PROGRAM);
+			ASSERT(code.find("#include \"runtime.h\""s) != string::npos);
+			ASSERT(code.find("int main()"s) != string::npos);
+			// Собственные методы обоих классов и наследование
+			ASSERT(code.find("class MethodBody0 final"s) != string::npos);
+			ASSERT(code.find("class MethodBody2 final"s) != string::npos);
+			ASSERT(code.find("class MethodBody3 final"s) == string::npos);
+			ASSERT(code.find("runtime::Class(\"Rect\"s, std::move(methods), class_0)"s) != string::npos);
+			// Строковые литералы экранируются
+			ASSERT(code.find(R"("Shape \"quoted\"\n"s)"s) != string::npos);
+			// return вызова метода внутри метода выполняется как хвостовой
+			ASSERT(code.find("return TailCall("s) == string::npos);
+			ASSERT(code.find("Comparison(runtime::CompareOp::Greater"s) != string::npos);
+		}
+
+		void TestTranspileTailCall() {
+			const string code = TranspileString(TAIL_CALL_PROGRAM);
+			ASSERT(code.find("return TailCall(LoadVariable(closure, \"self\"s), \"count\"s, 1"s) != string::npos);
+		}
+
+		void TestTranspileLoops() {
+			const string code = TranspileString(LOOPS_PROGRAM);
+			ASSERT(code.find("const int begin0 = RangeBound("s) != string::npos);
+			ASSERT(code.find("for (int i1 = begin1; i1 < end1; ++i1) {"s) != string::npos);
+			ASSERT(code.find("Assign(closure, \"j\"s, ObjectHolder::Own(runtime::Number(i1)));"s) != string::npos);
+			ASSERT(code.find("while (runtime::IsTrue(Comparison(runtime::CompareOp::Greater"s) != string::npos);
+		}
+
+		void TestTranspileContainers() {
+			const string code = TranspileString(CONTAINERS_PROGRAM);
+			ASSERT(code.find("MakeList([&] { return std::vector<ObjectHolder>{ "s) != string::npos);
+			ASSERT(code.find("AssignItem(Operands{ LoadVariable(closure, \"items\"s), "s) != string::npos);
+			ASSERT(code.find("Subscript(Operands{ LoadVariable(closure, \"items\"s), "s) != string::npos);
+			ASSERT(code.find("for (size_t i0 = 0; i0 < runtime::GetIterationSize(iterable0); ++i0) {"s) != string::npos);
+			ASSERT(code.find("Assign(closure, \"x\"s, runtime::GetIterationItem(iterable0, i0));"s) != string::npos);
+			ASSERT(code.find("MakeDict(std::vector<ObjectHolder>{ "s) != string::npos);
+			ASSERT(code.find("AssignItem(Operands{ LoadVariable(closure, \"ages\"s), "s) != string::npos);
+		}
+
+		void TestTranspileBuiltins() {
+			const string code = TranspileString(BUILTINS_PROGRAM);
+			ASSERT(code.find("static const runtime::BuiltinFunction& function = GetBuiltin(\"abs\"s);"s) != string::npos);
+			ASSERT(code.find("CallBuiltin(Builtin1(), [&] { return std::vector<ObjectHolder>{ "s) != string::npos);
+
+			// Функции программы-хозяина недоступны скомпилированной программе
+			runtime::BuiltinRegistry registry;
+			registry.Register("host"s, 0u, [](runtime::Arguments /*args*/, runtime::Context& /*context*/) {
+				return runtime::ObjectHolder::None();
+			});
+			istringstream is("print host()\n"s);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer, registry);
+			ostringstream out;
+			ASSERT_THROWS(Transpile(*tree, out), runtime_error);
+		}
+
+	}  // namespace
+
+	void RunAotTests(TestRunner& tr) {
+		RUN_TEST(tr, aot::TestTranspileProgram);
+		RUN_TEST(tr, aot::TestTranspileTailCall);
+		RUN_TEST(tr, aot::TestTranspileLoops);
+		RUN_TEST(tr, aot::TestTranspileContainers);
+		RUN_TEST(tr, aot::TestTranspileBuiltins);
+	}
+
+}  // namespace aot
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <string>
+#include <utility>
+
+namespace aot {
+
+	// Программы тестов транслятора. Их перевод на C++ собирается с библиотекой mython_runtime,
+	// и вывод сравнивается с выводом интерпретатора (см. aot_parity.cpp)
+
+	inline const std::string CLASSES_PROGRAM = R"(
+class Shape:
+  def __str__():
+    return "Shape \"quoted\"\n"
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.w = w
+    self.h = h
+
+  def area():
+    return self.w * self.h
+
+r = Rect(10, 20)
+if r.area() > 100 and not False:
+  print r, r.area(), str(None)
+)";
+
+	inline const std::string TAIL_CALL_PROGRAM = R"(
+class Counter:
+  def count(n):
+    if n == 0:
+      return 0
+    return self.count(n - 1)
+
+c = Counter()
+print c.count(10)
+)";
+
+	inline const std::string LOOPS_PROGRAM = R"(
+total = 0
+for i in range(3):
+  for j in range(i, 5):
+    total = total + j
+while total > 10:
+  total = total - 10
+print total
+)";
+
+	inline const std::string CONTAINERS_PROGRAM = R"(
+items = [1, 'two']
+items.append(len(items))
+items[0] = items[-1]
+for x in items:
+  print x
+ages = {'ann': 31, 'bob': 27}
+ages['eve'] = ages.get('ann')
+print ages, len(ages)
+)";
+
+	inline const std::string RANGE_KEYS_PROGRAM = R"(
+d = {}
+for i in range(0, 3):
+  d[i] = i * 10
+print d, d.get(0), d.get(2)
+)";
+
+	inline const std::string BUILTINS_PROGRAM = "print abs(-2), max(1, 2)\n";
+
+	// Программы по именам
+	inline const std::pair<const char*, const std::string*> TEST_PROGRAMS[] = {
+		{ "classes", &CLASSES_PROGRAM },
+		{ "tail_call", &TAIL_CALL_PROGRAM },
+		{ "loops", &LOOPS_PROGRAM },
+		{ "containers", &CONTAINERS_PROGRAM },
+		{ "range_keys", &RANGE_KEYS_PROGRAM },
+		{ "builtins", &BUILTINS_PROGRAM },
+	};
+
+}  // namespace aot
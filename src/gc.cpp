@@ -0,0 +1,233 @@
+#include "gc.h"
+
+#include <cassert>
+#include <iomanip>
+
+using namespace std;
+
+namespace gc {
+
+	namespace {
+
+		using runtime::Container;
+		using runtime::ObjectHolder;
+		using runtime::ObjectType;
+		using runtime::TrackingNode;
+		using runtime::TrackingState;
+
+		// Возвращает объект по его узлу в списке поколения
+		Container& ObjectOf(TrackingNode& node) {
+			return static_cast<Container&>(node);
+		}
+
+		// Возвращает узел объекта value, если объект входит в собираемое поколение, иначе nullptr
+		TrackingNode* FindCollected(const ObjectHolder& value) {
+			switch (value.GetType()) {
+			case ObjectType::ClassInstance:
+			case ObjectType::List:
+			case ObjectType::Dict: {
+				auto* node = static_cast<TrackingNode*>(static_cast<Container*>(value.Get()));
+				return node->state == TrackingState::Collecting || node->state == TrackingState::Reachable ? node : nullptr;
+			}
+			default:
+				return nullptr;
+			}
+		}
+
+		// Вызывает visit для каждой ссылки объекта на другие объекты. Поля экземпляра перебираются
+		// по смещениям: форма с именами полей принадлежит классу, который мог быть уже уничтожен
+		template <typename Visit>
+		void ForEachReference(Container& object, Visit&& visit) {
+			switch (object.GetType()) {
+			case ObjectType::ClassInstance: {
+				runtime::InstanceFields& fields = static_cast<runtime::ClassInstance&>(object).Fields();
+				for (size_t slot = 0u; slot < fields.size(); ++slot) {
+					visit(fields.GetSlot(slot));
+				}
+				break;
+			}
+			case ObjectType::List:
+				for (const ObjectHolder& item : static_cast<runtime::List&>(object).GetItems()) {
+					visit(item);
+				}
+				break;
+			case ObjectType::Dict:
+				for (const runtime::Dict::Entry& entry : static_cast<runtime::Dict&>(object).GetEntries()) {
+					visit(entry.key);
+					visit(entry.value);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		// Удаляет ссылки объекта на другие объекты, разрывая цикл, в который он входит
+		void ClearReferences(Container& object) {
+			switch (object.GetType()) {
+			case ObjectType::ClassInstance: {
+				runtime::InstanceFields& fields = static_cast<runtime::ClassInstance&>(object).Fields();
+				for (size_t slot = 0u; slot < fields.size(); ++slot) {
+					fields.GetSlot(slot) = ObjectHolder::None();
+				}
+				break;
+			}
+			case ObjectType::List:
+				static_cast<runtime::List&>(object).Clear();
+				break;
+			case ObjectType::Dict:
+				static_cast<runtime::Dict&>(object).Clear();
+				break;
+			default:
+				break;
+			}
+		}
+
+		// Переносит все узлы списка from в конец списка to
+		void Splice(TrackingNode& from, TrackingNode& to) {
+			if (&from == &to || from.next == &from) {
+				return;
+			}
+			from.next->prev = to.prev;
+			to.prev->next = from.next;
+			from.prev->next = &to;
+			to.prev = from.prev;
+			from.next = from.prev = &from;
+		}
+
+		size_t CountNodes(const TrackingNode& head) {
+			size_t count = 0u;
+			for (const TrackingNode* node = head.next; node != &head; node = node->next) {
+				++count;
+			}
+			return count;
+		}
+
+		double ToMilliseconds(Collector::Duration duration) {
+			return chrono::duration<double, milli>(duration).count();
+		}
+
+	}  // namespace
+
+	Collector::Collector(size_t nursery_size)
+		: nursery_size_(nursery_size) {
+		nursery_.next = nursery_.prev = &nursery_;
+		old_.next = old_.prev = &old_;
+	}
+
+	Collector::~Collector() {
+		Collect();
+		for (TrackingNode* node = old_.next; node != &old_;) {
+			TrackingNode* next = node->next;
+			node->prev = node->next = nullptr;
+			node->state = TrackingState::Untracked;
+			node = next;
+		}
+	}
+
+	void Collector::Track(Container& object) {
+		assert(!object.IsLinked());
+		object.LinkBefore(nursery_);
+		object.state = TrackingState::Tracked;
+		if (++allocations_ < nursery_size_) {
+			return;
+		}
+		allocations_ = 0u;
+		if ((stats_.minor_collections + stats_.full_collections + 1u) % FULL_COLLECTION_PERIOD == 0u) {
+			Collect();
+		}
+		else {
+			CollectNursery();
+		}
+	}
+
+	size_t Collector::CollectNursery() {
+		++stats_.minor_collections;
+		return CollectGeneration(nursery_);
+	}
+
+	size_t Collector::Collect() {
+		++stats_.full_collections;
+		Splice(nursery_, old_);
+		return CollectGeneration(old_);
+	}
+
+	size_t Collector::CollectGeneration(TrackingNode& generation) {
+		const auto start = chrono::steady_clock::now();
+
+		// Ссылки из объектов поколения вычитаются из их счётчиков: остаток - ссылки извне
+		for (TrackingNode* node = generation.next; node != &generation; node = node->next) {
+			node->gc_refs = ObjectOf(*node).GetRefCount();
+			node->state = TrackingState::Collecting;
+		}
+		for (TrackingNode* node = generation.next; node != &generation; node = node->next) {
+			ForEachReference(ObjectOf(*node), [](const ObjectHolder& value) {
+				if (TrackingNode* target = FindCollected(value)) {
+					--target->gc_refs;
+				}
+			});
+		}
+
+		// Помечаются объекты, достижимые из объектов со ссылками извне
+		vector<TrackingNode*> worklist;
+		for (TrackingNode* node = generation.next; node != &generation; node = node->next) {
+			if (node->gc_refs > 0u) {
+				node->state = TrackingState::Reachable;
+				worklist.push_back(node);
+			}
+		}
+		while (!worklist.empty()) {
+			TrackingNode* node = worklist.back();
+			worklist.pop_back();
+			ForEachReference(ObjectOf(*node), [&worklist](const ObjectHolder& value) {
+				TrackingNode* target = FindCollected(value);
+				if (target && target->state == TrackingState::Collecting) {
+					target->state = TrackingState::Reachable;
+					worklist.push_back(target);
+				}
+			});
+		}
+
+		// Непомеченные объекты удерживаются, пока у них удаляются ссылки, и освобождаются вместе
+		vector<ObjectHolder> garbage;
+		for (TrackingNode* node = generation.next; node != &generation; node = node->next) {
+			if (node->state == TrackingState::Collecting) {
+				garbage.push_back(ObjectHolder::Share(ObjectOf(*node)));
+			}
+			node->state = TrackingState::Tracked;
+		}
+		Splice(generation, old_);
+		for (const ObjectHolder& object : garbage) {
+			ClearReferences(*static_cast<Container*>(object.Get()));
+		}
+		const size_t freed = garbage.size();
+		garbage.clear();
+
+		const Duration pause = chrono::duration_cast<Duration>(chrono::steady_clock::now() - start);
+		stats_.freed += freed;
+		stats_.total_pause += pause;
+		stats_.max_pause = max(stats_.max_pause, pause);
+		stats_.last_pause = pause;
+		return freed;
+	}
+
+	size_t Collector::GetNurseryCount() const {
+		return CountNodes(nursery_);
+	}
+
+	size_t Collector::GetOldCount() const {
+		return CountNodes(old_);
+	}
+
+	void Collector::Dump(ostream& out) const {
+		const uint64_t collections = stats_.minor_collections + stats_.full_collections;
+		out << "Cycle collector:\n"sv;
+		out << "  collections: "sv << stats_.minor_collections << " minor, "sv << stats_.full_collections << " full\n"sv;
+		out << "  freed objects: "sv << stats_.freed << '\n';
+		out << "  pause, ms: total "sv << fixed << setprecision(3) << ToMilliseconds(stats_.total_pause)
+			<< ", max "sv << ToMilliseconds(stats_.max_pause) << ", average "sv
+			<< (collections > 0u ? ToMilliseconds(stats_.total_pause) / static_cast<double>(collections) : 0.0) << '\n';
+		out << "  tracked objects: "sv << GetNurseryCount() << " young, "sv << GetOldCount() << " old\n"sv;
+	}
+
+}  // namespace gc
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <chrono>
+#include <ostream>
+
+namespace gc {
+
+	/*
+	Сборщик циклов ссылок. Объекты по-прежнему освобождаются подсчётом ссылок, а сборщик
+	находит экземпляры классов, списки и словари, которые ссылаются друг на друга, но
+	недостижимы из программы.
+
+	Корни сборки - объекты, на которые есть ссылки извне отслеживаемых объектов: из переменных
+	программы и кадров вызовов (Closure), из значений, которые вычисляет интерпретатор, и из
+	прочего кода на C++. Сборщик вычитает из счётчика ссылок каждого объекта собираемого
+	поколения ссылки из других его объектов; объекты с ненулевым остатком - корни. Затем
+	помечаются объекты, достижимые из корней, а у непомеченных удаляются ссылки, и подсчёт
+	ссылок их освобождает.
+
+	Объекты делятся на два поколения. Новые объекты попадают в молодое поколение (nursery),
+	которое собирается после каждых nursery_size созданных объектов; пережившие сборку
+	переходят в старое поколение. Каждая FULL_COLLECTION_PERIOD-я сборка - полная: она
+	собирает оба поколения и освобождает циклы, часть которых уже состарилась.
+	Объекты не перемещаются, так как код на C++ хранит указатели на них
+	*/
+	class Collector : public runtime::ObjectTracker {
+	public:
+		static constexpr size_t DEFAULT_NURSERY_SIZE = 1000u;
+		static constexpr size_t FULL_COLLECTION_PERIOD = 10u;
+
+		using Duration = std::chrono::nanoseconds;
+
+		// Счётчики сборок
+		struct Stats {
+			// Сборки только молодого поколения
+			uint64_t minor_collections = 0;
+			// Сборки обоих поколений
+			uint64_t full_collections = 0;
+			// Число освобождённых сборщиком объектов
+			uint64_t freed = 0;
+			// Суммарная, наибольшая и последняя паузы программы на сборку
+			Duration total_pause{};
+			Duration max_pause{};
+			Duration last_pause{};
+		};
+
+		explicit Collector(size_t nursery_size = DEFAULT_NURSERY_SIZE);
+
+		Collector(const Collector&) = delete;
+		Collector& operator=(const Collector&) = delete;
+
+		// Собирает оба поколения, а оставшиеся объекты перестают отслеживаться
+		~Collector() override;
+
+		// Добавляет объект в молодое поколение и при необходимости запускает сборку
+		void Track(runtime::Container& object) override;
+
+		// Собирает молодое поколение. Возвращает число освобождённых объектов
+		size_t CollectNursery();
+		// Собирает оба поколения. Возвращает число освобождённых объектов
+		size_t Collect();
+
+		// Возвращает число отслеживаемых объектов молодого и старого поколений
+		[[nodiscard]] size_t GetNurseryCount() const;
+		[[nodiscard]] size_t GetOldCount() const;
+
+		[[nodiscard]] const Stats& GetStats() const {
+			return stats_;
+		}
+
+		// Выводит число сборок, освобождённых объектов и длительность пауз
+		void Dump(std::ostream& out) const;
+
+	private:
+		// Собирает объекты списка generation, после чего переносит их в старое поколение
+		size_t CollectGeneration(runtime::TrackingNode& generation);
+
+		size_t nursery_size_;
+		// Число объектов, созданных после последней сборки
+		size_t allocations_ = 0;
+		// Головы кольцевых списков поколений
+		runtime::TrackingNode nursery_;
+		runtime::TrackingNode old_;
+		Stats stats_;
+	};
+
+}  // namespace gc
@@ -0,0 +1,162 @@
+#include "gc.h"
+#include "lexer.h"
+#include "parse.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace gc {
+
+	namespace {
+
+		const string PROGRAM = R"(
+class Node:
+  def __init__(value):
+    self.value = value
+    self.prev = None
+    self.next = None
+
+class Tree:
+  def __init__():
+    self.children = []
+
+  def add(value):
+    child = Node(value)
+    child.parent = self
+    self.children.append(child)
+
+class Builder:
+  def chain(n):
+    head = Node(0)
+    tail = head
+    for i in range(1, n):
+      node = Node(i)
+      node.prev = tail
+      tail.next = node
+      tail = node
+    return head
+
+  def tree(n):
+    t = Tree()
+    for i in range(n):
+      t.add(i)
+    return t
+
+b = Builder()
+total = 0
+for round in range(50):
+  head = b.chain(20)
+  t = b.tree(3)
+  total = total + head.next.value + len(t.children)
+  d = {'self': None}
+  d['self'] = d
+  l = [1]
+  l.append(l)
+kept = b.chain(5)
+print total, kept.next.next.value
+)"s;
+
+		// Выполняет программу с заданным учётом объектов и возвращает её вывод
+		string Run(runtime::ObjectTracker* tracker, runtime::Closure& closure) {
+			istringstream is(PROGRAM);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+			runtime::DummyContext context;
+			context.SetObjectTracker(tracker);
+			tree->Execute(closure, context);
+			return context.output.str();
+		}
+
+		size_t LiveNodes(const runtime::Closure& closure) {
+			return closure.at("Node"s).TryAs<runtime::Class>()->GetInstancePool().GetLiveCount();
+		}
+
+		void TestCyclesAreFreed() {
+			Collector collector(64u);
+			runtime::Closure closure;
+			ASSERT_EQUAL(Run(&collector, closure), "200 2\n"s);
+			const Collector::Stats& stats = collector.GetStats();
+			ASSERT(stats.minor_collections > 0u);
+			ASSERT(stats.full_collections > 0u);
+			ASSERT(stats.freed > 0u);
+			ASSERT(stats.max_pause >= stats.last_pause);
+
+			// После полной сборки остаются только объекты, достижимые из переменных программы:
+			// b, последние цепочка, дерево (Tree, список и узлы), словарь и список, а также kept
+			collector.Collect();
+			ASSERT_EQUAL(LiveNodes(closure), 20u + 3u + 5u);
+			ASSERT_EQUAL(collector.GetNurseryCount(), 0u);
+			ASSERT_EQUAL(collector.GetOldCount(), 1u + 20u + 5u + 2u + 5u);
+
+			closure.at("t"s) = runtime::ObjectHolder::None();
+			closure.at("kept"s) = runtime::ObjectHolder::None();
+			ASSERT_EQUAL(collector.Collect(), 5u + 5u);
+			ASSERT_EQUAL(LiveNodes(closure), 20u);
+		}
+
+		void TestGenerations() {
+			Collector collector(1000u);
+			runtime::Closure closure;
+			istringstream is(R"(
+class Pair:
+  def __init__():
+    self.other = None
+
+old = Pair()
+old.other = Pair()
+old.other.other = old
+)"s);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+			runtime::DummyContext context;
+			context.SetObjectTracker(&collector);
+			tree->Execute(closure, context);
+			ASSERT_EQUAL(collector.GetNurseryCount(), 2u);
+
+			// Пережившие сборку объекты переходят в старое поколение
+			ASSERT_EQUAL(collector.CollectNursery(), 0u);
+			ASSERT_EQUAL(collector.GetNurseryCount(), 0u);
+			ASSERT_EQUAL(collector.GetOldCount(), 2u);
+
+			// Сборка молодого поколения не освобождает старые циклы
+			closure.at("old"s) = runtime::ObjectHolder::None();
+			ASSERT_EQUAL(collector.CollectNursery(), 0u);
+			ASSERT_EQUAL(collector.Collect(), 2u);
+			ASSERT_EQUAL(collector.GetOldCount(), 0u);
+			ASSERT_EQUAL(collector.GetStats().minor_collections, 2u);
+			ASSERT_EQUAL(collector.GetStats().full_collections, 1u);
+
+			ostringstream out;
+			collector.Dump(out);
+			ASSERT(out.str().find("collections: 2 minor, 1 full\n"s) != string::npos);
+			ASSERT(out.str().find("freed objects: 2\n"s) != string::npos);
+		}
+
+		void TestObjectsReachableFromNativeCode() {
+			Collector collector;
+			runtime::Class cls("Cell"s, {}, nullptr);
+			runtime::ObjectHolder held = cls.CreateInstance();
+			collector.Track(*static_cast<runtime::Container*>(held.Get()));
+			{
+				runtime::ObjectHolder other = cls.CreateInstance();
+				collector.Track(*static_cast<runtime::Container*>(other.Get()));
+				held.TryAs<runtime::ClassInstance>()->Fields()["next"s] = other;
+				other.TryAs<runtime::ClassInstance>()->Fields()["next"s] = held;
+			}
+			// Ссылка из кода на C++ делает цикл достижимым
+			ASSERT_EQUAL(collector.Collect(), 0u);
+			ASSERT_EQUAL(cls.GetInstancePool().GetLiveCount(), 2u);
+			held = runtime::ObjectHolder::None();
+			ASSERT_EQUAL(collector.Collect(), 2u);
+			ASSERT_EQUAL(cls.GetInstancePool().GetLiveCount(), 0u);
+		}
+
+	}  // namespace
+
+	void RunGcTests(TestRunner& tr) {
+		RUN_TEST(tr, gc::TestCyclesAreFreed);
+		RUN_TEST(tr, gc::TestGenerations);
+		RUN_TEST(tr, gc::TestObjectsReachableFromNativeCode);
+	}
+
+}  // namespace gc
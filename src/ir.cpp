@@ -0,0 +1,960 @@
+#include "ir.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+namespace ir {
+
+	using runtime::ObjectHolder;
+
+	namespace {
+
+		// Тело метода содержит узел, который не переводится в IR
+		class UnsupportedError : public std::runtime_error {
+		public:
+			using runtime_error::runtime_error;
+		};
+
+		// Значение неприсвоенной переменной во время выполнения IR
+		class UndefinedValue : public runtime::Object {
+		public:
+			void Print(std::ostream& os, runtime::Context& /*context*/) override {
+				os << "<undefined>"sv;
+			}
+		};
+
+		UndefinedValue UNDEFINED_VALUE;
+
+		const ObjectHolder& Undefined() {
+			static const ObjectHolder undefined = ObjectHolder::Share(UNDEFINED_VALUE);
+			return undefined;
+		}
+
+		bool IsUndefined(const ObjectHolder& value) {
+			return value.Get() == &UNDEFINED_VALUE;
+		}
+
+		/*
+		Строит SSA по дереву методом Braun et al. («Simple and Efficient Construction of SSA Form»):
+		значения переменных ищутся по блокам вверх, phi создаются по требованию. Блок loop_header
+		остаётся незапечатанным до конца обхода, так как переходы в него добавляют хвостовые вызовы
+		*/
+		class Lowering {
+		public:
+			Lowering(const runtime::Class& cls, const runtime::Method& method)
+				: method_(method)
+				, function_(make_unique<Function>()) {
+				function_->method = &method;
+				function_->name = cls.GetName() + "."s + method.name;
+				params_.push_back("self"s);
+				params_.insert(params_.end(), method.formal_params.begin(), method.formal_params.end());
+			}
+
+			unique_ptr<Function> Run() {
+				const auto* body = dynamic_cast<const ast::MethodBody*>(method_.body.get());
+				if (!body) {
+					return nullptr;
+				}
+
+				Function& f = *function_;
+				f.entry = NewBlock();
+				header_ = NewBlock();
+				f.loop_header = header_;
+				sealed_[f.entry] = true;
+
+				current_ = f.entry;
+				undef_ = Emit(Opcode::Undef);
+				for (size_t i = 0; i < params_.size(); ++i) {
+					Instruction param;
+					param.op = Opcode::Param;
+					param.index = i;
+					param.name = params_[i];
+					WriteVariable(params_[i], f.entry, Emit(std::move(param)));
+				}
+				Jump(header_);
+
+				current_ = header_;
+				try {
+					Lower(body->GetBody());
+				}
+				catch (const UnsupportedError&) {
+					return nullptr;
+				}
+				if (current_ != NO_BLOCK) {
+					Terminate(Opcode::Return, { Constant(ObjectHolder::None()) });
+				}
+				Seal(header_);
+				return std::move(function_);
+			}
+
+		private:
+			BlockId NewBlock() {
+				function_->blocks.emplace_back();
+				defs_.emplace_back();
+				sealed_.push_back(false);
+				incomplete_phis_.emplace_back();
+				return static_cast<BlockId>(function_->blocks.size() - 1);
+			}
+
+			ValueId Append(BlockId block, Instruction instruction, optional<size_t> position = nullopt) {
+				instruction.block = block;
+				const auto id = static_cast<ValueId>(function_->values.size());
+				function_->values.push_back(std::move(instruction));
+				auto& code = function_->blocks[block].code;
+				code.insert(position ? code.begin() + static_cast<ptrdiff_t>(*position) : code.end(), id);
+				return id;
+			}
+
+			ValueId Emit(Instruction instruction) {
+				return Append(current_, std::move(instruction));
+			}
+
+			ValueId Emit(Opcode op, vector<ValueId> operands = {}, string name = {}) {
+				Instruction instruction;
+				instruction.op = op;
+				instruction.operands = std::move(operands);
+				instruction.name = std::move(name);
+				return Emit(std::move(instruction));
+			}
+
+			// Константы вычисляются в entry перед его терминатором, так что доминируют над всеми блоками
+			ValueId Constant(ObjectHolder value) {
+				ostringstream key;
+				key << static_cast<int>(value.GetType()) << ':';
+				if (value) {
+					runtime::DummyContext context;
+					value->Print(key, context);
+				}
+				auto [it, inserted] = constants_.emplace(key.str(), NO_VALUE);
+				if (inserted) {
+					Instruction constant;
+					constant.op = Opcode::Const;
+					constant.constant = std::move(value);
+					auto& entry_code = function_->blocks[function_->entry].code;
+					it->second = Append(function_->entry, std::move(constant), entry_code.size() - 1);
+				}
+				return it->second;
+			}
+
+			void AddEdge(BlockId from, BlockId to) {
+				function_->blocks[to].preds.push_back(from);
+			}
+
+			void Terminate(Opcode op, vector<ValueId> operands, string name = {}) {
+				Emit(op, std::move(operands), std::move(name));
+				current_ = NO_BLOCK;
+			}
+
+			void Jump(BlockId target) {
+				Instruction jump;
+				jump.op = Opcode::Jump;
+				jump.targets[0] = target;
+				Emit(std::move(jump));
+				AddEdge(current_, target);
+				current_ = NO_BLOCK;
+			}
+
+			void Branch(ValueId condition, BlockId if_true, BlockId if_false) {
+				Instruction branch;
+				branch.op = Opcode::Branch;
+				branch.operands = { condition };
+				branch.targets = { if_true, if_false };
+				Emit(std::move(branch));
+				AddEdge(current_, if_true);
+				AddEdge(current_, if_false);
+				current_ = NO_BLOCK;
+			}
+
+			void WriteVariable(const string& name, BlockId block, ValueId value) {
+				defs_[block][name] = value;
+			}
+
+			ValueId ReadVariable(const string& name, BlockId block) {
+				if (const auto it = defs_[block].find(name); it != defs_[block].end()) {
+					return it->second;
+				}
+				ValueId value;
+				const Block& b = function_->blocks[block];
+				if (!sealed_[block]) {
+					value = NewPhi(block);
+					incomplete_phis_[block].emplace_back(name, value);
+				}
+				else if (b.preds.empty()) {
+					value = undef_;
+				}
+				else if (b.preds.size() == 1u) {
+					value = ReadVariable(name, b.preds.front());
+				}
+				else {
+					value = NewPhi(block);
+					WriteVariable(name, block, value);
+					AddPhiOperands(name, value);
+				}
+				WriteVariable(name, block, value);
+				return value;
+			}
+
+			ValueId NewPhi(BlockId block) {
+				Instruction phi;
+				phi.op = Opcode::Phi;
+				return Append(block, std::move(phi), 0u);
+			}
+
+			void AddPhiOperands(const string& name, ValueId phi) {
+				const BlockId block = function_->values[phi].block;
+				const bool is_param = find(params_.begin(), params_.end(), name) != params_.end();
+				for (const BlockId pred : vector<BlockId>(function_->blocks[block].preds)) {
+					// Вызов метода заново начинается с пустыми локальными переменными
+					const bool back_edge = block == header_ && pred != function_->entry;
+					const ValueId operand = back_edge && !is_param ? undef_ : ReadVariable(name, pred);
+					function_->values[phi].operands.push_back(operand);
+				}
+			}
+
+			void Seal(BlockId block) {
+				for (const auto& [name, phi] : incomplete_phis_[block]) {
+					AddPhiOperands(name, phi);
+				}
+				incomplete_phis_[block].clear();
+				sealed_[block] = true;
+			}
+
+			// Переводит узел в IR и возвращает его значение. Для инструкций возвращается None
+			ValueId Lower(const ast::Statement& statement) {
+				if (const auto* compound = dynamic_cast<const ast::Compound*>(&statement)) {
+					for (const auto& child : compound->GetStatements()) {
+						if (current_ == NO_BLOCK) {
+							break;
+						}
+						Lower(*child);
+					}
+					return Constant(ObjectHolder::None());
+				}
+				if (const auto* number = dynamic_cast<const ast::NumericConst*>(&statement)) {
+					return Constant(ObjectHolder::Own(runtime::Number(number->GetValue().GetValue())));
+				}
+				if (const auto* str = dynamic_cast<const ast::StringConst*>(&statement)) {
+					return Constant(ObjectHolder::Own(runtime::String(str->GetValue().GetValue())));
+				}
+				if (const auto* boolean = dynamic_cast<const ast::BoolConst*>(&statement)) {
+					return Constant(ObjectHolder::Own(runtime::Bool(boolean->GetValue().GetValue())));
+				}
+				if (dynamic_cast<const ast::None*>(&statement)) {
+					return Constant(ObjectHolder::None());
+				}
+				if (const auto* variable = dynamic_cast<const ast::VariableValue*>(&statement)) {
+					return LowerVariable(variable->GetDottedIds());
+				}
+				if (const auto* assignment = dynamic_cast<const ast::Assignment*>(&statement)) {
+					const ValueId value = Lower(assignment->GetValue());
+					WriteVariable(assignment->GetVariableName(), current_, value);
+					return value;
+				}
+				if (const auto* field_assignment = dynamic_cast<const ast::FieldAssignment*>(&statement)) {
+					return LowerFieldAssignment(*field_assignment);
+				}
+				if (const auto* print = dynamic_cast<const ast::Print*>(&statement)) {
+					// Каждый аргумент переводится в строку сразу после вычисления, как в ast::Print
+					vector<ValueId> parts;
+					for (const auto& arg : print->GetArgs()) {
+						parts.push_back(Emit(Opcode::Stringify, { Lower(*arg) }));
+					}
+					Emit(Opcode::Print, std::move(parts));
+					return Constant(ObjectHolder::None());
+				}
+				if (const auto* call = dynamic_cast<const ast::MethodCall*>(&statement)) {
+					vector<ValueId> operands = LowerCall(*call);
+					return Emit(Opcode::Call, std::move(operands), call->GetMethodName());
+				}
+				if (const auto* new_instance = dynamic_cast<const ast::NewInstance*>(&statement)) {
+					Instruction instruction;
+					instruction.op = Opcode::New;
+					instruction.new_instance = new_instance;
+					if (new_instance->HasConstructor()) {
+						for (const auto& arg : new_instance->GetArgs()) {
+							instruction.operands.push_back(Lower(*arg));
+						}
+					}
+					return Emit(std::move(instruction));
+				}
+				if (const auto* stringify = dynamic_cast<const ast::Stringify*>(&statement)) {
+					return Emit(Opcode::Stringify, { Lower(stringify->GetArgument()) });
+				}
+				if (const auto* not_operation = dynamic_cast<const ast::Not*>(&statement)) {
+					return Emit(Opcode::Not, { Lower(not_operation->GetArgument()) });
+				}
+				if (const auto* or_operation = dynamic_cast<const ast::Or*>(&statement)) {
+					return LowerLogical(*or_operation, true);
+				}
+				if (const auto* and_operation = dynamic_cast<const ast::And*>(&statement)) {
+					return LowerLogical(*and_operation, false);
+				}
+				if (const auto* comparison = dynamic_cast<const ast::Comparison*>(&statement)) {
+					const ValueId lhs = Lower(comparison->GetLhs());
+					const ValueId rhs = Lower(comparison->GetRhs());
+					Instruction compare;
+					compare.op = Opcode::Compare;
+					compare.operands = { lhs, rhs };
+					compare.compare_op = comparison->GetOp();
+					return Emit(std::move(compare));
+				}
+				if (const auto* binary = dynamic_cast<const ast::BinaryOperation*>(&statement)) {
+					Opcode op;
+					if (dynamic_cast<const ast::Add*>(binary)) {
+						op = Opcode::Add;
+					}
+					else if (dynamic_cast<const ast::Sub*>(binary)) {
+						op = Opcode::Sub;
+					}
+					else if (dynamic_cast<const ast::Mult*>(binary)) {
+						op = Opcode::Mult;
+					}
+					else if (dynamic_cast<const ast::Div*>(binary)) {
+						op = Opcode::Div;
+					}
+					else {
+						throw UnsupportedError("Unknown binary operation"s);
+					}
+					const ValueId lhs = Lower(binary->GetLhs());
+					const ValueId rhs = Lower(binary->GetRhs());
+					return Emit(op, { lhs, rhs });
+				}
+				if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&statement)) {
+					LowerIfElse(*if_else);
+					return Constant(ObjectHolder::None());
+				}
+				if (const auto* return_statement = dynamic_cast<const ast::Return*>(&statement)) {
+					LowerReturn(*return_statement);
+					return Constant(ObjectHolder::None());
+				}
+				throw UnsupportedError("Unsupported statement"s);
+			}
+
+			ValueId LowerVariable(const vector<string>& ids) {
+				ValueId value = Emit(Opcode::CheckDefined, { ReadVariable(ids.front(), current_) }, ids.front());
+				for (size_t i = 1; i < ids.size(); ++i) {
+					Instruction load;
+					load.op = Opcode::LoadField;
+					load.operands = { value };
+					load.name = ids[i];
+					load.owner = ids[i - 1];
+					value = Emit(std::move(load));
+				}
+				return value;
+			}
+
+			// Значение вычисляется и записывается, только если объект - экземпляр класса
+			ValueId LowerFieldAssignment(const ast::FieldAssignment& assignment) {
+				const ValueId object = LowerVariable(assignment.GetObject().GetDottedIds());
+				const BlockId store_block = NewBlock();
+				const BlockId join = NewBlock();
+				Branch(Emit(Opcode::IsInstance, { object }), store_block, join);
+				Seal(store_block);
+
+				current_ = store_block;
+				const ValueId value = Lower(assignment.GetValue());
+				Emit(Opcode::StoreField, { object, value }, assignment.GetFieldName());
+				Jump(join);
+				Seal(join);
+				current_ = join;
+				return Constant(ObjectHolder::None());
+			}
+
+			// Возвращает операнды вызова: объект и аргументы. Наличие метода проверяется
+			// до вычисления аргументов, как в ast::MethodCall
+			vector<ValueId> LowerCall(const ast::MethodCall& call) {
+				const ValueId object = Lower(call.GetObject());
+				Instruction resolve;
+				resolve.op = Opcode::ResolveMethod;
+				resolve.operands = { object };
+				resolve.name = call.GetMethodName();
+				resolve.index = call.GetArgs().size();
+				last_resolve_ = Emit(std::move(resolve));
+				vector<ValueId> operands = { object };
+				for (const auto& arg : call.GetArgs()) {
+					operands.push_back(Lower(*arg));
+				}
+				return operands;
+			}
+
+			ValueId LowerLogical(const ast::BinaryOperation& operation, bool is_or) {
+				const ValueId lhs = Lower(operation.GetLhs());
+				const BlockId from = current_;
+				const BlockId rhs_block = NewBlock();
+				const BlockId join = NewBlock();
+				if (is_or) {
+					Branch(lhs, join, rhs_block);
+				}
+				else {
+					Branch(lhs, rhs_block, join);
+				}
+				Seal(rhs_block);
+
+				current_ = rhs_block;
+				const ValueId rhs = Emit(Opcode::Truth, { Lower(operation.GetRhs()) });
+				Jump(join);
+				Seal(join);
+
+				current_ = join;
+				const ValueId phi = NewPhi(join);
+				const ValueId short_circuit = Constant(ObjectHolder::Own(runtime::Bool(is_or)));
+				for (const BlockId pred : function_->blocks[join].preds) {
+					function_->values[phi].operands.push_back(pred == from ? short_circuit : rhs);
+				}
+				return phi;
+			}
+
+			void LowerIfElse(const ast::IfElse& if_else) {
+				const ValueId condition = Lower(if_else.GetCondition());
+				const BlockId then_block = NewBlock();
+				const BlockId else_block = if_else.GetElseBody() ? NewBlock() : NO_BLOCK;
+				const BlockId join = NewBlock();
+				Branch(condition, then_block, else_block != NO_BLOCK ? else_block : join);
+
+				Seal(then_block);
+				current_ = then_block;
+				Lower(if_else.GetIfBody());
+				if (current_ != NO_BLOCK) {
+					Jump(join);
+				}
+				if (else_block != NO_BLOCK) {
+					Seal(else_block);
+					current_ = else_block;
+					Lower(*if_else.GetElseBody());
+					if (current_ != NO_BLOCK) {
+						Jump(join);
+					}
+				}
+				Seal(join);
+				current_ = function_->blocks[join].preds.empty() ? NO_BLOCK : join;
+			}
+
+			// return obj.m(args) переходит в начало метода, если obj.m - сам метод,
+			// и выполняет хвостовой вызов в остальных случаях
+			void LowerReturn(const ast::Return& return_statement) {
+				const auto* call = dynamic_cast<const ast::MethodCall*>(&return_statement.GetStatement());
+				if (!call) {
+					Terminate(Opcode::Return, { Lower(return_statement.GetStatement()) });
+					return;
+				}
+				vector<ValueId> operands = LowerCall(*call);
+				const ValueId is_self = last_resolve_;
+				if (operands.size() == params_.size()) {
+					for (size_t i = 0; i < params_.size(); ++i) {
+						WriteVariable(params_[i], current_, operands[i]);
+					}
+					const BlockId tail_block = NewBlock();
+					Branch(is_self, header_, tail_block);
+					Seal(tail_block);
+					current_ = tail_block;
+				}
+				Terminate(Opcode::TailCall, std::move(operands), call->GetMethodName());
+			}
+
+			const runtime::Method& method_;
+			unique_ptr<Function> function_;
+			vector<string> params_;
+			BlockId header_ = NO_BLOCK;
+			BlockId current_ = NO_BLOCK;
+			ValueId undef_ = NO_VALUE;
+			ValueId last_resolve_ = NO_VALUE;
+			vector<unordered_map<string, ValueId>> defs_;
+			vector<bool> sealed_;
+			vector<vector<pair<string, ValueId>>> incomplete_phis_;
+			unordered_map<string, ValueId> constants_;
+		};
+
+		string_view ToString(Opcode op) {
+			switch (op) {
+			case Opcode::Const: return "const"sv;
+			case Opcode::Undef: return "undef"sv;
+			case Opcode::Param: return "param"sv;
+			case Opcode::Phi: return "phi"sv;
+			case Opcode::CheckDefined: return "check_defined"sv;
+			case Opcode::IsInstance: return "is_instance"sv;
+			case Opcode::LoadField: return "load"sv;
+			case Opcode::TryLoadField: return "try_load"sv;
+			case Opcode::CheckLoad: return "check_load"sv;
+			case Opcode::StoreField: return "store"sv;
+			case Opcode::Add: return "add"sv;
+			case Opcode::Sub: return "sub"sv;
+			case Opcode::Mult: return "mult"sv;
+			case Opcode::Div: return "div"sv;
+			case Opcode::Compare: return "cmp"sv;
+			case Opcode::Not: return "not"sv;
+			case Opcode::Truth: return "truth"sv;
+			case Opcode::Stringify: return "str"sv;
+			case Opcode::ResolveMethod: return "resolve"sv;
+			case Opcode::Call: return "call"sv;
+			case Opcode::New: return "new"sv;
+			case Opcode::Print: return "print"sv;
+			case Opcode::Jump: return "jump"sv;
+			case Opcode::Branch: return "branch"sv;
+			case Opcode::Return: return "return"sv;
+			case Opcode::TailCall: return "tail_call"sv;
+			case Opcode::Nop: return "nop"sv;
+			}
+			return "?"sv;
+		}
+
+		string_view ToString(runtime::CompareOp op) {
+			switch (op) {
+			case runtime::CompareOp::Equal: return "=="sv;
+			case runtime::CompareOp::NotEqual: return "!="sv;
+			case runtime::CompareOp::Less: return "<"sv;
+			case runtime::CompareOp::Greater: return ">"sv;
+			case runtime::CompareOp::LessOrEqual: return "<="sv;
+			case runtime::CompareOp::GreaterOrEqual: return ">="sv;
+			}
+			return "?"sv;
+		}
+
+		void PrintConstant(const ObjectHolder& value, ostream& out) {
+			if (const auto* str = value.TryAs<runtime::String>()) {
+				out << quoted(str->GetValue(), '\'');
+			}
+			else if (value) {
+				runtime::DummyContext context;
+				value->Print(out, context);
+			}
+			else {
+				out << "None"sv;
+			}
+		}
+
+		// Выполняет callback для каждого метода каждого класса, объявленного в программе
+		template <typename Callback>
+		void ForEachMethod(const ast::Statement& statement, Callback&& callback) {
+			if (const auto* compound = dynamic_cast<const ast::Compound*>(&statement)) {
+				for (const auto& child : compound->GetStatements()) {
+					ForEachMethod(*child, callback);
+				}
+			}
+			else if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&statement)) {
+				ForEachMethod(if_else->GetIfBody(), callback);
+				if (const ast::Statement* else_body = if_else->GetElseBody()) {
+					ForEachMethod(*else_body, callback);
+				}
+			}
+			else if (const auto* definition = dynamic_cast<const ast::ClassDefinition*>(&statement)) {
+				const runtime::Class& cls = definition->GetClass();
+				for (const runtime::Method& method : cls.GetOwnMethods()) {
+					callback(cls, method);
+				}
+			}
+		}
+
+		runtime::ClassInstance& AsInstance(const ObjectHolder& object, const string& owner) {
+			auto* instance = object.TryAs<runtime::ClassInstance>();
+			if (!instance) {
+				throw std::runtime_error("Variable "s + owner + " is not a class instance"s);
+			}
+			return *instance;
+		}
+
+		const ObjectHolder* FindField(runtime::ClassInstance& instance, const string& name) {
+			auto& fields = instance.Fields();
+			const auto it = fields.find(name);
+			return it != fields.end() ? &it->second : nullptr;
+		}
+
+		ObjectHolder LoadField(const ObjectHolder& object, const Instruction& load) {
+			if (const ObjectHolder* value = FindField(AsInstance(object, load.owner), load.name)) {
+				return *value;
+			}
+			throw std::runtime_error("Variable "s + load.name + " not found"s);
+		}
+
+		// Для встроенного метода (см. runtime::HasBuiltinMethod) возвращает nullptr
+		const runtime::Method* ResolveMethod(const ObjectHolder& object, const string& name, size_t argument_count) {
+			const auto* instance = object.TryAs<runtime::ClassInstance>();
+			if (const runtime::Method* method = instance ? instance->FindMethod(name, argument_count) : nullptr) {
+				return method;
+			}
+			if (runtime::HasBuiltinMethod(object, name, argument_count)) {
+				return nullptr;
+			}
+			throw std::runtime_error("Object is not a class instance"s);
+		}
+
+		ObjectHolder Add(const ObjectHolder& lhs, const ObjectHolder& rhs, runtime::Context& context) {
+			if (const auto* l = lhs.TryAs<runtime::Number>()) {
+				if (const auto* r = rhs.TryAs<runtime::Number>()) {
+					return ObjectHolder::Own(runtime::Number(l->GetValue() + r->GetValue()));
+				}
+			}
+			else if (const auto* l = lhs.TryAs<runtime::String>()) {
+				if (const auto* r = rhs.TryAs<runtime::String>()) {
+					return ObjectHolder::Own(runtime::String(l->GetValue() + r->GetValue()));
+				}
+			}
+			else if (auto* instance = lhs.TryAs<runtime::ClassInstance>()) {
+				if (const runtime::Method* method = instance->FindMethod(runtime::SpecialMethod::Add, 1u)) {
+					return instance->Call(*method, runtime::Arguments(&rhs, 1u), context);
+				}
+			}
+			throw std::runtime_error("Cannot add arguments"s);
+		}
+
+		// Применяет к числам операцию Sub, Mult или Div
+		ObjectHolder Arithmetic(Opcode op, const ObjectHolder& lhs, const ObjectHolder& rhs) {
+			const auto* l = lhs.TryAs<runtime::Number>();
+			const auto* r = rhs.TryAs<runtime::Number>();
+			switch (op) {
+			case Opcode::Sub:
+				if (l && r) {
+					return ObjectHolder::Own(runtime::Number(l->GetValue() - r->GetValue()));
+				}
+				throw std::runtime_error("Cannot subtract arguments"s);
+			case Opcode::Mult:
+				if (l && r) {
+					return ObjectHolder::Own(runtime::Number(l->GetValue() * r->GetValue()));
+				}
+				throw std::runtime_error("Cannot multiply arguments"s);
+			default:
+				if (l && r) {
+					if (r->GetValue() == 0) {
+						throw std::runtime_error("Zero division"s);
+					}
+					return ObjectHolder::Own(runtime::Number(l->GetValue() / r->GetValue()));
+				}
+				throw std::runtime_error("Cannot divide arguments"s);
+			}
+		}
+
+		ObjectHolder Stringify(const ObjectHolder& value, runtime::Context& context) {
+			if (value.GetType() == runtime::ObjectType::String) {
+				return value;
+			}
+			std::stringstream ss;
+			if (value) {
+				value->Print(ss, context);
+			}
+			else {
+				ss << "None"s;
+			}
+			return ObjectHolder::Own(runtime::String(ss.str()));
+		}
+
+		ObjectHolder MakeBool(bool value) {
+			return ObjectHolder::Own(runtime::Bool(value));
+		}
+
+	}  // namespace
+
+	vector<BlockId> Function::GetSuccessors(BlockId block) const {
+		const auto& code = blocks[block].code;
+		if (code.empty()) {
+			return {};
+		}
+		const Instruction& terminator = values[code.back()];
+		vector<BlockId> successors;
+		for (const BlockId target : terminator.targets) {
+			if (target != NO_BLOCK) {
+				successors.push_back(target);
+			}
+		}
+		return successors;
+	}
+
+	unique_ptr<Function> Lower(const runtime::Class& cls, const runtime::Method& method) {
+		return Lowering(cls, method).Run();
+	}
+
+	void Verify(const Function& function) {
+		auto fail = [&function](const string& message) {
+			throw logic_error("IR of "s + function.name + ": "s + message);
+		};
+		for (BlockId b = 0; b < function.blocks.size(); ++b) {
+			const Block& block = function.blocks[b];
+			if (block.code.empty()) {
+				continue;
+			}
+			if (!IsTerminator(function.values[block.code.back()].op)) {
+				fail("block b"s + to_string(b) + " has no terminator"s);
+			}
+			bool phis = true;
+			for (size_t i = 0; i < block.code.size(); ++i) {
+				const Instruction& instruction = function.values[block.code[i]];
+				if (instruction.block != b) {
+					fail("v"s + to_string(block.code[i]) + " has wrong block"s);
+				}
+				if (IsTerminator(instruction.op) && i + 1 != block.code.size()) {
+					fail("terminator in the middle of b"s + to_string(b));
+				}
+				if (instruction.op == Opcode::Phi) {
+					if (!phis) {
+						fail("phi after non-phi in b"s + to_string(b));
+					}
+					if (instruction.operands.size() != block.preds.size()) {
+						fail("phi v"s + to_string(block.code[i]) + " does not match predecessors"s);
+					}
+				}
+				else {
+					phis = false;
+				}
+				for (const ValueId operand : instruction.operands) {
+					const Instruction& definition = function.values.at(operand);
+					if (definition.op == Opcode::Nop || function.blocks[definition.block].code.empty()) {
+						fail("v"s + to_string(block.code[i]) + " uses removed v"s + to_string(operand));
+					}
+				}
+			}
+			for (const BlockId successor : function.GetSuccessors(b)) {
+				const auto& preds = function.blocks[successor].preds;
+				if (function.blocks[successor].code.empty() || find(preds.begin(), preds.end(), b) == preds.end()) {
+					fail("edge b"s + to_string(b) + " -> b"s + to_string(successor) + " is not recorded"s);
+				}
+			}
+		}
+	}
+
+	void Print(const Function& function, ostream& out) {
+		out << "function "sv << function.name << '\n';
+		for (BlockId b = 0; b < function.blocks.size(); ++b) {
+			const Block& block = function.blocks[b];
+			if (block.code.empty()) {
+				continue;
+			}
+			out << 'b' << b << ':';
+			if (!block.preds.empty()) {
+				out << " ; preds"sv;
+				for (const BlockId pred : block.preds) {
+					out << " b"sv << pred;
+				}
+			}
+			if (b == function.loop_header) {
+				out << " ; loop header"sv;
+			}
+			out << '\n';
+			for (const ValueId id : block.code) {
+				const Instruction& instruction = function.values[id];
+				out << "  "sv;
+				if (!IsTerminator(instruction.op) && instruction.op != Opcode::StoreField && instruction.op != Opcode::Print) {
+					out << 'v' << id << " = "sv;
+				}
+				out << ToString(instruction.op);
+				switch (instruction.op) {
+				case Opcode::Const:
+					out << ' ';
+					PrintConstant(instruction.constant, out);
+					break;
+				case Opcode::Param:
+					out << ' ' << instruction.name;
+					break;
+				case Opcode::Compare:
+					out << ' ' << ToString(instruction.compare_op);
+					break;
+				case Opcode::New:
+					out << ' ' << instruction.new_instance->GetClass().GetName();
+					break;
+				case Opcode::ResolveMethod:
+					out << ' ' << instruction.name << '/' << instruction.index;
+					break;
+				default:
+					if (!instruction.name.empty()) {
+						out << ' ' << instruction.name;
+					}
+					break;
+				}
+				for (size_t i = 0; i < instruction.operands.size(); ++i) {
+					out << (i == 0 ? " "sv : ", "sv) << 'v' << instruction.operands[i];
+					if (instruction.op == Opcode::Phi) {
+						out << ":b"sv << block.preds[i];
+					}
+				}
+				for (const BlockId target : instruction.targets) {
+					if (target != NO_BLOCK) {
+						out << " -> b"sv << target;
+					}
+				}
+				out << '\n';
+			}
+		}
+	}
+
+	CompiledMethod::CompiledMethod(unique_ptr<Function> function)
+		: function_(std::move(function)) {
+	}
+
+	ObjectHolder CompiledMethod::Execute(runtime::Closure& closure, runtime::Context& context) {
+		const Function& f = *function_;
+		vector<ObjectHolder> values(f.values.size());
+		vector<ObjectHolder> args;
+		BlockId block = f.entry;
+		BlockId prev = NO_BLOCK;
+		while (true) {
+			const Block& b = f.blocks[block];
+			size_t i = 0;
+			if (prev != NO_BLOCK) {
+				const size_t pred = static_cast<size_t>(find(b.preds.begin(), b.preds.end(), prev) - b.preds.begin());
+				// Все phi блока получают значения одновременно
+				phi_values_.clear();
+				for (; i < b.code.size() && f.values[b.code[i]].op == Opcode::Phi; ++i) {
+					phi_values_.push_back(values[f.values[b.code[i]].operands[pred]]);
+				}
+				for (size_t j = 0; j < phi_values_.size(); ++j) {
+					values[b.code[j]] = std::move(phi_values_[j]);
+				}
+				if (block == f.loop_header && prev != f.entry) {
+					++f.method->profile.calls;
+				}
+			}
+			prev = block;
+			for (; i < b.code.size(); ++i) {
+				const ValueId id = b.code[i];
+				const Instruction& instruction = f.values[id];
+				const auto& operands = instruction.operands;
+				auto operand = [&values, &operands](size_t k) -> const ObjectHolder& {
+					return values[operands[k]];
+				};
+				switch (instruction.op) {
+				case Opcode::Const:
+					values[id] = instruction.constant;
+					break;
+				case Opcode::Undef:
+					values[id] = Undefined();
+					break;
+				case Opcode::Param:
+					values[id] = closure.at(instruction.name);
+					break;
+				case Opcode::Phi:
+				case Opcode::Nop:
+					break;
+				case Opcode::CheckDefined:
+					if (IsUndefined(operand(0))) {
+						throw std::runtime_error("Variable "s + instruction.name + " not found"s);
+					}
+					values[id] = operand(0);
+					break;
+				case Opcode::IsInstance:
+					values[id] = MakeBool(operand(0).GetType() == runtime::ObjectType::ClassInstance);
+					break;
+				case Opcode::LoadField:
+					values[id] = LoadField(operand(0), instruction);
+					break;
+				case Opcode::TryLoadField: {
+					const ObjectHolder* value = nullptr;
+					if (auto* instance = operand(0).TryAs<runtime::ClassInstance>()) {
+						value = FindField(*instance, instruction.name);
+					}
+					values[id] = value ? *value : Undefined();
+					break;
+				}
+				case Opcode::CheckLoad:
+					values[id] = IsUndefined(operand(0)) ? LoadField(operand(1), instruction) : operand(0);
+					break;
+				case Opcode::StoreField:
+					operand(0).TryAs<runtime::ClassInstance>()->Fields()[instruction.name] = operand(1);
+					break;
+				case Opcode::Add:
+					values[id] = Add(operand(0), operand(1), context);
+					break;
+				case Opcode::Sub:
+				case Opcode::Mult:
+				case Opcode::Div:
+					values[id] = Arithmetic(instruction.op, operand(0), operand(1));
+					break;
+				case Opcode::Compare:
+					values[id] = MakeBool(runtime::Compare(instruction.compare_op, operand(0), operand(1), context));
+					break;
+				case Opcode::Not:
+					values[id] = MakeBool(!runtime::IsTrue(operand(0)));
+					break;
+				case Opcode::Truth:
+					values[id] = MakeBool(runtime::IsTrue(operand(0)));
+					break;
+				case Opcode::Stringify:
+					values[id] = Stringify(operand(0), context);
+					break;
+				case Opcode::ResolveMethod:
+					values[id] = MakeBool(ResolveMethod(operand(0), instruction.name, instruction.index) == f.method);
+					break;
+				case Opcode::Call:
+				case Opcode::TailCall: {
+					const runtime::Method* method = ResolveMethod(operand(0), instruction.name, operands.size() - 1);
+					args.resize(operands.size() - 1);
+					for (size_t k = 1; k < operands.size(); ++k) {
+						args[k - 1] = operand(k);
+					}
+					if (!method) {
+						values[id] = runtime::CallBuiltinMethod(operand(0), instruction.name, args);
+						if (instruction.op == Opcode::TailCall) {
+							return values[id];
+						}
+					}
+					else if (instruction.op == Opcode::TailCall) {
+						context.SetTailCall(operand(0), *method, args);
+						return ObjectHolder::None();
+					}
+					else {
+						values[id] = operand(0).TryAs<runtime::ClassInstance>()->Call(*method, args, context);
+					}
+					break;
+				}
+				case Opcode::New:
+					args.resize(operands.size());
+					for (size_t k = 0; k < operands.size(); ++k) {
+						args[k] = operand(k);
+					}
+					values[id] = instruction.new_instance->Construct(args, context);
+					break;
+				case Opcode::Print: {
+					string line;
+					for (size_t k = 0; k < operands.size(); ++k) {
+						if (k > 0) {
+							line += ' ';
+						}
+						line += operand(k).TryAs<runtime::String>()->GetValue();
+					}
+					line += '\n';
+					context.GetOutputStream() << line;
+					break;
+				}
+				case Opcode::Jump:
+					block = instruction.targets[0];
+					break;
+				case Opcode::Branch:
+					block = instruction.targets[runtime::IsTrue(operand(0)) ? 0 : 1];
+					break;
+				case Opcode::Return:
+					return operand(0);
+				}
+			}
+		}
+	}
+
+	void DumpProgram(const ast::Statement& program, ostream& out) {
+		ForEachMethod(program, [&out](const runtime::Class& cls, const runtime::Method& method) {
+			unique_ptr<Function> function = Lower(cls, method);
+			if (!function) {
+				out << "; "sv << cls.GetName() << '.' << method.name << ": not supported\n"sv;
+				return;
+			}
+			const OptimizationStats stats = Optimize(*function);
+			out << "; folded "sv << stats.folded << ", redundant "sv << stats.redundant
+				<< ", loads forwarded "sv << stats.loads_forwarded << ", dead stores "sv << stats.dead_stores
+				<< ", dead code "sv << stats.dead_code << ", hoisted "sv << stats.hoisted << '\n';
+			Print(*function, out);
+		});
+	}
+
+	void InstallProgram(const ast::Statement& program) {
+		ForEachMethod(program, [](const runtime::Class& cls, const runtime::Method& method) {
+			auto* body = dynamic_cast<ast::MethodBody*>(method.body.get());
+			unique_ptr<Function> function = body ? Lower(cls, method) : nullptr;
+			if (!function) {
+				return;
+			}
+			Optimize(*function);
+			body->SetOptimized(make_unique<CompiledMethod>(std::move(function)));
+		});
+	}
+
+}  // namespace ir
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "statement.h"
+
+#include <array>
+#include <limits>
+#include <ostream>
+
+namespace ir {
+
+	// Номер значения SSA, он же номер вычисляющей его инструкции в Function::values
+	using ValueId = uint32_t;
+	// Номер базового блока в Function::blocks
+	using BlockId = uint32_t;
+
+	inline constexpr ValueId NO_VALUE = std::numeric_limits<ValueId>::max();
+	inline constexpr BlockId NO_BLOCK = std::numeric_limits<BlockId>::max();
+
+	// Операции IR. Каждая инструкция, кроме терминаторов, вычисляет одно значение
+	enum class Opcode : uint8_t {
+		Const,          // константа constant
+		Undef,          // значение ещё не присвоенной локальной переменной
+		Param,          // параметр name с номером index: 0 - self, далее формальные параметры
+		Phi,            // operands[i] приходит из блока preds[i]
+		CheckDefined,   // operands[0]; если переменная name не присвоена, выбрасывает runtime_error
+		IsInstance,     // True, если operands[0] - экземпляр класса
+		LoadField,      // поле name объекта operands[0]; owner - имя объекта для сообщения об ошибке
+		TryLoadField,   // как LoadField, но вместо ошибки возвращает неприсвоенное значение
+		CheckLoad,      // operands[0], если оно присвоено, иначе LoadField объекта operands[1]
+		StoreField,     // operands[0].name = operands[1], operands[0] - экземпляр класса
+		Add,
+		Sub,
+		Mult,
+		Div,
+		Compare,        // operands[0] <compare_op> operands[1]
+		Not,
+		Truth,          // Bool(IsTrue(operands[0]))
+		Stringify,      // строковое представление operands[0], как у str() и print
+		ResolveMethod,  // проверяет наличие метода name с index параметрами у operands[0];
+		                // True, если найден сам компилируемый метод
+		Call,           // operands[0].name(operands[1..])
+		New,            // new_instance->Construct(operands)
+		Print,          // выводит строки operands через пробел и перевод строки
+		// Терминаторы
+		Jump,           // переход в targets[0]
+		Branch,         // переход в targets[0], если IsTrue(operands[0]), иначе в targets[1]
+		Return,         // возврат operands[0]
+		TailCall,       // хвостовой вызов operands[0].name(operands[1..])
+		Nop,            // удалённая инструкция
+	};
+
+	[[nodiscard]] inline bool IsTerminator(Opcode op) {
+		return op == Opcode::Jump || op == Opcode::Branch || op == Opcode::Return || op == Opcode::TailCall;
+	}
+
+	struct Instruction {
+		Opcode op = Opcode::Nop;
+		// Блок, в котором находится инструкция
+		BlockId block = NO_BLOCK;
+		std::vector<ValueId> operands;
+		// Блоки-преемники терминатора
+		std::array<BlockId, 2> targets = { NO_BLOCK, NO_BLOCK };
+		// Имя переменной, поля или метода
+		std::string name;
+		// Имя объекта, поле которого читает LoadField
+		std::string owner;
+		runtime::ObjectHolder constant;
+		runtime::CompareOp compare_op = runtime::CompareOp::Equal;
+		size_t index = 0;
+		const ast::NewInstance* new_instance = nullptr;
+	};
+
+	struct Block {
+		std::vector<BlockId> preds;
+		// Сначала phi, последним - терминатор. Пустой список означает удалённый блок
+		std::vector<ValueId> code;
+	};
+
+	/*
+	Метод в представлении SSA. Блок entry вычисляет параметры и константы и переходит в
+	loop_header, с которого начинается тело метода. Хвостовой вызов return obj.m(args),
+	который во время выполнения оказывается вызовом самого метода, становится переходом
+	в loop_header, так что рекурсия превращается в цикл
+	*/
+	struct Function {
+		const runtime::Method* method = nullptr;
+		// Имя метода вида Class.method
+		std::string name;
+		std::vector<Instruction> values;
+		std::vector<Block> blocks;
+		BlockId entry = 0;
+		BlockId loop_header = NO_BLOCK;
+
+		// Возвращает номера блоков, в которые передаёт управление блок block
+		[[nodiscard]] std::vector<BlockId> GetSuccessors(BlockId block) const;
+	};
+
+	// Строит IR метода method класса cls. Если тело содержит неподдерживаемые узлы, возвращает nullptr
+	std::unique_ptr<Function> Lower(const runtime::Class& cls, const runtime::Method& method);
+
+	// Проверяет согласованность IR. При нарушении выбрасывает logic_error
+	void Verify(const Function& function);
+
+	// Выводит IR в текстовом виде
+	void Print(const Function& function, std::ostream& out);
+
+	// Результаты оптимизации: сколько инструкций удалено или перемещено каждым проходом
+	struct OptimizationStats {
+		// Вычислено во время компиляции (константы, проверки по типам, ветвления)
+		size_t folded = 0;
+		// Заменено ранее вычисленным значением (GVN)
+		size_t redundant = 0;
+		// Повторные чтения полей, заменённые ранее прочитанным или записанным значением
+		size_t loads_forwarded = 0;
+		// Записи полей, перезаписываемые до следующего чтения
+		size_t dead_stores = 0;
+		// Инструкции, результат которых не используется
+		size_t dead_code = 0;
+		// Инструкции, вынесенные из цикла
+		size_t hoisted = 0;
+	};
+
+	/*
+	Оптимизирует функцию:
+	  - упрощение по выведенным типам значений и свёртка констант, в том числе ветвлений;
+	  - нумерация значений по дереву доминаторов (GVN) и удаление повторных чтений полей;
+	  - удаление мёртвых записей полей и мёртвого кода;
+	  - вынос инвариантов из цикла, полученного из хвостовой рекурсии (LICM). Чтения полей
+	    выносятся как TryLoadField, а на их месте остаётся дешёвая проверка CheckLoad.
+	Инструкции, которые могут вызвать методы Mython, считаются читающими и изменяющими все поля
+	*/
+	OptimizationStats Optimize(Function& function);
+
+	/*
+	Исполнитель оптимизированного IR. Подключается к телу метода через ast::MethodBody::SetOptimized
+	и выполняется в кадре, подготовленном ClassInstance::Call: из кадра читаются только self и параметры
+	*/
+	class CompiledMethod : public runtime::Executable {
+	public:
+		explicit CompiledMethod(std::unique_ptr<Function> function);
+
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const Function& GetFunction() const {
+			return *function_;
+		}
+
+	private:
+		std::unique_ptr<Function> function_;
+		std::vector<runtime::ObjectHolder> phi_values_;
+	};
+
+	// Строит и оптимизирует IR всех методов классов программы и выводит его в out
+	void DumpProgram(const ast::Statement& program, std::ostream& out);
+
+	// Строит и оптимизирует IR всех методов классов программы и подключает его к телам методов
+	void InstallProgram(const ast::Statement& program);
+
+}  // namespace ir
@@ -0,0 +1,887 @@
+#include "ir.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+namespace ir {
+
+	using runtime::ObjectHolder;
+
+	namespace {
+
+		// Множество типов, которые может иметь значение, - объединение битов
+		using TypeMask = uint8_t;
+		constexpr TypeMask NONE_TYPE = 1u << 0u;
+		constexpr TypeMask NUMBER_TYPE = 1u << 1u;
+		constexpr TypeMask STRING_TYPE = 1u << 2u;
+		constexpr TypeMask BOOL_TYPE = 1u << 3u;
+		constexpr TypeMask INSTANCE_TYPE = 1u << 4u;
+		constexpr TypeMask OTHER_TYPE = 1u << 5u;
+		// Неприсвоенная переменная
+		constexpr TypeMask UNDEF_TYPE = 1u << 6u;
+		constexpr TypeMask DEFINED_TYPES = NONE_TYPE | NUMBER_TYPE | STRING_TYPE | BOOL_TYPE | INSTANCE_TYPE | OTHER_TYPE;
+		constexpr TypeMask ANY_TYPE = DEFINED_TYPES | UNDEF_TYPE;
+		// Типы, сравнение и вывод которых могут вызвать методы Mython: экземпляры классов
+		// и прочие объекты, например списки экземпляров
+		constexpr TypeMask CALLING_TYPES = INSTANCE_TYPE | OTHER_TYPE;
+
+		// Возвращает true, если значение типа mask всегда имеет тип type. Пустая маска означает,
+		// что значение ещё не вычислено или никогда не вычисляется
+		bool IsOnly(TypeMask mask, TypeMask type) {
+			return (mask & ~type) == 0;
+		}
+
+		TypeMask TypeOf(const ObjectHolder& value) {
+			switch (value.GetType()) {
+			case runtime::ObjectType::None:
+				return NONE_TYPE;
+			case runtime::ObjectType::Number:
+				return NUMBER_TYPE;
+			case runtime::ObjectType::String:
+				return STRING_TYPE;
+			case runtime::ObjectType::Bool:
+				return BOOL_TYPE;
+			case runtime::ObjectType::ClassInstance:
+				return INSTANCE_TYPE;
+			default:
+				return OTHER_TYPE;
+			}
+		}
+
+		// Побочные эффекты инструкции
+		struct Effects {
+			bool reads_fields = false;
+			bool writes_fields = false;
+			bool output = false;
+			// Может вызвать метод Mython, то есть прочитать и изменить любые поля и вывести текст
+			bool calls = false;
+			bool may_throw = false;
+
+			[[nodiscard]] bool IsPure() const {
+				return !reads_fields && !writes_fields && !output && !calls;
+			}
+
+			// Инструкцию без использований можно удалить
+			[[nodiscard]] bool IsRemovable() const {
+				return IsPure() && !may_throw;
+			}
+		};
+
+		// Вычисляет операцию над константами так же, как исполнитель. Возвращает nullopt,
+		// если результат нельзя получить без выполнения программы
+		optional<ObjectHolder> FoldConstants(const Instruction& instruction, const vector<ObjectHolder>& args) {
+			runtime::DummyContext context;
+			const auto* l = args.empty() ? nullptr : args[0].TryAs<runtime::Number>();
+			const auto* r = args.size() < 2 ? nullptr : args[1].TryAs<runtime::Number>();
+			int result = 0;
+			switch (instruction.op) {
+			case Opcode::Add:
+				if (l && r && !__builtin_add_overflow(l->GetValue(), r->GetValue(), &result)) {
+					return ObjectHolder::Own(runtime::Number(result));
+				}
+				if (const auto* ls = args[0].TryAs<runtime::String>()) {
+					if (const auto* rs = args[1].TryAs<runtime::String>()) {
+						return ObjectHolder::Own(runtime::String(ls->GetValue() + rs->GetValue()));
+					}
+				}
+				return nullopt;
+			case Opcode::Sub:
+				if (l && r && !__builtin_sub_overflow(l->GetValue(), r->GetValue(), &result)) {
+					return ObjectHolder::Own(runtime::Number(result));
+				}
+				return nullopt;
+			case Opcode::Mult:
+				if (l && r && !__builtin_mul_overflow(l->GetValue(), r->GetValue(), &result)) {
+					return ObjectHolder::Own(runtime::Number(result));
+				}
+				return nullopt;
+			case Opcode::Div:
+				if (l && r && r->GetValue() != 0 && !(r->GetValue() == -1 && l->GetValue() == numeric_limits<int>::min())) {
+					return ObjectHolder::Own(runtime::Number(l->GetValue() / r->GetValue()));
+				}
+				return nullopt;
+			case Opcode::Compare: {
+				const TypeMask lhs = TypeOf(args[0]);
+				if (lhs == TypeOf(args[1]) && (lhs == NUMBER_TYPE || lhs == STRING_TYPE || lhs == BOOL_TYPE)) {
+					return ObjectHolder::Own(runtime::Bool(runtime::Compare(instruction.compare_op, args[0], args[1], context)));
+				}
+				return nullopt;
+			}
+			case Opcode::Not:
+				return ObjectHolder::Own(runtime::Bool(!runtime::IsTrue(args[0])));
+			case Opcode::Truth:
+				return ObjectHolder::Own(runtime::Bool(runtime::IsTrue(args[0])));
+			case Opcode::IsInstance:
+				return ObjectHolder::Own(runtime::Bool(args[0].GetType() == runtime::ObjectType::ClassInstance));
+			case Opcode::Stringify: {
+				if (args[0].GetType() == runtime::ObjectType::String) {
+					return args[0];
+				}
+				ostringstream os;
+				if (args[0]) {
+					args[0]->Print(os, context);
+				}
+				else {
+					os << "None"sv;
+				}
+				return ObjectHolder::Own(runtime::String(os.str()));
+			}
+			default:
+				return nullopt;
+			}
+		}
+
+		class Optimizer {
+		public:
+			explicit Optimizer(Function& function)
+				: f_(function) {
+			}
+
+			OptimizationStats Run() {
+				// Второй круг использует возможности, открытые первым: удалённые записи и ветвления
+				for (int round = 0; round < 2; ++round) {
+					Simplify();
+					NumberValues();
+					EliminateDeadStores();
+					EliminateDeadCode();
+				}
+				HoistLoopInvariants();
+				Simplify();
+				NumberValues();
+				EliminateDeadCode();
+				return stats_;
+			}
+
+		private:
+			// Вспомогательные операции над IR
+
+			void Remove(ValueId id) {
+				Instruction& instruction = f_.values[id];
+				auto& code = f_.blocks[instruction.block].code;
+				code.erase(find(code.begin(), code.end(), id));
+				instruction.op = Opcode::Nop;
+				instruction.operands.clear();
+			}
+
+			void ReplaceAllUses(ValueId from, ValueId to) {
+				for (Instruction& instruction : f_.values) {
+					replace(instruction.operands.begin(), instruction.operands.end(), from, to);
+				}
+			}
+
+			void Replace(ValueId id, ValueId replacement) {
+				ReplaceAllUses(id, replacement);
+				Remove(id);
+			}
+
+			// Перемещает инструкцию в конец блока block перед его терминатором
+			void MoveToEnd(ValueId id, BlockId block) {
+				auto& from = f_.blocks[f_.values[id].block].code;
+				from.erase(find(from.begin(), from.end(), id));
+				auto& to = f_.blocks[block].code;
+				to.insert(to.end() - 1, id);
+				f_.values[id].block = block;
+			}
+
+			// Удаляет одно ребро pred -> block вместе с соответствующими операндами phi
+			void RemoveEdge(BlockId pred, BlockId block) {
+				auto& preds = f_.blocks[block].preds;
+				const auto it = find(preds.begin(), preds.end(), pred);
+				const auto index = it - preds.begin();
+				preds.erase(it);
+				for (const ValueId id : f_.blocks[block].code) {
+					Instruction& instruction = f_.values[id];
+					if (instruction.op != Opcode::Phi) {
+						break;
+					}
+					instruction.operands.erase(instruction.operands.begin() + index);
+				}
+			}
+
+			// Анализ
+
+			void ComputeOrder() {
+				rpo_.clear();
+				vector<bool> visited(f_.blocks.size());
+				vector<BlockId> postorder;
+				// Обход в глубину без рекурсии: в стеке - блок и номер следующего преемника
+				vector<pair<BlockId, size_t>> stack = { { f_.entry, 0u } };
+				visited[f_.entry] = true;
+				while (!stack.empty()) {
+					auto& [block, next] = stack.back();
+					const vector<BlockId> successors = f_.GetSuccessors(block);
+					if (next < successors.size()) {
+						const BlockId successor = successors[next++];
+						if (!visited[successor]) {
+							visited[successor] = true;
+							stack.emplace_back(successor, 0u);
+						}
+					}
+					else {
+						postorder.push_back(block);
+						stack.pop_back();
+					}
+				}
+				rpo_.assign(postorder.rbegin(), postorder.rend());
+				rpo_index_.assign(f_.blocks.size(), NO_BLOCK);
+				for (size_t i = 0; i < rpo_.size(); ++i) {
+					rpo_index_[rpo_[i]] = static_cast<BlockId>(i);
+				}
+			}
+
+			// Дерево доминаторов по алгоритму Cooper, Harvey, Kennedy. Требует ComputeOrder
+			void ComputeDominators() {
+				idom_.assign(f_.blocks.size(), NO_BLOCK);
+				idom_[f_.entry] = f_.entry;
+				auto intersect = [this](BlockId a, BlockId b) {
+					while (a != b) {
+						while (rpo_index_[a] > rpo_index_[b]) {
+							a = idom_[a];
+						}
+						while (rpo_index_[b] > rpo_index_[a]) {
+							b = idom_[b];
+						}
+					}
+					return a;
+				};
+				for (bool changed = true; changed;) {
+					changed = false;
+					for (const BlockId block : rpo_) {
+						if (block == f_.entry) {
+							continue;
+						}
+						BlockId new_idom = NO_BLOCK;
+						for (const BlockId pred : f_.blocks[block].preds) {
+							if (idom_[pred] == NO_BLOCK) {
+								continue;
+							}
+							new_idom = new_idom == NO_BLOCK ? pred : intersect(pred, new_idom);
+						}
+						if (idom_[block] != new_idom) {
+							idom_[block] = new_idom;
+							changed = true;
+						}
+					}
+				}
+				dom_children_.assign(f_.blocks.size(), {});
+				for (const BlockId block : rpo_) {
+					if (block != f_.entry) {
+						dom_children_[idom_[block]].push_back(block);
+					}
+				}
+			}
+
+			TypeMask GetType(ValueId id) const {
+				return id < types_.size() ? types_[id] : ANY_TYPE;
+			}
+
+			TypeMask InferType(const Instruction& instruction) const {
+				auto operand_type = [this, &instruction](size_t i) {
+					return GetType(instruction.operands[i]);
+				};
+				switch (instruction.op) {
+				case Opcode::Const:
+					return TypeOf(instruction.constant);
+				case Opcode::Undef:
+					return UNDEF_TYPE;
+				case Opcode::Param:
+					return instruction.index == 0 ? INSTANCE_TYPE : DEFINED_TYPES;
+				case Opcode::Phi: {
+					TypeMask type = 0;
+					for (const ValueId operand : instruction.operands) {
+						type |= GetType(operand);
+					}
+					return type;
+				}
+				case Opcode::CheckDefined:
+					return operand_type(0) & ~UNDEF_TYPE;
+				case Opcode::IsInstance:
+				case Opcode::Compare:
+				case Opcode::Not:
+				case Opcode::Truth:
+				case Opcode::ResolveMethod:
+					return BOOL_TYPE;
+				case Opcode::LoadField:
+				case Opcode::CheckLoad:
+				case Opcode::Call:
+					return DEFINED_TYPES;
+				case Opcode::TryLoadField:
+					return ANY_TYPE;
+				case Opcode::Add:
+					if (IsOnly(operand_type(0), NUMBER_TYPE) && IsOnly(operand_type(1), NUMBER_TYPE)) {
+						return NUMBER_TYPE;
+					}
+					if (IsOnly(operand_type(0), STRING_TYPE) && IsOnly(operand_type(1), STRING_TYPE)) {
+						return STRING_TYPE;
+					}
+					return DEFINED_TYPES;
+				case Opcode::Sub:
+				case Opcode::Mult:
+				case Opcode::Div:
+					return NUMBER_TYPE;
+				case Opcode::Stringify:
+					return STRING_TYPE;
+				case Opcode::New:
+					return INSTANCE_TYPE;
+				default:
+					return 0;
+				}
+			}
+
+			// Выводит типы значений. Начинает с пустых масок и расширяет их до неподвижной точки
+			void ComputeTypes() {
+				types_.assign(f_.values.size(), 0);
+				for (bool changed = true; changed;) {
+					changed = false;
+					for (const BlockId block : rpo_) {
+						for (const ValueId id : f_.blocks[block].code) {
+							const TypeMask type = InferType(f_.values[id]);
+							if (type != types_[id]) {
+								types_[id] = type;
+								changed = true;
+							}
+						}
+					}
+				}
+			}
+
+			Effects GetEffects(const Instruction& instruction) const {
+				Effects effects;
+				auto operand_type = [this, &instruction](size_t i) {
+					return GetType(instruction.operands[i]);
+				};
+				auto both = [&operand_type](TypeMask type) {
+					return IsOnly(operand_type(0), type) && IsOnly(operand_type(1), type);
+				};
+				switch (instruction.op) {
+				case Opcode::CheckDefined:
+					effects.may_throw = (operand_type(0) & UNDEF_TYPE) != 0;
+					break;
+				case Opcode::LoadField:
+				case Opcode::CheckLoad:
+					effects.reads_fields = true;
+					effects.may_throw = true;
+					break;
+				case Opcode::TryLoadField:
+					effects.reads_fields = true;
+					break;
+				case Opcode::StoreField:
+					effects.writes_fields = true;
+					break;
+				case Opcode::Add:
+					if (!both(NUMBER_TYPE) && !both(STRING_TYPE)) {
+						effects.calls = (operand_type(0) & INSTANCE_TYPE) != 0;
+						effects.may_throw = true;
+					}
+					break;
+				case Opcode::Sub:
+				case Opcode::Mult:
+					effects.may_throw = !both(NUMBER_TYPE);
+					break;
+				case Opcode::Div: {
+					const Instruction& divisor = f_.values[instruction.operands[1]];
+					const bool safe_divisor = divisor.op == Opcode::Const && divisor.constant.TryAs<runtime::Number>()
+						&& divisor.constant.TryAs<runtime::Number>()->GetValue() > 0;
+					effects.may_throw = !both(NUMBER_TYPE) || !safe_divisor;
+					break;
+				}
+				case Opcode::Compare:
+					if (((operand_type(0) | operand_type(1)) & CALLING_TYPES) != 0) {
+						effects.calls = true;
+						effects.may_throw = true;
+					}
+					else {
+						effects.may_throw = !both(NUMBER_TYPE) && !both(STRING_TYPE) && !both(BOOL_TYPE);
+					}
+					break;
+				case Opcode::Stringify:
+					effects.calls = (operand_type(0) & CALLING_TYPES) != 0;
+					effects.may_throw = effects.calls;
+					break;
+				case Opcode::ResolveMethod:
+					effects.may_throw = true;
+					break;
+				case Opcode::Call:
+				case Opcode::New:
+					effects.calls = true;
+					effects.may_throw = true;
+					break;
+				case Opcode::Print:
+					effects.output = true;
+					break;
+				default:
+					break;
+				}
+				return effects;
+			}
+
+			// Упрощение по типам, свёртка констант и ветвлений, очистка графа
+
+			void Simplify() {
+				ComputeOrder();
+				ComputeTypes();
+				for (const BlockId block : rpo_) {
+					for (const ValueId id : vector<ValueId>(f_.blocks[block].code)) {
+						SimplifyInstruction(id);
+					}
+				}
+				RemoveUnreachableBlocks();
+				RemoveTrivialPhis();
+				MergeBlocks();
+			}
+
+			void SimplifyInstruction(ValueId id) {
+				Instruction& instruction = f_.values[id];
+				if (instruction.op == Opcode::CheckDefined && (GetType(instruction.operands[0]) & UNDEF_TYPE) == 0) {
+					++stats_.folded;
+					Replace(id, instruction.operands[0]);
+					return;
+				}
+				if (instruction.op == Opcode::Stringify && IsOnly(GetType(instruction.operands[0]), STRING_TYPE)) {
+					++stats_.folded;
+					Replace(id, instruction.operands[0]);
+					return;
+				}
+				if (instruction.op == Opcode::IsInstance) {
+					const TypeMask type = GetType(instruction.operands[0]);
+					if (type == INSTANCE_TYPE || (type != 0 && (type & INSTANCE_TYPE) == 0)) {
+						FoldTo(id, ObjectHolder::Own(runtime::Bool(type == INSTANCE_TYPE)));
+						return;
+					}
+				}
+				if (instruction.op == Opcode::Branch) {
+					const Instruction& condition = f_.values[instruction.operands[0]];
+					if (condition.op == Opcode::Const) {
+						const bool taken = runtime::IsTrue(condition.constant);
+						const BlockId target = instruction.targets[taken ? 0 : 1];
+						const BlockId other = instruction.targets[taken ? 1 : 0];
+						instruction.op = Opcode::Jump;
+						instruction.operands.clear();
+						instruction.targets = { target, NO_BLOCK };
+						RemoveEdge(instruction.block, other);
+						++stats_.folded;
+					}
+					return;
+				}
+				if (instruction.operands.empty() || instruction.op == Opcode::Phi || IsTerminator(instruction.op)) {
+					return;
+				}
+				vector<ObjectHolder> args;
+				for (const ValueId operand : instruction.operands) {
+					const Instruction& definition = f_.values[operand];
+					if (definition.op != Opcode::Const) {
+						return;
+					}
+					args.push_back(definition.constant);
+				}
+				if (optional<ObjectHolder> value = FoldConstants(instruction, args)) {
+					FoldTo(id, std::move(*value));
+				}
+			}
+
+			// Заменяет инструкцию константой на её месте
+			void FoldTo(ValueId id, ObjectHolder value) {
+				Instruction& instruction = f_.values[id];
+				instruction.op = Opcode::Const;
+				instruction.operands.clear();
+				instruction.name.clear();
+				instruction.constant = std::move(value);
+				types_[id] = TypeOf(instruction.constant);
+				++stats_.folded;
+			}
+
+			void RemoveUnreachableBlocks() {
+				ComputeOrder();
+				for (BlockId block = 0; block < f_.blocks.size(); ++block) {
+					if (rpo_index_[block] != NO_BLOCK || f_.blocks[block].code.empty()) {
+						continue;
+					}
+					for (const BlockId successor : f_.GetSuccessors(block)) {
+						if (rpo_index_[successor] != NO_BLOCK) {
+							RemoveEdge(block, successor);
+						}
+					}
+					for (const ValueId id : f_.blocks[block].code) {
+						f_.values[id].op = Opcode::Nop;
+						f_.values[id].operands.clear();
+					}
+					f_.blocks[block].code.clear();
+					f_.blocks[block].preds.clear();
+				}
+				if (f_.loop_header != NO_BLOCK && f_.blocks[f_.loop_header].code.empty()) {
+					f_.loop_header = NO_BLOCK;
+				}
+			}
+
+			// Удаляет phi, все операнды которых, кроме самой phi, совпадают
+			void RemoveTrivialPhis() {
+				for (bool changed = true; changed;) {
+					changed = false;
+					for (Block& block : f_.blocks) {
+						for (const ValueId id : vector<ValueId>(block.code)) {
+							const Instruction& phi = f_.values[id];
+							if (phi.op != Opcode::Phi) {
+								break;
+							}
+							ValueId same = NO_VALUE;
+							bool trivial = true;
+							for (const ValueId operand : phi.operands) {
+								if (operand == id || operand == same) {
+									continue;
+								}
+								if (same != NO_VALUE) {
+									trivial = false;
+									break;
+								}
+								same = operand;
+							}
+							if (trivial && same != NO_VALUE) {
+								Replace(id, same);
+								changed = true;
+							}
+						}
+					}
+				}
+			}
+
+			// Присоединяет блок к единственному предшественнику, если тот безусловно переходит в него
+			void MergeBlocks() {
+				for (bool changed = true; changed;) {
+					changed = false;
+					for (BlockId block = 0; block < f_.blocks.size(); ++block) {
+						auto& code = f_.blocks[block].code;
+						if (code.empty() || f_.values[code.back()].op != Opcode::Jump) {
+							continue;
+						}
+						const BlockId successor = f_.values[code.back()].targets[0];
+						Block& next = f_.blocks[successor];
+						if (successor == block || successor == f_.entry || next.preds.size() != 1u
+							|| f_.values[next.code.front()].op == Opcode::Phi) {
+							continue;
+						}
+						Remove(code.back());
+						for (const ValueId id : next.code) {
+							f_.values[id].block = block;
+						}
+						code.insert(code.end(), next.code.begin(), next.code.end());
+						next.code.clear();
+						next.preds.clear();
+						for (const BlockId target : f_.GetSuccessors(block)) {
+							replace(f_.blocks[target].preds.begin(), f_.blocks[target].preds.end(), successor, block);
+						}
+						if (f_.loop_header == successor) {
+							f_.loop_header = NO_BLOCK;
+						}
+						changed = true;
+					}
+				}
+			}
+
+			// Нумерация значений по дереву доминаторов
+
+			// Ключ чистой инструкции: совпадающие ключи означают равные значения
+			string KeyOf(const Instruction& instruction) const {
+				ostringstream key;
+				key << static_cast<int>(instruction.op) << '|' << static_cast<int>(instruction.compare_op)
+					<< '|' << instruction.index << '|';
+				if (instruction.op != Opcode::CheckDefined) {
+					key << instruction.name;
+				}
+				key << '|';
+				if (instruction.op == Opcode::Const) {
+					key << static_cast<int>(instruction.constant.GetType()) << ':';
+					if (instruction.constant) {
+						runtime::DummyContext context;
+						instruction.constant->Print(key, context);
+					}
+				}
+				vector<ValueId> operands = instruction.operands;
+				const bool numbers = operands.size() == 2u && IsOnly(GetType(operands[0]), NUMBER_TYPE)
+					&& IsOnly(GetType(operands[1]), NUMBER_TYPE);
+				const bool commutative = instruction.op == Opcode::Add || instruction.op == Opcode::Mult
+					|| (instruction.op == Opcode::Compare && (instruction.compare_op == runtime::CompareOp::Equal
+						|| instruction.compare_op == runtime::CompareOp::NotEqual));
+				if (numbers && commutative) {
+					sort(operands.begin(), operands.end());
+				}
+				for (const ValueId operand : operands) {
+					key << 'v' << operand;
+				}
+				return key.str();
+			}
+
+			using Memory = map<pair<ValueId, string>, ValueId>;
+
+			void NumberValues() {
+				ComputeOrder();
+				ComputeTypes();
+				ComputeDominators();
+				available_.clear();
+				NumberValues(f_.entry, {});
+			}
+
+			void NumberValues(BlockId block, Memory memory) {
+				// Состояние полей наследуется только от единственного предшественника
+				const auto& preds = f_.blocks[block].preds;
+				if (block != f_.entry && !(preds.size() == 1u && preds.front() == idom_[block])) {
+					memory.clear();
+				}
+				vector<string> scope;
+				for (const ValueId id : vector<ValueId>(f_.blocks[block].code)) {
+					const Instruction& instruction = f_.values[id];
+					if (instruction.op == Opcode::Phi || IsTerminator(instruction.op)) {
+						continue;
+					}
+					const Effects effects = GetEffects(instruction);
+					if (effects.IsPure()) {
+						string key = KeyOf(instruction);
+						if (const auto it = available_.find(key); it != available_.end()) {
+							++stats_.redundant;
+							Replace(id, it->second);
+						}
+						else {
+							available_.emplace(key, id);
+							scope.push_back(std::move(key));
+						}
+					}
+					else if (instruction.op == Opcode::LoadField || instruction.op == Opcode::CheckLoad) {
+						const ValueId object = instruction.operands[instruction.op == Opcode::LoadField ? 0 : 1];
+						auto [it, inserted] = memory.emplace(make_pair(object, instruction.name), id);
+						if (!inserted) {
+							++stats_.loads_forwarded;
+							Replace(id, it->second);
+						}
+					}
+					else if (instruction.op == Opcode::StoreField) {
+						for (auto it = memory.begin(); it != memory.end();) {
+							it = it->first.second == instruction.name ? memory.erase(it) : next(it);
+						}
+						memory[{ instruction.operands[0], instruction.name }] = instruction.operands[1];
+					}
+					else if (effects.calls) {
+						memory.clear();
+					}
+				}
+				for (const BlockId child : dom_children_[block]) {
+					NumberValues(child, memory);
+				}
+				for (const string& key : scope) {
+					available_.erase(key);
+				}
+			}
+
+			// Удаление записей, перезаписываемых в том же блоке до любого чтения
+			void EliminateDeadStores() {
+				ComputeOrder();
+				ComputeTypes();
+				for (const BlockId block : rpo_) {
+					set<pair<ValueId, string>> overwritten;
+					const vector<ValueId> code = f_.blocks[block].code;
+					for (auto it = code.rbegin(); it != code.rend(); ++it) {
+						const Instruction& instruction = f_.values[*it];
+						if (instruction.op == Opcode::StoreField) {
+							if (!overwritten.emplace(instruction.operands[0], instruction.name).second) {
+								++stats_.dead_stores;
+								Remove(*it);
+							}
+						}
+						else if (GetEffects(instruction).calls) {
+							overwritten.clear();
+						}
+						else if (GetEffects(instruction).reads_fields) {
+							for (auto field = overwritten.begin(); field != overwritten.end();) {
+								field = field->second == instruction.name ? overwritten.erase(field) : next(field);
+							}
+						}
+					}
+				}
+			}
+
+			// Проверка метода, результат которой не нужен: ту же проверку выполнит вызов, следующий
+			// за ней без промежуточных эффектов
+			bool IsRedundantResolve(ValueId id, const vector<size_t>& uses) const {
+				const Instruction& resolve = f_.values[id];
+				if (resolve.op != Opcode::ResolveMethod || uses[id] != 0) {
+					return false;
+				}
+				const auto& code = f_.blocks[resolve.block].code;
+				for (auto it = find(code.begin(), code.end(), id) + 1; it != code.end(); ++it) {
+					const Instruction& instruction = f_.values[*it];
+					if (instruction.op == Opcode::Call || instruction.op == Opcode::TailCall) {
+						return instruction.operands[0] == resolve.operands[0] && instruction.name == resolve.name
+							&& instruction.operands.size() == resolve.index + 1;
+					}
+					if (IsTerminator(instruction.op) || !GetEffects(instruction).IsRemovable()) {
+						return false;
+					}
+				}
+				return false;
+			}
+
+			// Удаление инструкций, результат которых не используется, включая циклы из phi
+			void EliminateDeadCode() {
+				ComputeOrder();
+				ComputeTypes();
+				vector<size_t> uses(f_.values.size());
+				for (const BlockId block : rpo_) {
+					for (const ValueId id : f_.blocks[block].code) {
+						for (const ValueId operand : f_.values[id].operands) {
+							++uses[operand];
+						}
+					}
+				}
+				vector<bool> live(f_.values.size());
+				vector<ValueId> worklist;
+				for (const BlockId block : rpo_) {
+					for (const ValueId id : f_.blocks[block].code) {
+						const Instruction& instruction = f_.values[id];
+						const bool root = IsTerminator(instruction.op) || (instruction.op != Opcode::Phi
+							&& !GetEffects(instruction).IsRemovable() && !IsRedundantResolve(id, uses));
+						if (root) {
+							live[id] = true;
+							worklist.push_back(id);
+						}
+					}
+				}
+				while (!worklist.empty()) {
+					const ValueId id = worklist.back();
+					worklist.pop_back();
+					for (const ValueId operand : f_.values[id].operands) {
+						if (!live[operand]) {
+							live[operand] = true;
+							worklist.push_back(operand);
+						}
+					}
+				}
+				for (const BlockId block : rpo_) {
+					for (const ValueId id : vector<ValueId>(f_.blocks[block].code)) {
+						if (!live[id]) {
+							++stats_.dead_code;
+							Remove(id);
+						}
+					}
+				}
+			}
+
+			// Вынос инвариантов из цикла хвостовой рекурсии
+
+			void HoistLoopInvariants() {
+				const BlockId header = f_.loop_header;
+				if (header == NO_BLOCK) {
+					return;
+				}
+				ComputeOrder();
+				ComputeTypes();
+
+				// Тело цикла - блоки, из которых достижим переход в заголовок, не проходя через него
+				vector<bool> in_loop(f_.blocks.size());
+				in_loop[header] = true;
+				vector<BlockId> worklist;
+				BlockId preheader = NO_BLOCK;
+				for (const BlockId pred : f_.blocks[header].preds) {
+					if (pred == f_.entry) {
+						preheader = pred;
+					}
+					else if (!in_loop[pred]) {
+						in_loop[pred] = true;
+						worklist.push_back(pred);
+					}
+				}
+				if (preheader == NO_BLOCK || worklist.empty()) {
+					return;
+				}
+				while (!worklist.empty()) {
+					const BlockId block = worklist.back();
+					worklist.pop_back();
+					for (const BlockId pred : f_.blocks[block].preds) {
+						if (!in_loop[pred]) {
+							in_loop[pred] = true;
+							worklist.push_back(pred);
+						}
+					}
+				}
+				if (in_loop[preheader]) {
+					return;
+				}
+
+				bool calls = false;
+				set<string> written;
+				for (BlockId block = 0; block < f_.blocks.size(); ++block) {
+					if (!in_loop[block]) {
+						continue;
+					}
+					for (const ValueId id : f_.blocks[block].code) {
+						const Instruction& instruction = f_.values[id];
+						calls = calls || GetEffects(instruction).calls;
+						if (instruction.op == Opcode::StoreField) {
+							written.insert(instruction.name);
+						}
+					}
+				}
+
+				auto invariant = [this, &in_loop](const Instruction& instruction) {
+					return all_of(instruction.operands.begin(), instruction.operands.end(), [this, &in_loop](ValueId operand) {
+						return !in_loop[f_.values[operand].block];
+					});
+				};
+				for (const BlockId block : rpo_) {
+					if (!in_loop[block]) {
+						continue;
+					}
+					for (const ValueId id : vector<ValueId>(f_.blocks[block].code)) {
+						const Instruction& instruction = f_.values[id];
+						if (instruction.op == Opcode::Phi || IsTerminator(instruction.op) || !invariant(instruction)) {
+							continue;
+						}
+						if (GetEffects(instruction).IsRemovable()) {
+							MoveToEnd(id, preheader);
+							++stats_.hoisted;
+						}
+						else if (instruction.op == Opcode::LoadField && !calls && written.count(instruction.name) == 0) {
+							HoistLoad(id, preheader);
+							++stats_.hoisted;
+						}
+					}
+				}
+			}
+
+			// Чтение поля до цикла не должно выбрасывать исключение, поэтому оно заменяется на
+			// TryLoadField, а на прежнем месте остаётся CheckLoad, который повторит чтение с ошибкой
+			void HoistLoad(ValueId id, BlockId preheader) {
+				Instruction hoisted;
+				hoisted.op = Opcode::TryLoadField;
+				hoisted.block = preheader;
+				hoisted.operands = f_.values[id].operands;
+				hoisted.name = f_.values[id].name;
+				hoisted.owner = f_.values[id].owner;
+				const auto hoisted_id = static_cast<ValueId>(f_.values.size());
+				f_.values.push_back(std::move(hoisted));
+				auto& code = f_.blocks[preheader].code;
+				code.insert(code.end() - 1, hoisted_id);
+
+				Instruction& check = f_.values[id];
+				check.op = Opcode::CheckLoad;
+				check.operands = { hoisted_id, check.operands[0] };
+			}
+
+			Function& f_;
+			OptimizationStats stats_;
+			vector<BlockId> rpo_;
+			vector<BlockId> rpo_index_;
+			vector<BlockId> idom_;
+			vector<vector<BlockId>> dom_children_;
+			vector<TypeMask> types_;
+			map<string, ValueId> available_;
+		};
+
+	}  // namespace
+
+	OptimizationStats Optimize(Function& function) {
+		return Optimizer(function).Run();
+	}
+
+}  // namespace ir
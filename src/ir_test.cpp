@@ -0,0 +1,146 @@
+#include "ir.h"
+#include "lexer.h"
+#include "parse.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace ir {
+
+	namespace {
+
+		const string PROGRAM = R"(
+class Counter:
+  def __init__():
+    self.total = 0
+    self.step = 2
+
+  def count(n, acc):
+    if not n:
+      return acc
+    return self.count(n - 1, acc - self.step * 3)
+
+  def store(x):
+    self.total = x
+    self.total = x - 1
+    return self.total + self.total
+
+  def describe(x):
+    print 'x =', x, x
+    return x or 1 + 2 * 3
+
+c = Counter()
+print c.count(100000, 0)
+print c.store(4)
+print c.describe(0), c.describe('a')
+c.step = 5
+print c.count(2, 1)
+)"s;
+
+		// Выполняет программу, при необходимости с подключённым IR, и возвращает её вывод
+		string Run(const string& program, bool use_ir, runtime::Closure& closure) {
+			istringstream is(program);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+			if (use_ir) {
+				InstallProgram(*tree);
+			}
+
+			runtime::DummyContext context;
+			tree->Execute(closure, context);
+			return context.output.str();
+		}
+
+		void TestOptimizedMatchesInterpreter() {
+			runtime::Closure plain;
+			runtime::Closure optimized;
+			const string expected = Run(PROGRAM, false, plain);
+			ASSERT_EQUAL(expected, "-600000\n6\nx = 0 0\nx = a a\nTrue True\n-29\n"s);
+			ASSERT_EQUAL(Run(PROGRAM, true, optimized), expected);
+		}
+
+		void TestOptimizationPasses() {
+			runtime::Closure closure;
+			Run(PROGRAM, false, closure);
+			const auto* counter = closure.at("Counter"s).TryAs<runtime::Class>();
+			ASSERT(counter != nullptr);
+
+			auto count = Lower(*counter, *counter->GetMethod("count"s));
+			ASSERT(count != nullptr);
+			Verify(*count);
+			const OptimizationStats count_stats = Optimize(*count);
+			Verify(*count);
+			ASSERT(count->loop_header != NO_BLOCK);
+			ASSERT(count_stats.hoisted > 0u);
+
+			ostringstream dump;
+			Print(*count, dump);
+			ASSERT(dump.str().find("tail_call"s) != string::npos);
+
+			auto store = Lower(*counter, *counter->GetMethod("store"s));
+			ASSERT(store != nullptr);
+			const OptimizationStats store_stats = Optimize(*store);
+			Verify(*store);
+			ASSERT_EQUAL(store_stats.dead_stores, 1u);
+			ASSERT(store_stats.loads_forwarded >= 2u);
+
+			auto describe = Lower(*counter, *counter->GetMethod("describe"s));
+			ASSERT(describe != nullptr);
+			const OptimizationStats describe_stats = Optimize(*describe);
+			Verify(*describe);
+			ASSERT(describe_stats.folded > 0u);
+			ASSERT(describe_stats.redundant > 0u);
+		}
+
+		void TestErrorsMatchInterpreter() {
+			const string program = R"(
+class Checks:
+  def div(a, b):
+    c = a / b
+    return 1
+
+  def maybe(flag):
+    if flag:
+      y = 5
+    return y
+
+  def field():
+    return self.missing
+
+ch = Checks()
+print ch.maybe(True), ch.div(4, 2)
+)"s;
+			runtime::Closure closure;
+			ASSERT_EQUAL(Run(program, true, closure), "5 1\n"s);
+
+			for (const string& call : {"ch.div(1, 0)"s, "ch.maybe(False)"s, "ch.field()"s}) {
+				runtime::Closure plain;
+				runtime::Closure optimized;
+				string plain_error;
+				string optimized_error;
+				try {
+					Run(program + "print "s + call + "\n"s, false, plain);
+				}
+				catch (const runtime_error& e) {
+					plain_error = e.what();
+				}
+				try {
+					Run(program + "print "s + call + "\n"s, true, optimized);
+				}
+				catch (const runtime_error& e) {
+					optimized_error = e.what();
+				}
+				ASSERT(!plain_error.empty());
+				ASSERT_EQUAL(optimized_error, plain_error);
+			}
+		}
+
+	}  // namespace
+
+	void RunIrTests(TestRunner& tr) {
+		RUN_TEST(tr, ir::TestOptimizedMatchesInterpreter);
+		RUN_TEST(tr, ir::TestOptimizationPasses);
+		RUN_TEST(tr, ir::TestErrorsMatchInterpreter);
+	}
+
+}  // namespace ir
@@ -0,0 +1,745 @@
+#include "jit.h"
+
+#include "statement.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define MYTHON_JIT_SUPPORTED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace jit {
+
+	namespace {
+
+		// Значение, которым скомпилированный код сообщает о возврате в интерпретатор.
+		// Числа хранятся в 64-битных регистрах расширенными знаком, поэтому ни одно число с ним не совпадает.
+		// Этим же значением заполняются ещё не присвоенные локальные переменные
+		constexpr int64_t BAILOUT = numeric_limits<int64_t>::min();
+
+		// Точка входа скомпилированного метода. args - неупакованные значения аргументов
+		using NativeCode = int64_t(*)(runtime::ClassInstance* self, const int64_t* args);
+
+		const runtime::ThresholdTieringPolicy DEFAULT_POLICY;
+
+		// Метод содержит конструкцию, которую компилятор не поддерживает
+		class UnsupportedError : public std::runtime_error {
+		public:
+			using runtime_error::runtime_error;
+		};
+
+		enum Reg : uint8_t {
+			RAX = 0,
+			RCX = 1,
+			RBX = 3,
+			RBP = 5,
+			RSI = 6,
+			RDI = 7,
+		};
+
+		// Коды условий инструкций jcc и setcc
+		enum Cond : uint8_t {
+			EQUAL = 0x4,
+			NOT_EQUAL = 0x5,
+			SIGN = 0x8,
+			LESS = 0xC,
+			GREATER_OR_EQUAL = 0xD,
+			LESS_OR_EQUAL = 0xE,
+			GREATER = 0xF,
+		};
+
+		// Минимальный ассемблер x86-64 с метками и переходами rel32
+		class Assembler {
+		public:
+			using Label = size_t;
+
+			[[nodiscard]] Label NewLabel() {
+				labels_.push_back(UNBOUND);
+				return labels_.size() - 1;
+			}
+
+			void Bind(Label label) {
+				labels_[label] = code_.size();
+			}
+
+			[[nodiscard]] size_t GetPosition() const {
+				return code_.size();
+			}
+
+			void Emit(initializer_list<uint8_t> bytes) {
+				code_.insert(code_.end(), bytes);
+			}
+
+			void EmitInt32(int32_t value) {
+				EmitLittleEndian(value);
+			}
+
+			void PatchInt32(size_t position, int32_t value) {
+				memcpy(code_.data() + position, &value, sizeof(value));
+			}
+
+			// mov reg, imm64
+			void MovImm(Reg reg, int64_t value) {
+				Emit({ 0x48, static_cast<uint8_t>(0xB8 + reg) });
+				EmitLittleEndian(value);
+			}
+
+			void MovImm(Reg reg, const void* pointer) {
+				MovImm(reg, static_cast<int64_t>(reinterpret_cast<intptr_t>(pointer)));
+			}
+
+			// mov dst, [base + disp]
+			void Load(Reg dst, Reg base, int32_t disp) {
+				Emit({ 0x48, 0x8B });
+				EmitMemoryOperand(dst, base, disp);
+			}
+
+			// mov [base + disp], src
+			void Store(Reg base, int32_t disp, Reg src) {
+				Emit({ 0x48, 0x89 });
+				EmitMemoryOperand(src, base, disp);
+			}
+
+			// lea dst, [base + disp]
+			void Lea(Reg dst, Reg base, int32_t disp) {
+				Emit({ 0x48, 0x8D });
+				EmitMemoryOperand(dst, base, disp);
+			}
+
+			void Jmp(Label label) {
+				Emit({ 0xE9 });
+				EmitFixup(label);
+			}
+
+			void Jcc(Cond cond, Label label) {
+				Emit({ 0x0F, static_cast<uint8_t>(0x80 + cond) });
+				EmitFixup(label);
+			}
+
+			// setcc al; movzx eax, al
+			void SetBool(Cond cond) {
+				Emit({ 0x0F, static_cast<uint8_t>(0x90 + cond), 0xC0 });
+				Emit({ 0x0F, 0xB6, 0xC0 });
+			}
+
+			// Разрешает переходы на метки и возвращает машинный код
+			vector<uint8_t> Finish() {
+				for (const auto& [position, label] : fixups_) {
+					const size_t target = labels_.at(label);
+					if (target == UNBOUND) {
+						throw logic_error("Unbound label"s);
+					}
+					PatchInt32(position, static_cast<int32_t>(target - (position + sizeof(int32_t))));
+				}
+				return std::move(code_);
+			}
+
+		private:
+			static constexpr size_t UNBOUND = numeric_limits<size_t>::max();
+
+			template <typename T>
+			void EmitLittleEndian(T value) {
+				uint8_t bytes[sizeof(T)];
+				memcpy(bytes, &value, sizeof(T));
+				code_.insert(code_.end(), begin(bytes), end(bytes));
+			}
+
+			// ModRM с 32-битным смещением. Адресация через rsp требует SIB и не используется
+			void EmitMemoryOperand(Reg reg, Reg base, int32_t disp) {
+				Emit({ static_cast<uint8_t>(0x80 | (reg << 3) | base) });
+				EmitLittleEndian(disp);
+			}
+
+			void EmitFixup(Label label) {
+				fixups_.emplace_back(code_.size(), label);
+				EmitLittleEndian(int32_t{ 0 });
+			}
+
+			vector<uint8_t> code_;
+			vector<size_t> labels_;
+			vector<pair<size_t, Label>> fixups_;
+		};
+
+		// Читает числовое поле self. Вызывается из скомпилированного кода
+		int64_t LoadNumberField(runtime::ClassInstance* self, const string* name) {
+			auto& fields = self->Fields();
+			const auto it = fields.find(*name);
+			if (it == fields.end()) {
+				return BAILOUT;
+			}
+			if (const auto* number = it->second.TryAs<runtime::Number>()) {
+				return number->GetValue();
+			}
+			return BAILOUT;
+		}
+
+		Cond ToCond(runtime::CompareOp op) {
+			switch (op) {
+			case runtime::CompareOp::Equal:
+				return EQUAL;
+			case runtime::CompareOp::NotEqual:
+				return NOT_EQUAL;
+			case runtime::CompareOp::Less:
+				return LESS;
+			case runtime::CompareOp::Greater:
+				return GREATER;
+			case runtime::CompareOp::LessOrEqual:
+				return LESS_OR_EQUAL;
+			case runtime::CompareOp::GreaterOrEqual:
+				return GREATER_OR_EQUAL;
+			}
+			throw UnsupportedError("Unknown comparison"s);
+		}
+
+	}  // namespace
+
+	/*
+	Генерирует машинный код одного метода. Кадр скомпилированного метода:
+	  [rbp - 8]              сохранённый rbx (в rbx хранится self)
+	  [rbp - 16 - 8 * i]     слот i: параметры, затем локальные переменные, затем временные значения
+	Результат выражения всегда оказывается в rax
+	*/
+	class MethodCodegen {
+	public:
+		MethodCodegen(Jit& jit, const runtime::Class& cls, const runtime::Method& method)
+			: jit_(jit)
+			, cls_(cls)
+			, method_(method)
+			, body_(as_.NewLabel())
+			, bailout_(as_.NewLabel())
+			, exit_(as_.NewLabel()) {
+		}
+
+		vector<uint8_t> Generate() {
+			for (const string& param : method_.formal_params) {
+				AddVariable(param, ValueType::Int);
+			}
+			param_count_ = variables_.size();
+			CollectLocals(*method_.body);
+			slot_count_ = variables_.size();
+			max_slot_count_ = slot_count_;
+
+			// push rbp; mov rbp, rsp; push rbx; sub rsp, frame_size; mov rbx, rdi
+			as_.Emit({ 0x55, 0x48, 0x89, 0xE5, 0x53, 0x48, 0x81, 0xEC });
+			const size_t frame_size_position = as_.GetPosition();
+			as_.EmitInt32(0);
+			as_.Emit({ 0x48, 0x89, 0xFB });
+
+			// Уменьшаем бюджет вложенных вызовов: dec qword [budget]; js bailout
+			as_.MovImm(RAX, &jit_.call_budget_);
+			as_.Emit({ 0x48, 0xFF, 0x08 });
+			as_.Jcc(SIGN, bailout_);
+
+			for (size_t i = 0; i < param_count_; ++i) {
+				as_.Load(RAX, RSI, static_cast<int32_t>(i * sizeof(int64_t)));
+				as_.Store(RBP, SlotOffset(i), RAX);
+			}
+
+			as_.Bind(body_);
+			as_.MovImm(RAX, BAILOUT);
+			for (size_t i = param_count_; i < slot_count_; ++i) {
+				as_.Store(RBP, SlotOffset(i), RAX);
+			}
+			EmitStatement(*method_.body);
+			// Выход из метода без return возвращает None, что компилятор не поддерживает
+			as_.Jmp(bailout_);
+
+			as_.Bind(bailout_);
+			as_.MovImm(RAX, BAILOUT);
+			as_.Bind(exit_);
+			// inc qword [budget]; mov rbx, [rbp - 8]; leave; ret
+			as_.MovImm(RCX, &jit_.call_budget_);
+			as_.Emit({ 0x48, 0xFF, 0x01 });
+			as_.Load(RBX, RBP, -8);
+			as_.Emit({ 0xC9, 0xC3 });
+
+			// После push rbx стек выровнен на 8 по модулю 16, кадр должен сохранить это смещение
+			int32_t frame_size = static_cast<int32_t>(max_slot_count_ * sizeof(int64_t));
+			if (frame_size % 16 != 8) {
+				frame_size += 8;
+			}
+			as_.PatchInt32(frame_size_position, frame_size);
+			return as_.Finish();
+		}
+
+	private:
+		enum class ValueType {
+			Int,
+			Bool,
+		};
+
+		struct Variable {
+			size_t slot = 0;
+			optional<ValueType> type;
+		};
+
+		static int32_t SlotOffset(size_t slot) {
+			return -16 - static_cast<int32_t>(slot * sizeof(int64_t));
+		}
+
+		void AddVariable(const string& name, optional<ValueType> type) {
+			if (name == "self"s) {
+				throw UnsupportedError("Assignment to self"s);
+			}
+			variables_.try_emplace(name, Variable{ variables_.size(), type });
+		}
+
+		// Находит все локальные переменные метода, чтобы отвести им слоты до временных значений
+		void CollectLocals(const ast::Statement& statement) {
+			if (const auto* body = dynamic_cast<const ast::MethodBody*>(&statement)) {
+				CollectLocals(body->GetBody());
+			}
+			else if (const auto* compound = dynamic_cast<const ast::Compound*>(&statement)) {
+				for (const auto& child : compound->GetStatements()) {
+					CollectLocals(*child);
+				}
+			}
+			else if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&statement)) {
+				CollectLocals(if_else->GetIfBody());
+				if (const ast::Statement* else_body = if_else->GetElseBody()) {
+					CollectLocals(*else_body);
+				}
+			}
+			else if (const auto* assignment = dynamic_cast<const ast::Assignment*>(&statement)) {
+				AddVariable(assignment->GetVariableName(), nullopt);
+			}
+		}
+
+		// Выделяет count подряд идущих слотов для временных значений и возвращает номер первого
+		size_t AllocateTemps(size_t count) {
+			const size_t first = slot_count_;
+			slot_count_ += count;
+			max_slot_count_ = max(max_slot_count_, slot_count_);
+			return first;
+		}
+
+		void FreeTemps(size_t count) {
+			slot_count_ -= count;
+		}
+
+		// mov rcx, BAILOUT; cmp rax, rcx; je bailout
+		void EmitBailoutCheck() {
+			as_.MovImm(RCX, BAILOUT);
+			as_.Emit({ 0x48, 0x39, 0xC8 });
+			as_.Jcc(EQUAL, bailout_);
+		}
+
+		// test rax, rax
+		void EmitTest() {
+			as_.Emit({ 0x48, 0x85, 0xC0 });
+		}
+
+		void EmitStatement(const ast::Statement& statement) {
+			if (const auto* body = dynamic_cast<const ast::MethodBody*>(&statement)) {
+				EmitStatement(body->GetBody());
+			}
+			else if (const auto* compound = dynamic_cast<const ast::Compound*>(&statement)) {
+				for (const auto& child : compound->GetStatements()) {
+					EmitStatement(*child);
+				}
+			}
+			else if (const auto* assignment = dynamic_cast<const ast::Assignment*>(&statement)) {
+				Variable& variable = variables_.at(assignment->GetVariableName());
+				const ValueType type = EmitExpression(assignment->GetValue());
+				if (variable.type && *variable.type != type) {
+					throw UnsupportedError("Variable changes its type"s);
+				}
+				variable.type = type;
+				as_.Store(RBP, SlotOffset(variable.slot), RAX);
+			}
+			else if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&statement)) {
+				const auto else_label = as_.NewLabel();
+				const auto end_label = as_.NewLabel();
+				EmitExpression(if_else->GetCondition());
+				EmitTest();
+				as_.Jcc(EQUAL, else_label);
+				EmitStatement(if_else->GetIfBody());
+				as_.Jmp(end_label);
+				as_.Bind(else_label);
+				if (const ast::Statement* else_body = if_else->GetElseBody()) {
+					EmitStatement(*else_body);
+				}
+				as_.Bind(end_label);
+			}
+			else if (const auto* return_statement = dynamic_cast<const ast::Return*>(&statement)) {
+				const auto* call = dynamic_cast<const ast::MethodCall*>(&return_statement->GetStatement());
+				if (call && ResolveCall(*call) == &method_) {
+					EmitSelfTailCall(*call);
+				}
+				else {
+					EmitInt(return_statement->GetStatement());
+					as_.Jmp(exit_);
+				}
+			}
+			else {
+				throw UnsupportedError("Unsupported statement"s);
+			}
+		}
+
+		void EmitInt(const ast::Statement& expression) {
+			if (EmitExpression(expression) != ValueType::Int) {
+				throw UnsupportedError("Number expected"s);
+			}
+		}
+
+		// Вычисляет lhs во временный слот, rhs в rax, затем переносит rhs в rcx, а lhs в rax
+		void EmitOperands(const ast::BinaryOperation& operation, ValueType expected) {
+			const size_t temp = AllocateTemps(1);
+			if (EmitExpression(operation.GetLhs()) != expected) {
+				throw UnsupportedError("Unexpected operand type"s);
+			}
+			as_.Store(RBP, SlotOffset(temp), RAX);
+			if (EmitExpression(operation.GetRhs()) != expected) {
+				throw UnsupportedError("Unexpected operand type"s);
+			}
+			as_.Emit({ 0x48, 0x89, 0xC1 });
+			as_.Load(RAX, RBP, SlotOffset(temp));
+			FreeTemps(1);
+		}
+
+		ValueType EmitExpression(const ast::Statement& expression) {
+			if (const auto* number = dynamic_cast<const ast::NumericConst*>(&expression)) {
+				as_.MovImm(RAX, number->GetValue().GetValue());
+				return ValueType::Int;
+			}
+			if (const auto* boolean = dynamic_cast<const ast::BoolConst*>(&expression)) {
+				as_.MovImm(RAX, boolean->GetValue().GetValue() ? 1 : 0);
+				return ValueType::Bool;
+			}
+			if (const auto* variable = dynamic_cast<const ast::VariableValue*>(&expression)) {
+				return EmitVariable(*variable);
+			}
+			if (const auto* call = dynamic_cast<const ast::MethodCall*>(&expression)) {
+				EmitCall(*call);
+				return ValueType::Int;
+			}
+			if (const auto* comparison = dynamic_cast<const ast::Comparison*>(&expression)) {
+				const size_t temp = AllocateTemps(1);
+				const ValueType type = EmitExpression(comparison->GetLhs());
+				as_.Store(RBP, SlotOffset(temp), RAX);
+				if (EmitExpression(comparison->GetRhs()) != type) {
+					throw UnsupportedError("Comparison of different types"s);
+				}
+				as_.Emit({ 0x48, 0x89, 0xC1 });
+				as_.Load(RAX, RBP, SlotOffset(temp));
+				FreeTemps(1);
+				// cmp eax, ecx
+				as_.Emit({ 0x39, 0xC8 });
+				as_.SetBool(ToCond(comparison->GetOp()));
+				return ValueType::Bool;
+			}
+			if (const auto* add = dynamic_cast<const ast::Add*>(&expression)) {
+				EmitOperands(*add, ValueType::Int);
+				// add eax, ecx; movsxd rax, eax
+				as_.Emit({ 0x01, 0xC8, 0x48, 0x63, 0xC0 });
+				return ValueType::Int;
+			}
+			if (const auto* sub = dynamic_cast<const ast::Sub*>(&expression)) {
+				EmitOperands(*sub, ValueType::Int);
+				// sub eax, ecx; movsxd rax, eax
+				as_.Emit({ 0x29, 0xC8, 0x48, 0x63, 0xC0 });
+				return ValueType::Int;
+			}
+			if (const auto* mult = dynamic_cast<const ast::Mult*>(&expression)) {
+				EmitOperands(*mult, ValueType::Int);
+				// imul eax, ecx; movsxd rax, eax
+				as_.Emit({ 0x0F, 0xAF, 0xC1, 0x48, 0x63, 0xC0 });
+				return ValueType::Int;
+			}
+			if (const auto* div = dynamic_cast<const ast::Div*>(&expression)) {
+				EmitOperands(*div, ValueType::Int);
+				const auto divide = as_.NewLabel();
+				const auto done = as_.NewLabel();
+				// Деление на ноль выполняет интерпретатор, выбрасывая runtime_error.
+				// test ecx, ecx; jz bailout; cmp ecx, -1; jne divide; neg eax; jmp done
+				as_.Emit({ 0x85, 0xC9 });
+				as_.Jcc(EQUAL, bailout_);
+				as_.Emit({ 0x83, 0xF9, 0xFF });
+				as_.Jcc(NOT_EQUAL, divide);
+				as_.Emit({ 0xF7, 0xD8 });
+				as_.Jmp(done);
+				// divide: cdq; idiv ecx
+				as_.Bind(divide);
+				as_.Emit({ 0x99, 0xF7, 0xF9 });
+				as_.Bind(done);
+				as_.Emit({ 0x48, 0x63, 0xC0 });
+				return ValueType::Int;
+			}
+			if (const auto* or_operation = dynamic_cast<const ast::Or*>(&expression)) {
+				EmitLogical(*or_operation, NOT_EQUAL, 1);
+				return ValueType::Bool;
+			}
+			if (const auto* and_operation = dynamic_cast<const ast::And*>(&expression)) {
+				EmitLogical(*and_operation, EQUAL, 0);
+				return ValueType::Bool;
+			}
+			if (const auto* not_operation = dynamic_cast<const ast::Not*>(&expression)) {
+				EmitExpression(not_operation->GetArgument());
+				EmitTest();
+				as_.SetBool(EQUAL);
+				return ValueType::Bool;
+			}
+			throw UnsupportedError("Unsupported expression"s);
+		}
+
+		// Вычисляет lhs; если условие short_circuit выполнено, результат равен short_circuit_value,
+		// иначе результат - значение rhs, приведённое к Bool
+		void EmitLogical(const ast::BinaryOperation& operation, Cond short_circuit, int64_t short_circuit_value) {
+			const auto short_label = as_.NewLabel();
+			const auto end_label = as_.NewLabel();
+			EmitExpression(operation.GetLhs());
+			EmitTest();
+			as_.Jcc(short_circuit, short_label);
+			EmitExpression(operation.GetRhs());
+			EmitTest();
+			as_.SetBool(NOT_EQUAL);
+			as_.Jmp(end_label);
+			as_.Bind(short_label);
+			as_.MovImm(RAX, short_circuit_value);
+			as_.Bind(end_label);
+		}
+
+		ValueType EmitVariable(const ast::VariableValue& variable) {
+			const auto& ids = variable.GetDottedIds();
+			if (ids.size() == 2 && ids[0] == "self"s) {
+				// mov rdi, rbx; call LoadNumberField
+				as_.Emit({ 0x48, 0x89, 0xDF });
+				as_.MovImm(RSI, &ids[1]);
+				as_.MovImm(RAX, reinterpret_cast<const void*>(&LoadNumberField));
+				as_.Emit({ 0xFF, 0xD0 });
+				EmitBailoutCheck();
+				return ValueType::Int;
+			}
+			if (ids.size() != 1) {
+				throw UnsupportedError("Unsupported field access"s);
+			}
+			const auto it = variables_.find(ids[0]);
+			if (it == variables_.end() || !it->second.type) {
+				throw UnsupportedError("Unknown variable "s + ids[0]);
+			}
+			as_.Load(RAX, RBP, SlotOffset(it->second.slot));
+			if (it->second.slot >= param_count_) {
+				// Переменная может быть не присвоена на текущем пути выполнения
+				EmitBailoutCheck();
+			}
+			return *it->second.type;
+		}
+
+		// Возвращает метод класса, вызываемый инструкцией self.method(args), либо nullptr
+		const runtime::Method* ResolveCall(const ast::MethodCall& call) const {
+			const auto* object = dynamic_cast<const ast::VariableValue*>(&call.GetObject());
+			if (!object || object->GetDottedIds() != vector{ "self"s }) {
+				return nullptr;
+			}
+			const runtime::Method* method = cls_.GetMethod(call.GetMethodName());
+			if (!method || method->formal_params.size() != call.GetArgs().size()) {
+				return nullptr;
+			}
+			return method;
+		}
+
+		// Вычисляет аргументы вызова в подряд идущие временные слоты так, чтобы аргумент i
+		// находился по адресу [rbp + ArgsOffset] + 8 * i. Возвращает номер первого слота
+		size_t EmitArgs(const ast::MethodCall& call) {
+			const auto& args = call.GetArgs();
+			const size_t first = AllocateTemps(args.size());
+			for (size_t i = 0; i < args.size(); ++i) {
+				EmitInt(*args[i]);
+				as_.Store(RBP, SlotOffset(first + args.size() - 1 - i), RAX);
+			}
+			return first;
+		}
+
+		void EmitCall(const ast::MethodCall& call) {
+			const runtime::Method* callee = ResolveCall(call);
+			if (!callee || !jit_.Compile(cls_, *callee)) {
+				throw UnsupportedError("Unsupported call of "s + call.GetMethodName());
+			}
+			const Jit::Entry& entry = jit_.GetEntry(cls_, *callee);
+
+			const size_t arg_count = call.GetArgs().size();
+			const size_t first = EmitArgs(call);
+			// mov rdi, rbx; lea rsi, [args]; call [entry.code]
+			as_.Emit({ 0x48, 0x89, 0xDF });
+			as_.Lea(RSI, RBP, SlotOffset(first + (arg_count > 0 ? arg_count - 1 : 0)));
+			as_.MovImm(RAX, &entry.code);
+			as_.Emit({ 0xFF, 0x10 });
+			FreeTemps(arg_count);
+			EmitBailoutCheck();
+		}
+
+		// return self.method(args) для текущего метода выполняется как переход в начало тела
+		void EmitSelfTailCall(const ast::MethodCall& call) {
+			const size_t arg_count = call.GetArgs().size();
+			const size_t first = EmitArgs(call);
+			for (size_t i = 0; i < arg_count; ++i) {
+				as_.Load(RAX, RBP, SlotOffset(first + arg_count - 1 - i));
+				as_.Store(RBP, SlotOffset(i), RAX);
+			}
+			FreeTemps(arg_count);
+			as_.Jmp(body_);
+		}
+
+		Jit& jit_;
+		const runtime::Class& cls_;
+		const runtime::Method& method_;
+		Assembler as_;
+		Assembler::Label body_;
+		Assembler::Label bailout_;
+		Assembler::Label exit_;
+		unordered_map<string, Variable> variables_;
+		size_t param_count_ = 0;
+		size_t slot_count_ = 0;
+		size_t max_slot_count_ = 0;
+	};
+
+	bool IsSupported() {
+#ifdef MYTHON_JIT_SUPPORTED
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	Jit::Jit()
+		: Jit(DEFAULT_POLICY) {
+	}
+
+	Jit::Jit(const runtime::TieringPolicy& policy)
+		: policy_(policy) {
+		if (IsSupported()) {
+			// mov rax, BAILOUT; ret
+			Assembler as;
+			as.MovImm(RAX, BAILOUT);
+			as.Emit({ 0xC3 });
+			bailout_stub_ = Install(as.Finish());
+		}
+	}
+
+	Jit::~Jit() {
+#ifdef MYTHON_JIT_SUPPORTED
+		for (const auto& [address, size] : regions_) {
+			munmap(address, size);
+		}
+#endif
+	}
+
+	optional<runtime::ObjectHolder> Jit::TryCall(runtime::ClassInstance& self, const runtime::Method& method,
+		runtime::Arguments args, runtime::Context& context) {
+		if (!bailout_stub_) {
+			return nullopt;
+		}
+		Entry& entry = GetEntry(self.GetClass(), method);
+		const runtime::Tier tier = policy_.SelectTier(method.profile);
+		if (tier == runtime::Tier::Native && entry.state == State::Counting) {
+			Compile(self.GetClass(), method);
+		}
+		else if (tier == runtime::Tier::Interpreter && entry.state == State::Compiled) {
+			// Машинный код вызывающих методов переходит по entry.code и теперь сразу возвращается
+			// в интерпретатор
+			entry.state = State::Disabled;
+			entry.code = bailout_stub_;
+			method.profile.tier = runtime::Tier::Interpreter;
+		}
+		if (entry.state != State::Compiled) {
+			return nullopt;
+		}
+
+		int64_t native_args[8];
+		if (args.size() > size(native_args)) {
+			return nullopt;
+		}
+		for (size_t i = 0; i < args.size(); ++i) {
+			const auto* number = args[i].TryAs<runtime::Number>();
+			if (!number) {
+				return nullopt;
+			}
+			native_args[i] = number->GetValue();
+		}
+
+		const size_t depth = context.GetCallDepth();
+		const size_t max_depth = context.GetMaxCallDepth();
+		call_budget_ = depth < max_depth ? static_cast<int64_t>(max_depth - depth) : 0;
+		const auto code = reinterpret_cast<NativeCode>(const_cast<void*>(entry.code));
+		const int64_t result = code(&self, native_args);
+		if (result == BAILOUT) {
+			++stats_.bailouts;
+			++method.profile.deoptimizations;
+			return nullopt;
+		}
+		++stats_.native_calls;
+		++method.profile.native_calls;
+		return runtime::ObjectHolder::Own(runtime::Number(static_cast<int>(result)));
+	}
+
+	bool Jit::IsCompiled(const runtime::Class& cls, const runtime::Method& method) const {
+		const auto it = entries_.find({ &cls, &method });
+		return it != entries_.end() && it->second.state == State::Compiled;
+	}
+
+	Jit::Entry& Jit::GetEntry(const runtime::Class& cls, const runtime::Method& method) {
+		auto [it, inserted] = entries_.try_emplace({ &cls, &method });
+		if (inserted) {
+			it->second.code = bailout_stub_;
+		}
+		return it->second;
+	}
+
+	bool Jit::Compile(const runtime::Class& cls, const runtime::Method& method) {
+		Entry& entry = GetEntry(cls, method);
+		switch (entry.state) {
+		case State::Compiling:
+		case State::Compiled:
+			return true;
+		case State::Rejected:
+		case State::Disabled:
+			return false;
+		case State::Counting:
+			break;
+		}
+
+		entry.state = State::Compiling;
+		try {
+			MethodCodegen codegen(*this, cls, method);
+			entry.code = Install(codegen.Generate());
+			entry.state = State::Compiled;
+			method.profile.tier = runtime::Tier::Native;
+			++stats_.compiled;
+			return true;
+		}
+		catch (const UnsupportedError&) {
+			entry.state = State::Rejected;
+			++stats_.rejected;
+			return false;
+		}
+	}
+
+	const void* Jit::Install(const vector<uint8_t>& code) {
+#ifdef MYTHON_JIT_SUPPORTED
+		const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		const size_t size = (code.size() + page_size - 1) / page_size * page_size;
+		void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED) {
+			throw UnsupportedError("Cannot allocate executable memory"s);
+		}
+		memcpy(memory, code.data(), code.size());
+		if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+			munmap(memory, size);
+			throw UnsupportedError("Cannot allocate executable memory"s);
+		}
+		regions_.emplace_back(memory, size);
+		return memory;
+#else
+		(void)code;
+		throw UnsupportedError("JIT is not supported on this platform"s);
+#endif
+	}
+
+}  // namespace jit
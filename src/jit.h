@@ -0,0 +1,102 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <map>
+
+namespace jit {
+
+	// Возвращает true, если JIT-компиляция поддерживается на текущей платформе (Linux x86-64)
+	[[nodiscard]] bool IsSupported();
+
+	/*
+	Базовый JIT-компилятор методов Mython в машинный код x86-64.
+
+	Когда политика (runtime::TieringPolicy) переводит метод в Tier::Native, метод компилируется
+	для класса объекта, у которого он вызван. Компилируется подмножество языка без побочных эффектов: целочисленная арифметика,
+	сравнения, логические операции, if/else, return, локальные переменные, чтение полей self
+	и вызовы методов self, которые тоже удаётся скомпилировать. Значения хранятся в регистрах
+	и на стеке неупакованными.
+
+	Перед входом в скомпилированный код проверяется, что все аргументы - числа (guard).
+	Если во время выполнения кода нарушается предположение (поле self не является числом,
+	деление на ноль, чтение неприсвоенной переменной, превышение глубины вызовов, выход из
+	метода без return), код возвращает управление интерпретатору, который выполняет вызов
+	заново. Повторное выполнение корректно, так как компилируемый код не имеет побочных эффектов.
+	Такие возвраты учитываются в MethodProfile::deoptimizations; когда политика возвращает метод
+	в интерпретатор, скомпилированный код больше не используется
+	*/
+	class Jit : public runtime::MethodCompiler {
+	public:
+		struct Stats {
+			// Число скомпилированных методов
+			size_t compiled = 0;
+			// Число методов, которые не удалось скомпилировать
+			size_t rejected = 0;
+			// Число вызовов, выполненных скомпилированным кодом
+			size_t native_calls = 0;
+			// Число возвратов из скомпилированного кода в интерпретатор
+			size_t bailouts = 0;
+		};
+
+		// Использует runtime::ThresholdTieringPolicy с параметрами по умолчанию
+		Jit();
+		// policy должна пережить компилятор
+		explicit Jit(const runtime::TieringPolicy& policy);
+		~Jit() override;
+
+		Jit(const Jit&) = delete;
+		Jit& operator=(const Jit&) = delete;
+
+		std::optional<runtime::ObjectHolder> TryCall(runtime::ClassInstance& self, const runtime::Method& method,
+			runtime::Arguments args, runtime::Context& context) override;
+
+		[[nodiscard]] const Stats& GetStats() const {
+			return stats_;
+		}
+
+		// Возвращает true, если метод method, вызываемый у экземпляров cls, скомпилирован
+		[[nodiscard]] bool IsCompiled(const runtime::Class& cls, const runtime::Method& method) const;
+
+	private:
+		friend class MethodCodegen;
+
+		enum class State : uint8_t {
+			Counting,
+			Compiling,
+			Compiled,
+			Rejected,
+			Disabled,
+		};
+
+		// Состояние метода, вызываемого у экземпляров конкретного класса
+		struct Entry {
+			State state = State::Counting;
+			// Точка входа. Пока метод не скомпилирован, указывает на заглушку, возвращающую
+			// управление интерпретатору. Скомпилированный код вызывает методы через этот указатель
+			const void* code = nullptr;
+		};
+
+		using EntryKey = std::pair<const runtime::Class*, const runtime::Method*>;
+
+		// Возвращает состояние метода. Узлы std::map не перемещаются, поэтому адрес Entry::code
+		// можно встраивать в машинный код
+		Entry& GetEntry(const runtime::Class& cls, const runtime::Method& method);
+
+		// Компилирует метод, если он ещё не компилировался. Возвращает false, если метод
+		// не удалось скомпилировать
+		bool Compile(const runtime::Class& cls, const runtime::Method& method);
+
+		// Копирует машинный код в исполняемую память
+		const void* Install(const std::vector<uint8_t>& code);
+
+		const runtime::TieringPolicy& policy_;
+		std::map<EntryKey, Entry> entries_;
+		std::vector<std::pair<void*, size_t>> regions_;
+		const void* bailout_stub_ = nullptr;
+		// Сколько ещё вложенных вызовов может выполнить скомпилированный код
+		int64_t call_budget_ = 0;
+		Stats stats_;
+	};
+
+}  // namespace jit
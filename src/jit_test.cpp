@@ -0,0 +1,220 @@
+#include "jit.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace jit {
+
+	namespace {
+
+		// Выполняет программу с включённым JIT и возвращает её вывод
+		string RunWithJit(const string& program, Jit& jit) {
+			istringstream is(program);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+
+			runtime::DummyContext context;
+			context.SetMethodCompiler(&jit);
+			runtime::Closure closure;
+			tree->Execute(closure, context);
+			return context.output.str();
+		}
+
+		void TestCompiledArithmetic() {
+			if (!IsSupported()) {
+				return;
+			}
+			const string program = R"(
+class Math:
+  def __init__():
+    self.base = 1
+
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+  def gcd(a, b):
+    if b == 0:
+      return a
+    return self.gcd(b, a - a / b * b)
+
+  def scaled(x):
+    y = x * 3 - self.base
+    if not (y > 10 and y < 100) or y == 11:
+      y = -y
+    return y
+
+m = Math()
+print m.fib(20)
+print m.gcd(1071, 462)
+print m.scaled(2), m.scaled(4), m.scaled(50)
+)"s;
+			Jit jit;
+			ASSERT_EQUAL(RunWithJit(program, jit), "6765\n21\n-5 -11 -149\n"s);
+			ASSERT(jit.GetStats().compiled >= 1u);
+			ASSERT(jit.GetStats().native_calls > 0u);
+		}
+
+		void TestGuardsFallBackToInterpreter() {
+			if (!IsSupported()) {
+				return;
+			}
+			const string program = R"(
+class Calc:
+  def twice(x):
+    return x + x
+
+  def twices(n):
+    if n == 0:
+      return 0
+    return self.twice(n) + self.twices(n - 1)
+
+  def count(n, acc):
+    if n == 0:
+      return acc
+    return self.count(n - 1, acc + 1)
+
+  def counts(k):
+    if k == 0:
+      return 0
+    return self.count(10, 0) + self.counts(k - 1)
+
+  def half(x):
+    return x / self.divisor
+
+  def halves(n):
+    if n == 0:
+      return 0
+    return self.half(n) + self.halves(n - 1)
+
+c = Calc()
+print c.twices(60), c.twice('ab')
+print c.counts(60), c.count(1000000, 0)
+c.divisor = 2
+print c.halves(60)
+c.divisor = 0
+print c.half(4)
+)"s;
+			istringstream is(program);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+
+			Jit jit;
+			runtime::DummyContext context;
+			context.SetMethodCompiler(&jit);
+			runtime::Closure closure;
+			try {
+				tree->Execute(closure, context);
+				ASSERT(false);
+			}
+			catch (const runtime_error&) {
+			}
+			ASSERT_EQUAL(context.output.str(), "3660 abab\n600 1000000\n900\n"s);
+
+			const auto* calc = closure.at("Calc"s).TryAs<runtime::Class>();
+			ASSERT(calc != nullptr);
+			ASSERT(jit.IsCompiled(*calc, *calc->GetMethod("twice"s)));
+			ASSERT(jit.IsCompiled(*calc, *calc->GetMethod("count"s)));
+			ASSERT(jit.IsCompiled(*calc, *calc->GetMethod("half"s)));
+			ASSERT_EQUAL(jit.GetStats().bailouts, 1u);
+		}
+
+		void TestPolicyDemotesMethod() {
+			if (!IsSupported()) {
+				return;
+			}
+			const string program = R"(
+class Box:
+  def value():
+    return self.v
+
+b = Box()
+b.v = 1
+s = b.value() + b.value() + b.value() + b.value() + b.value() + b.value()
+b.v = 'x'
+t = b.value() + b.value() + b.value()
+b.v = 2
+print s, t, b.value()
+)"s;
+			istringstream is(program);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+
+			const runtime::ThresholdTieringPolicy policy(5, 2);
+			Jit jit(policy);
+			runtime::DummyContext context;
+			context.SetMethodCompiler(&jit);
+			runtime::Closure closure;
+			tree->Execute(closure, context);
+			ASSERT_EQUAL(context.output.str(), "6 xxx 2\n"s);
+
+			const auto* box = closure.at("Box"s).TryAs<runtime::Class>();
+			ASSERT(box != nullptr);
+			const runtime::Method& value = *box->GetMethod("value"s);
+			ASSERT(!jit.IsCompiled(*box, value));
+			ASSERT_EQUAL(value.profile.calls, 10u);
+			ASSERT_EQUAL(value.profile.native_calls, 2u);
+			ASSERT_EQUAL(value.profile.deoptimizations, 2u);
+			ASSERT(value.profile.tier == runtime::Tier::Interpreter);
+		}
+
+		void TestDemotedCalleeLeavesNativeCallers() {
+			if (!IsSupported()) {
+				return;
+			}
+			const string program = R"(
+class Box:
+  def value():
+    return self.v
+
+  def twice():
+    return self.value() + self.value()
+
+b = Box()
+b.v = 1
+s = b.twice() + b.twice() + b.twice() + b.twice() + b.twice() + b.twice()
+b.v = 'x'
+t = b.value() + b.value() + b.value()
+b.v = 2
+print s, t, b.twice()
+)"s;
+			istringstream is(program);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+
+			const runtime::ThresholdTieringPolicy policy(5, 2);
+			Jit jit(policy);
+			runtime::DummyContext context;
+			context.SetMethodCompiler(&jit);
+			runtime::Closure closure;
+			tree->Execute(closure, context);
+			ASSERT_EQUAL(context.output.str(), "12 xxx 4\n"s);
+
+			const auto* box = closure.at("Box"s).TryAs<runtime::Class>();
+			ASSERT(box != nullptr);
+			const runtime::Method& value = *box->GetMethod("value"s);
+			const runtime::Method& twice = *box->GetMethod("twice"s);
+			ASSERT(!jit.IsCompiled(*box, value));
+			ASSERT(value.profile.tier == runtime::Tier::Interpreter);
+			ASSERT(jit.IsCompiled(*box, twice));
+			// Последний вызов twice не завершился в машинном коде: вызов value из него вернулся
+			// в интерпретатор, и value выполнилась интерпретатором дважды
+			ASSERT_EQUAL(twice.profile.native_calls, 2u);
+			ASSERT_EQUAL(twice.profile.deoptimizations, 1u);
+			ASSERT_EQUAL(value.profile.calls, 4u * 2u + 3u + 2u);
+		}
+
+	}  // namespace
+
+	void RunJitTests(TestRunner& tr) {
+		RUN_TEST(tr, jit::TestCompiledArithmetic);
+		RUN_TEST(tr, jit::TestGuardsFallBackToInterpreter);
+		RUN_TEST(tr, jit::TestPolicyDemotesMethod);
+		RUN_TEST(tr, jit::TestDemotedCalleeLeavesNativeCallers);
+	}
+
+}  // namespace jit
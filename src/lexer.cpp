@@ -22,7 +22,10 @@ namespace parse {
 		{ "not"s, token_type::Not{} },
 		{ "None"s, token_type::None{} },
 		{ "True"s, token_type::True{} },
-		{ "False"s, token_type::False{} }
+		{ "False"s, token_type::False{} },
+		{ "for"s, token_type::For{} },
+		{ "in"s, token_type::In{} },
+		{ "while"s, token_type::While{} }
 	};
 
 	static const std::unordered_map<std::string, Token> str_to_comparison_lexems{
@@ -92,6 +95,9 @@ namespace parse {
 		UNVALUED_OUTPUT(None);
 		UNVALUED_OUTPUT(True);
 		UNVALUED_OUTPUT(False);
+		UNVALUED_OUTPUT(For);
+		UNVALUED_OUTPUT(In);
+		UNVALUED_OUTPUT(While);
 		UNVALUED_OUTPUT(Eof);
 
 #undef UNVALUED_OUTPUT
@@ -48,6 +48,9 @@ namespace parse {
 		struct None {};         // Лексема «None»
 		struct True {};         // Лексема «True»
 		struct False {};        // Лексема «False»
+		struct For {};          // Лексема «for»
+		struct In {};           // Лексема «in»
+		struct While {};        // Лексема «while»
 	}  // namespace token_type
 
 	using TokenBase
@@ -56,7 +59,8 @@ namespace parse {
 		token_type::Def, token_type::Newline, token_type::Print, token_type::Indent,
 		token_type::Dedent, token_type::And, token_type::Or, token_type::Not,
 		token_type::Eq, token_type::NotEq, token_type::LessOrEq, token_type::GreaterOrEq,
-		token_type::None, token_type::True, token_type::False, token_type::Eof>;
+		token_type::None, token_type::True, token_type::False, token_type::For, token_type::In,
+		token_type::While, token_type::Eof>;
 
 	struct Token : TokenBase {
 		using TokenBase::TokenBase;
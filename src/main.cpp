@@ -1,5 +1,11 @@
+#include "aot.h"
+#include "gc.h"
+#include "ir.h"
+#include "jit.h"
 #include "lexer.h"
+#include "memo.h"
 #include "parse.h"
+#include "profile.h"
 #include "runtime.h"
 #include "statement.h"
 #include "test_runner_p.h"
@@ -20,17 +26,102 @@ namespace runtime {
 	void RunObjectsTests(TestRunner& tr);
 }  // namespace runtime
 
+namespace jit {
+	void RunJitTests(TestRunner& tr);
+}  // namespace jit
+
+namespace aot {
+	void RunAotTests(TestRunner& tr);
+}  // namespace aot
+
+namespace profile {
+	void RunProfileTests(TestRunner& tr);
+}  // namespace profile
+
+namespace ir {
+	void RunIrTests(TestRunner& tr);
+}  // namespace ir
+
+namespace memo {
+	void RunMemoTests(TestRunner& tr);
+}  // namespace memo
+
+namespace gc {
+	void RunGcTests(TestRunner& tr);
+}  // namespace gc
+
 void TestParseProgram(TestRunner& tr);
 
 namespace {
 
-	void RunMythonProgram(istream& input, ostream& output) {
+	// Параметры запуска интерпретатора, задаваемые в командной строке
+	struct Options {
+		size_t max_call_depth = runtime::DEFAULT_MAX_CALL_DEPTH;
+		bool jit = false;
+		bool aot = false;
+		bool profile = false;
+		bool ir = false;
+		bool dump_ir = false;
+		bool memoize = false;
+		// Освобождать циклы ссылок сборщиком циклов (см. gc.h), а не только подсчётом ссылок
+		bool tracing_gc = false;
+		// Запрашивать память пула объектов участками в огромных страницах (см. ObjectPool)
+		bool huge_pages = false;
+		// Пределы памяти программы в байтах (см. runtime::MemoryAccount)
+		size_t memory_soft_limit = runtime::MemoryAccount::NO_LIMIT;
+		size_t memory_hard_limit = runtime::MemoryAccount::NO_LIMIT;
+	};
+
+	void RunMythonProgram(istream& input, ostream& output, const Options& options = {}) {
 		parse::Lexer lexer(input);
 		auto program = ParseProgram(lexer);
-
+		if (options.aot) {
+			aot::Transpile(*program, output);
+			return;
+		}
+		if (options.dump_ir) {
+			ir::DumpProgram(*program, cerr);
+		}
+		if (options.ir) {
+			ir::InstallProgram(*program);
+		}
+
+		runtime::ObjectPool& object_pool = runtime::ObjectPool::ForThread();
+		object_pool.SetHugePages(options.huge_pages);
+		runtime::MemoryAccount memory;
+		memory.SetHardLimit(options.memory_hard_limit);
+		memory.SetSoftLimit(options.memory_soft_limit, [](const runtime::MemoryAccount& account) {
+			cerr << "Memory soft limit exceeded: "sv << account.GetUsage() << " bytes in use"sv << endl;
+		});
+		runtime::MemoryAccount::Scope memory_scope(memory);
 		runtime::SimpleContext context{ output };
+		context.SetMaxCallDepth(options.max_call_depth);
+		jit::Jit jit;
+		if (options.jit) {
+			context.SetMethodCompiler(&jit);
+		}
+		memo::Memoizer memoizer;
+		if (options.memoize) {
+			context.SetCallCache(&memoizer);
+		}
+		// Объявлен раньше closure: при уничтожении он освобождает циклы, оставшиеся от переменных программы
+		gc::Collector collector;
+		if (options.tracing_gc) {
+			context.SetObjectTracker(&collector);
+		}
 		runtime::Closure closure;
 		program->Execute(closure, context);
+		if (options.profile) {
+			profile::Dump(*program, cerr);
+			if (options.memoize) {
+				memoizer.Dump(cerr);
+			}
+			if (options.tracing_gc) {
+				collector.Dump(cerr);
+			}
+			object_pool.Dump(cerr);
+			cerr << "Memory: "sv << memory.GetUsage() << " bytes in use, peak "sv << memory.GetPeak() << " bytes\n"sv;
+		}
 	}
 
 	void TestSimplePrints() {
@@ -118,6 +209,12 @@ print y.value
 		runtime::RunObjectsTests(tr);
 		ast::RunUnitTests(tr);
 		TestParseProgram(tr);
+		jit::RunJitTests(tr);
+		aot::RunAotTests(tr);
+		profile::RunProfileTests(tr);
+		ir::RunIrTests(tr);
+		memo::RunMemoTests(tr);
+		gc::RunGcTests(tr);
 
 		RUN_TEST(tr, TestSimplePrints);
 		RUN_TEST(tr, TestAssignments);
@@ -127,11 +224,73 @@ print y.value
 
 }  // namespace
 
-int main() {
+// Параметры командной строки:
+//   --max-depth N  максимальная глубина вызовов методов (по умолчанию 1000)
+//   --jit          компилировать часто вызываемые методы в машинный код (Linux x86-64)
+//   --aot          не выполнять программу, а вывести её перевод на C++ (см. aot.h)
+//   --profile      после выполнения вывести в stderr счётчики вызовов методов (см. profile.h),
+//                  заполненность пула объектов, а вместе с --memoize - и попадания в кэш результатов
+//   --ir           выполнять методы в оптимизированном промежуточном представлении (см. ir.h)
+//   --dump-ir      перед выполнением вывести в stderr оптимизированный IR методов
+//   --memoize      кэшировать результаты чистых методов (см. memo.h)
+//   --gc MODE      способ освобождения объектов: refcount (по умолчанию) - только подсчёт ссылок,
+//                  tracing - подсчёт ссылок и сборщик циклов (см. gc.h). Вместе с --profile
+//                  в stderr выводятся число сборок и длительность пауз
+//   --huge-pages   размещать пул объектов в огромных страницах памяти (Linux)
+//   --memory-limit N       завершить программу с ошибкой, когда её объекты займут больше N байт
+//   --memory-soft-limit N  вывести в stderr предупреждение, когда объекты программы займут больше N байт
+int main(int argc, char* argv[]) {
 	try {
+		Options options;
+		for (int i = 1; i < argc; ++i) {
+			const string_view arg = argv[i];
+			if (arg == "--max-depth"sv && i + 1 < argc) {
+				options.max_call_depth = stoul(argv[++i]);
+			}
+			else if (arg == "--jit"sv) {
+				options.jit = true;
+			}
+			else if (arg == "--aot"sv) {
+				options.aot = true;
+			}
+			else if (arg == "--profile"sv) {
+				options.profile = true;
+			}
+			else if (arg == "--ir"sv) {
+				options.ir = true;
+			}
+			else if (arg == "--dump-ir"sv) {
+				options.dump_ir = true;
+			}
+			else if (arg == "--memoize"sv) {
+				options.memoize = true;
+			}
+			else if (arg == "--gc"sv && i + 1 < argc) {
+				const string_view mode = argv[++i];
+				if (mode != "refcount"sv && mode != "tracing"sv) {
+					cerr << "Unknown GC mode: "sv << mode << endl;
+					return 1;
+				}
+				options.tracing_gc = mode == "tracing"sv;
+			}
+			else if (arg == "--huge-pages"sv) {
+				options.huge_pages = true;
+			}
+			else if (arg == "--memory-limit"sv && i + 1 < argc) {
+				options.memory_hard_limit = stoul(argv[++i]);
+			}
+			else if (arg == "--memory-soft-limit"sv && i + 1 < argc) {
+				options.memory_soft_limit = stoul(argv[++i]);
+			}
+			else {
+				cerr << "Unknown option: "sv << arg << endl;
+				return 1;
+			}
+		}
+
 		TestAll();
 
-		RunMythonProgram(cin, cout);
+		RunMythonProgram(cin, cout, options);
 	}
 	catch (const std::exception& e) {
 		std::cerr << e.what() << std::endl;
@@ -0,0 +1,203 @@
+#include "memo.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <set>
+
+using namespace std;
+
+namespace memo {
+
+	namespace {
+
+		bool IsSelf(const ast::Statement& statement) {
+			const auto* variable = dynamic_cast<const ast::VariableValue*>(&statement);
+			return variable && variable->GetDottedIds().size() == 1u && variable->GetDottedIds().front() == "self"sv;
+		}
+
+		/*
+		Проверяет тело одного метода без учёта вызываемых им методов и собирает вызываемые методы
+		self. Значения внутри чистого метода - неизменяемые значения, поэтому арифметика,
+		сравнения и str() не вызывают методов Mython
+		*/
+		class LocalChecker {
+		public:
+			explicit LocalChecker(const runtime::Class& cls)
+				: cls_(cls) {
+			}
+
+			bool Check(const ast::Statement& statement) {
+				if (dynamic_cast<const ast::NumericConst*>(&statement) || dynamic_cast<const ast::StringConst*>(&statement)
+					|| dynamic_cast<const ast::BoolConst*>(&statement) || dynamic_cast<const ast::None*>(&statement)) {
+					return true;
+				}
+				if (const auto* variable = dynamic_cast<const ast::VariableValue*>(&statement)) {
+					// Чтение поля или самого self
+					return variable->GetDottedIds().size() == 1u && !IsSelf(*variable);
+				}
+				if (const auto* assignment = dynamic_cast<const ast::Assignment*>(&statement)) {
+					return assignment->GetVariableName() != "self"sv && Check(assignment->GetValue());
+				}
+				if (const auto* call = dynamic_cast<const ast::MethodCall*>(&statement)) {
+					if (!IsSelf(call->GetObject()) || !CheckAll(call->GetArgs())) {
+						return false;
+					}
+					const runtime::Method* callee = cls_.GetMethod(call->GetMethodName());
+					if (!callee || callee->formal_params.size() != call->GetArgs().size()) {
+						return false;
+					}
+					callees_.push_back(callee);
+					return true;
+				}
+				if (const auto* unary = dynamic_cast<const ast::UnaryOperation*>(&statement)) {
+					return Check(unary->GetArgument());
+				}
+				if (const auto* binary = dynamic_cast<const ast::BinaryOperation*>(&statement)) {
+					return Check(binary->GetLhs()) && Check(binary->GetRhs());
+				}
+				if (const auto* compound = dynamic_cast<const ast::Compound*>(&statement)) {
+					return CheckAll(compound->GetStatements());
+				}
+				if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&statement)) {
+					return Check(if_else->GetCondition()) && Check(if_else->GetIfBody())
+						&& (!if_else->GetElseBody() || Check(*if_else->GetElseBody()));
+				}
+				if (const auto* loop = dynamic_cast<const ast::While*>(&statement)) {
+					return Check(loop->GetCondition()) && Check(loop->GetBody());
+				}
+				if (const auto* loop = dynamic_cast<const ast::ForRange*>(&statement)) {
+					return loop->GetVariable() != "self"sv && Check(loop->GetBegin()) && Check(loop->GetEnd())
+						&& Check(loop->GetBody());
+				}
+				if (const auto* return_statement = dynamic_cast<const ast::Return*>(&statement)) {
+					return Check(return_statement->GetStatement());
+				}
+				if (const auto* body = dynamic_cast<const ast::MethodBody*>(&statement)) {
+					return Check(body->GetBody());
+				}
+				// print, запись поля, создание объекта и неизвестные узлы
+				return false;
+			}
+
+			[[nodiscard]] const vector<const runtime::Method*>& GetCallees() const {
+				return callees_;
+			}
+
+		private:
+			bool CheckAll(const vector<unique_ptr<ast::Statement>>& statements) {
+				return all_of(statements.begin(), statements.end(), [this](const auto& statement) {
+					return Check(*statement);
+				});
+			}
+
+			const runtime::Class& cls_;
+			vector<const runtime::Method*> callees_;
+		};
+
+		// Строит ключ кэша из значений аргументов и их типов. Возвращает false, если среди
+		// аргументов есть изменяемый объект
+		bool MakeKey(runtime::Arguments args, string& key) {
+			for (const runtime::ObjectHolder& arg : args) {
+				switch (arg.GetType()) {
+				case runtime::ObjectType::None:
+					key += 'N';
+					break;
+				case runtime::ObjectType::Number:
+					key += 'n';
+					key += to_string(arg.TryAs<runtime::Number>()->GetValue());
+					break;
+				case runtime::ObjectType::Bool:
+					key += arg.TryAs<runtime::Bool>()->GetValue() ? 'T' : 'F';
+					break;
+				case runtime::ObjectType::String: {
+					const string& value = arg.TryAs<runtime::String>()->GetValue();
+					key += 's';
+					key += to_string(value.size());
+					key += ':';
+					key += value;
+					break;
+				}
+				default:
+					return false;
+				}
+				key += ';';
+			}
+			return true;
+		}
+
+	}  // namespace
+
+	bool IsPure(const runtime::Class& cls, const runtime::Method& method) {
+		// Метод чистый, если чисты тела всех методов, достижимых из него по вызовам методов self
+		set<const runtime::Method*> visited = { &method };
+		vector<const runtime::Method*> worklist = { &method };
+		while (!worklist.empty()) {
+			const runtime::Method* current = worklist.back();
+			worklist.pop_back();
+			LocalChecker checker(cls);
+			if (!current->body || !checker.Check(*current->body)) {
+				return false;
+			}
+			for (const runtime::Method* callee : checker.GetCallees()) {
+				if (visited.insert(callee).second) {
+					worklist.push_back(callee);
+				}
+			}
+		}
+		return true;
+	}
+
+	Memoizer::Memoizer(size_t capacity)
+		: capacity_(capacity) {
+	}
+
+	optional<runtime::ObjectHolder> Memoizer::TryCall(runtime::ClassInstance& self, const runtime::Method& method,
+		runtime::Arguments args, runtime::Context& context) {
+		const runtime::Class& cls = self.GetClass();
+		auto [it, inserted] = entries_.try_emplace(EntryKey{ &cls, &method });
+		Entry& entry = it->second;
+		if (inserted) {
+			entry.pure = IsPure(cls, method);
+		}
+		string key;
+		if (!entry.pure || !MakeKey(args, key)) {
+			return nullopt;
+		}
+
+		if (const auto result = entry.results.find(key); result != entry.results.end()) {
+			++entry.hits;
+			return result->second;
+		}
+		++entry.misses;
+		runtime::ObjectHolder result = self.Invoke(method, args, context);
+		if (entry.results.size() < capacity_) {
+			entry.results.emplace(std::move(key), result);
+		}
+		return result;
+	}
+
+	vector<Memoizer::MethodStats> Memoizer::GetStats() const {
+		vector<MethodStats> stats;
+		for (const auto& [key, entry] : entries_) {
+			if (entry.pure && entry.hits + entry.misses > 0u) {
+				stats.push_back({ key.first, key.second, entry.hits, entry.misses, entry.results.size() });
+			}
+		}
+		stable_sort(stats.begin(), stats.end(), [](const MethodStats& lhs, const MethodStats& rhs) {
+			return lhs.hits + lhs.misses > rhs.hits + rhs.misses;
+		});
+		return stats;
+	}
+
+	void Memoizer::Dump(ostream& out) const {
+		out << "Memoized methods:\n"sv;
+		out << setw(12) << "hits"sv << setw(12) << "misses"sv << setw(8) << "hit %"sv
+			<< setw(10) << "entries"sv << "  method\n"sv;
+		for (const MethodStats& stats : GetStats()) {
+			const double hit_rate = 100.0 * static_cast<double>(stats.hits) / static_cast<double>(stats.hits + stats.misses);
+			out << setw(12) << stats.hits << setw(12) << stats.misses << setw(8) << fixed << setprecision(1) << hit_rate
+				<< setw(10) << stats.entries << "  "sv << stats.cls->GetName() << '.' << stats.method->name << '\n';
+		}
+	}
+
+}  // namespace memo
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "statement.h"
+
+#include <map>
+#include <ostream>
+
+namespace memo {
+
+	/*
+	Возвращает true, если метод method, вызываемый у экземпляров cls, - чистая функция своих
+	аргументов, когда все аргументы - неизменяемые значения (числа, строки, Bool, None). Метод
+	чистый, если ни он, ни вызываемые им методы не выполняют print, не читают и не изменяют поля,
+	не создают объекты и используют self только для вызова методов self, которые тогда тоже
+	должны быть чистыми. Методы self ищутся в таблице методов cls
+	*/
+	[[nodiscard]] bool IsPure(const runtime::Class& cls, const runtime::Method& method);
+
+	/*
+	Кэш результатов чистых методов. Результат вызова сохраняется, если метод чистый (см. IsPure)
+	и все аргументы - неизменяемые значения. Ключ кэша - класс объекта, метод и значения аргументов
+	вместе с их типами. Для каждого метода хранится не больше capacity результатов: когда кэш метода
+	заполнен, новые результаты не сохраняются.
+
+	Скомпилированный код (см. jit::Jit) вызывает методы self напрямую, минуя кэш
+	*/
+	class Memoizer : public runtime::CallCache {
+	public:
+		static constexpr size_t DEFAULT_CAPACITY = 4096u;
+
+		// Счётчики кэша чистого метода
+		struct MethodStats {
+			const runtime::Class* cls = nullptr;
+			const runtime::Method* method = nullptr;
+			// Число вызовов, результат которых найден в кэше
+			uint64_t hits = 0;
+			// Число вызовов, результат которых пришлось вычислить
+			uint64_t misses = 0;
+			// Число сохранённых результатов
+			size_t entries = 0;
+		};
+
+		explicit Memoizer(size_t capacity = DEFAULT_CAPACITY);
+
+		Memoizer(const Memoizer&) = delete;
+		Memoizer& operator=(const Memoizer&) = delete;
+
+		std::optional<runtime::ObjectHolder> TryCall(runtime::ClassInstance& self, const runtime::Method& method,
+			runtime::Arguments args, runtime::Context& context) override;
+
+		// Возвращает счётчики вызывавшихся чистых методов в порядке убывания числа вызовов
+		[[nodiscard]] std::vector<MethodStats> GetStats() const;
+
+		// Выводит счётчики и долю попаданий в кэш для каждого вызывавшегося чистого метода
+		void Dump(std::ostream& out) const;
+
+	private:
+		struct Entry {
+			bool pure = false;
+			std::unordered_map<std::string, runtime::ObjectHolder> results;
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+		};
+
+		using EntryKey = std::pair<const runtime::Class*, const runtime::Method*>;
+
+		size_t capacity_;
+		// Узлы std::map не перемещаются, поэтому ссылка на Entry остаётся верной во время вызова
+		std::map<EntryKey, Entry> entries_;
+	};
+
+}  // namespace memo
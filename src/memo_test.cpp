@@ -0,0 +1,129 @@
+#include "lexer.h"
+#include "memo.h"
+#include "parse.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace memo {
+
+	namespace {
+
+		const string PROGRAM = R"(
+class Formulas:
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+  def label(n, suffix):
+    return str(self.fib(n)) + suffix
+
+  def noisy(n):
+    print 'noisy', n
+    return n
+
+  def scaled(n):
+    return n * self.factor
+
+  def calls_noisy(n):
+    return self.noisy(n)
+
+  def even(n):
+    if n == 0:
+      return True
+    return self.odd(n - 1)
+
+  def odd(n):
+    if n == 0:
+      return False
+    return self.even(n - 1)
+
+class Shouting(Formulas):
+  def noisy(n):
+    return n
+
+f = Formulas()
+f.factor = 3
+print f.fib(25), f.label(10, '!'), f.label(10, '!')
+print f.noisy(1), f.noisy(1), f.calls_noisy(2), f.scaled(2)
+f.factor = 4
+print f.scaled(2), f.even(10), f.odd(10)
+s = Shouting()
+print s.calls_noisy(5)
+)"s;
+
+		// Выполняет программу с кэшем memoizer и возвращает её вывод
+		string Run(Memoizer& memoizer, runtime::Closure& closure) {
+			istringstream is(PROGRAM);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+			runtime::DummyContext context;
+			context.SetCallCache(&memoizer);
+			tree->Execute(closure, context);
+			return context.output.str();
+		}
+
+		void TestPurityAnalysis() {
+			Memoizer memoizer;
+			runtime::Closure closure;
+			Run(memoizer, closure);
+			const auto& formulas = *closure.at("Formulas"s).TryAs<runtime::Class>();
+			const auto& shouting = *closure.at("Shouting"s).TryAs<runtime::Class>();
+			auto is_pure = [](const runtime::Class& cls, const string& name) {
+				return IsPure(cls, *cls.GetMethod(name));
+			};
+			ASSERT(is_pure(formulas, "fib"s));
+			ASSERT(is_pure(formulas, "label"s));
+			ASSERT(is_pure(formulas, "even"s));
+			ASSERT(!is_pure(formulas, "noisy"s));
+			ASSERT(!is_pure(formulas, "scaled"s));
+			ASSERT(!is_pure(formulas, "calls_noisy"s));
+			// Вызовы методов self разрешаются по классу объекта
+			ASSERT(is_pure(shouting, "calls_noisy"s));
+		}
+
+		void TestMemoizedCalls() {
+			Memoizer memoizer;
+			runtime::Closure closure;
+			ASSERT_EQUAL(Run(memoizer, closure),
+				"75025 55! 55!\nnoisy 1\nnoisy 1\nnoisy 2\n1 1 2 6\n8 True False\n5\n"s);
+
+			// Каждое значение fib вычисляется один раз
+			const Memoizer::MethodStats fib = memoizer.GetStats().front();
+			ASSERT_EQUAL(fib.method->name, "fib"s);
+			ASSERT_EQUAL(fib.misses, 26u);
+			ASSERT_EQUAL(fib.entries, 26u);
+			ASSERT_EQUAL(fib.hits, 24u);
+		}
+
+		void TestStatsAndCapacity() {
+			Memoizer memoizer(8u);
+			runtime::Closure closure;
+			Run(memoizer, closure);
+
+			const vector<Memoizer::MethodStats> stats = memoizer.GetStats();
+			ASSERT(!stats.empty());
+			ASSERT_EQUAL(stats.front().method->name, "fib"s);
+			ASSERT_EQUAL(stats.front().entries, 8u);
+			ASSERT(stats.front().hits > 0u);
+			for (const Memoizer::MethodStats& row : stats) {
+				ASSERT(row.method->name != "noisy"s || row.cls->GetName() == "Shouting"s);
+				ASSERT(row.method->name != "scaled"s);
+			}
+
+			ostringstream out;
+			memoizer.Dump(out);
+			ASSERT(out.str().find("Formulas.label\n"s) != string::npos);
+			ASSERT(out.str().find("    50.0         1  Formulas.label\n"s) != string::npos);
+		}
+
+	}  // namespace
+
+	void RunMemoTests(TestRunner& tr) {
+		RUN_TEST(tr, memo::TestPurityAnalysis);
+		RUN_TEST(tr, memo::TestMemoizedCalls);
+		RUN_TEST(tr, memo::TestStatsAndCapacity);
+	}
+
+}  // namespace memo
@@ -19,8 +19,9 @@ namespace {
 
 	class Parser {
 	public:
-		explicit Parser(parse::Lexer& lexer)
-			: lexer_(lexer) {
+		Parser(parse::Lexer& lexer, const runtime::BuiltinRegistry& builtins)
+			: lexer_(lexer)
+			, builtins_(builtins) {
 		}
 
 		// Program -> eps
@@ -30,6 +31,7 @@ namespace {
 			while (!lexer_.CurrentToken().Is<TokenType::Eof>()) {
 				result->AddStatement(ParseStatement());
 			}
+			ast::MarkStatementTemporaries(*result);
 
 			return result;
 		}
@@ -136,11 +138,23 @@ namespace {
 		}
 
 		//  AssgnOrCall -> DottedIds = Expr
+		//               | DottedIds ['[' Expr ']']+ = Expr
 		//               | DottedIds '(' ExprList ')'
 		unique_ptr<ast::Statement> ParseAssignmentOrCall() {
 			lexer_.Expect<TokenType::Id>();
 
 			vector<string> id_list = ParseDottedIds();
+			if (lexer_.CurrentToken() == '[') {
+				unique_ptr<ast::Statement> object = make_unique<ast::VariableValue>(std::move(id_list));
+				unique_ptr<ast::Statement> index = ParseSubscript();
+				while (lexer_.CurrentToken() == '[') {
+					object = make_unique<ast::Index>(std::move(object), std::move(index));
+					index = ParseSubscript();
+				}
+				lexer_.Expect<TokenType::Char>('=');
+				lexer_.NextToken();
+				return make_unique<ast::IndexAssignment>(std::move(object), std::move(index), ParseTest());
+			}
 			string last_name = id_list.back();
 			id_list.pop_back();
 
@@ -207,16 +221,32 @@ namespace {
 			return result;
 		}
 
-		// Mult -> '(' Expr ')'
-		//       | NUMBER
-		//       | '-' Mult
-		//       | STRING
-		//       | NONE
-		//       | TRUE
-		//       | FALSE
-		//       | DottedIds '(' ExprList ')'
-		//       | DottedIds
+		// Mult -> '-' Mult
+		//       | Primary ['[' Expr ']']*
 		unique_ptr<ast::Statement> ParseMult()  // NOLINT
+		{
+			if (lexer_.CurrentToken() == '-') {
+				lexer_.NextToken();
+				return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
+			}
+			auto result = ParsePrimary();
+			while (lexer_.CurrentToken() == '[') {
+				result = make_unique<ast::Index>(std::move(result), ParseSubscript());
+			}
+			return result;
+		}
+
+		// Primary -> '(' Expr ')'
+		//          | NUMBER
+		//          | STRING
+		//          | NONE
+		//          | TRUE
+		//          | FALSE
+		//          | '[' [ExprList] ']'
+		//          | '{' [Expr ':' Expr [',' Expr ':' Expr]*] '}'
+		//          | DottedIds '(' ExprList ')'
+		//          | DottedIds
+		unique_ptr<ast::Statement> ParsePrimary()  // NOLINT
 		{
 			if (lexer_.CurrentToken() == '(') {
 				lexer_.NextToken();
@@ -225,10 +255,6 @@ namespace {
 				lexer_.NextToken();
 				return result;
 			}
-			if (lexer_.CurrentToken() == '-') {
-				lexer_.NextToken();
-				return make_unique<ast::Mult>(ParseMult(), make_unique<ast::NumericConst>(-1));
-			}
 			if (const auto* num = lexer_.CurrentToken().TryAs<TokenType::Number>()) {
 				int result = num->value;
 				lexer_.NextToken();
@@ -251,10 +277,47 @@ namespace {
 				lexer_.NextToken();
 				return make_unique<ast::None>();
 			}
+			if (lexer_.CurrentToken() == '[') {
+				vector<unique_ptr<ast::Statement>> items;
+				if (lexer_.NextToken() != ']') {
+					items = ParseTestList();
+				}
+				lexer_.Expect<TokenType::Char>(']');
+				lexer_.NextToken();
+				return make_unique<ast::ListLiteral>(std::move(items));
+			}
+			if (lexer_.CurrentToken() == '{') {
+				vector<pair<unique_ptr<ast::Statement>, unique_ptr<ast::Statement>>> items;
+				if (lexer_.NextToken() != '}') {
+					while (true) {
+						auto key = ParseTest();
+						lexer_.Expect<TokenType::Char>(':');
+						lexer_.NextToken();
+						items.emplace_back(std::move(key), ParseTest());
+						if (lexer_.CurrentToken() != ',') {
+							break;
+						}
+						lexer_.NextToken();
+					}
+				}
+				lexer_.Expect<TokenType::Char>('}');
+				lexer_.NextToken();
+				return make_unique<ast::DictLiteral>(std::move(items));
+			}
 
 			return ParseDottedIdsInMultExpr();
 		}
 
+		// Subscript -> '[' Expr ']'
+		unique_ptr<ast::Statement> ParseSubscript() {
+			lexer_.Expect<TokenType::Char>('[');
+			lexer_.NextToken();
+			auto index = ParseTest();
+			lexer_.Expect<TokenType::Char>(']');
+			lexer_.NextToken();
+			return index;
+		}
+
 		std::unique_ptr<ast::Statement> ParseDottedIdsInMultExpr() {
 			vector<string> names = ParseDottedIds();
 
@@ -285,6 +348,19 @@ namespace {
 					}
 					return make_unique<ast::Stringify>(std::move(args.front()));
 				}
+				if (method_name == "len"sv) {
+					if (args.size() != 1) {
+						throw ParseError("Function len takes exactly one argument"s);
+					}
+					return make_unique<ast::Length>(std::move(args.front()));
+				}
+				if (const runtime::BuiltinFunction* function = builtins_.Find(method_name)) {
+					if (args.size() != function->arity) {
+						throw ParseError("Function "s + method_name + " takes "s + to_string(function->arity)
+							+ " arguments, "s + to_string(args.size()) + " given"s);
+					}
+					return make_unique<ast::BuiltinCall>(*function, std::move(args));
+				}
 				throw ParseError("Unknown call to "s + method_name + "()"s);
 			}
 			return make_unique<ast::VariableValue>(std::move(names));
@@ -326,6 +402,54 @@ namespace {
 				std::move(else_body));
 		}
 
+		// While -> while LogicalExpr: Suite
+		unique_ptr<ast::Statement> ParseWhile()  // NOLINT
+		{
+			lexer_.Expect<TokenType::While>();
+			lexer_.NextToken();
+
+			auto condition = ParseTest();
+
+			lexer_.Expect<TokenType::Char>(':');
+			lexer_.NextToken();
+
+			return make_unique<ast::While>(std::move(condition), ParseSuite());
+		}
+
+		// For -> for id in range(LogicalExpr [, LogicalExpr]): Suite
+		//      | for id in LogicalExpr: Suite
+		unique_ptr<ast::Statement> ParseFor()  // NOLINT
+		{
+			lexer_.Expect<TokenType::For>();
+			string variable = lexer_.ExpectNext<TokenType::Id>().value;
+			lexer_.ExpectNext<TokenType::In>();
+			lexer_.NextToken();
+			const auto* function = lexer_.CurrentToken().TryAs<TokenType::Id>();
+			if (!function || function->value != "range"sv) {
+				auto iterable = ParseTest();
+				lexer_.Expect<TokenType::Char>(':');
+				lexer_.NextToken();
+				return make_unique<ast::ForEach>(std::move(variable), std::move(iterable), ParseSuite());
+			}
+			lexer_.ExpectNext<TokenType::Char>('(');
+			lexer_.NextToken();
+
+			vector<unique_ptr<ast::Statement>> bounds = ParseTestList();
+			if (bounds.size() > 2u) {
+				throw ParseError("Function range takes one or two arguments"s);
+			}
+			if (bounds.size() == 1u) {
+				bounds.insert(bounds.begin(), make_unique<ast::NumericConst>(0));
+			}
+
+			lexer_.Expect<TokenType::Char>(')');
+			lexer_.ExpectNext<TokenType::Char>(':');
+			lexer_.NextToken();
+
+			return make_unique<ast::ForRange>(std::move(variable), std::move(bounds[0]), std::move(bounds[1]),
+				ParseSuite());
+		}
+
 		// LogicalExpr -> AndTest [OR AndTest]
 		// AndTest -> NotTest [AND NotTest]
 		// NotTest -> [NOT] NotTest
@@ -368,32 +492,32 @@ namespace {
 
 			if (tok == '<') {
 				lexer_.NextToken();
-				return make_unique<ast::Comparison>(runtime::Less, std::move(result),
+				return make_unique<ast::Comparison>(runtime::CompareOp::Less, std::move(result),
 					ParseExpression());
 			}
 			if (tok == '>') {
 				lexer_.NextToken();
-				return make_unique<ast::Comparison>(runtime::Greater, std::move(result),
+				return make_unique<ast::Comparison>(runtime::CompareOp::Greater, std::move(result),
 					ParseExpression());
 			}
 			if (tok.Is<TokenType::Eq>()) {
 				lexer_.NextToken();
-				return make_unique<ast::Comparison>(runtime::Equal, std::move(result),
+				return make_unique<ast::Comparison>(runtime::CompareOp::Equal, std::move(result),
 					ParseExpression());
 			}
 			if (tok.Is<TokenType::NotEq>()) {
 				lexer_.NextToken();
-				return make_unique<ast::Comparison>(runtime::NotEqual, std::move(result),
+				return make_unique<ast::Comparison>(runtime::CompareOp::NotEqual, std::move(result),
 					ParseExpression());
 			}
 			if (tok.Is<TokenType::LessOrEq>()) {
 				lexer_.NextToken();
-				return make_unique<ast::Comparison>(runtime::LessOrEqual, std::move(result),
+				return make_unique<ast::Comparison>(runtime::CompareOp::LessOrEqual, std::move(result),
 					ParseExpression());
 			}
 			if (tok.Is<TokenType::GreaterOrEq>()) {
 				lexer_.NextToken();
-				return make_unique<ast::Comparison>(runtime::GreaterOrEqual, std::move(result),
+				return make_unique<ast::Comparison>(runtime::CompareOp::GreaterOrEqual, std::move(result),
 					ParseExpression());
 			}
 			return result;
@@ -402,6 +526,8 @@ namespace {
 		// Statement -> SimpleStatement Newline
 		//           | class ClassDefinition
 		//           | if Condition
+		//           | while While
+		//           | for For
 		unique_ptr<ast::Statement> ParseStatement()  // NOLINT
 		{
 			const auto& tok = lexer_.CurrentToken();
@@ -413,6 +539,12 @@ namespace {
 			if (tok.Is<TokenType::If>()) {
 				return ParseCondition();
 			}
+			if (tok.Is<TokenType::While>()) {
+				return ParseWhile();
+			}
+			if (tok.Is<TokenType::For>()) {
+				return ParseFor();
+			}
 			auto result = ParseSimpleStatement();
 			lexer_.Expect<TokenType::Newline>();
 			lexer_.NextToken();
@@ -441,11 +573,16 @@ namespace {
 		}
 
 		parse::Lexer& lexer_;
+		const runtime::BuiltinRegistry& builtins_;
 		runtime::Closure declared_classes_;
 	};
 
 }  // namespace
 
 unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer) {
-	return Parser{ lexer }.ParseProgram();
+	return ParseProgram(lexer, runtime::StandardBuiltins());
+}
+
+unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer, const runtime::BuiltinRegistry& builtins) {
+	return Parser{ lexer, builtins }.ParseProgram();
 }
\ No newline at end of file
@@ -9,10 +9,15 @@ namespace parse {
 
 namespace runtime {
 	class Executable;
+	class BuiltinRegistry;
 }
 
 struct ParseError : std::runtime_error {
 	using std::runtime_error::runtime_error;
 };
 
-std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
\ No newline at end of file
+// Разбирает программу; вызовы f(args) разрешаются по таблице стандартных функций runtime::StandardBuiltins
+std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
+
+// То же с таблицей встроенных функций builtins, которая должна существовать, пока выполняется программа
+std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer, const runtime::BuiltinRegistry& builtins);
\ No newline at end of file
@@ -173,6 +173,60 @@ print x.call_count
 		ASSERT_EQUAL(context.output.str(), "17\n1\n115\n"s);
 	}
 
+	void TestDeepTailRecursion() {
+		const string program = R"(
+class Counter:
+  def count(n, acc):
+    if n == 0:
+      return acc
+    return self.count(n - 1, acc + 1)
+
+x = Counter()
+print x.count(10000000, 0)
+)"s;
+
+		runtime::DummyContext context;
+
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		tree->Execute(closure, context);
+
+		ASSERT_EQUAL(context.output.str(), "10000000\n"s);
+	}
+
+	void TestRecursionDepthLimit() {
+		const string program = R"(
+class Sum:
+  def calc(n):
+    if n == 0:
+      return 0
+    return n + self.calc(n - 1)
+
+x = Sum()
+print x.calc(10)
+print x.calc(20)
+)"s;
+
+		runtime::DummyContext context;
+		context.SetMaxCallDepth(15);
+
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		try {
+			tree->Execute(closure, context);
+			ASSERT(false);
+		}
+		catch (const runtime_error&) {
+		}
+		ASSERT_EQUAL(context.output.str(), "55\n"s);
+		ASSERT_EQUAL(context.GetCallDepth(), 0u);
+
+		context.output.str(""s);
+		context.SetMaxCallDepth(21);
+		tree->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(), "55\n210\n"s);
+	}
+
 	void TestComplexLogicalExpression() {
 		const string program = R"(
 a = 1
@@ -246,6 +300,380 @@ print r, c, t1, t2
 
 }  // namespace parse
 
+namespace parse {
+
+	void TestLoops() {
+		const string program = R"(
+class Loops:
+  def first_square_above(limit):
+    for i in range(100):
+      if i * i > limit:
+        return i
+    return None
+
+  def collatz(n):
+    steps = 0
+    while n != 1:
+      if n / 2 * 2 == n:
+        n = n / 2
+      else:
+        n = 3 * n + 1
+      steps = steps + 1
+    return steps
+
+l = Loops()
+total = 0
+for i in range(3, 7):
+  for j in range(i):
+    total = total + j
+print total, i, j
+last = None
+for k in range(4):
+  last = k
+  k = 'rebound'
+print last, k
+for k in range(5, 5):
+  print 'never'
+print l.first_square_above(50), l.collatz(27), l.first_square_above(100000)
+)"s;
+
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		tree->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(), "34 6 5\n3 rebound\n8 111 None\n"s);
+
+		ASSERT_THROWS(ParseProgramFromString("for i in items(3):\n  print i\n"s), ParseError);
+		ASSERT_THROWS(ParseProgramFromString("for i in range(1, 2, 3):\n  print i\n"s), ParseError);
+		auto bad_bound = ParseProgramFromString("for i in range('3'):\n  print i\n"s);
+		ASSERT_THROWS(bad_bound->Execute(closure, context), runtime_error);
+	}
+
+}  // namespace parse
+
+namespace parse {
+
+	void TestLists() {
+		const string program = R"(
+class Stack:
+  def __init__():
+    self.items = []
+
+  def push(x):
+    return self.items.append(x)
+
+  def top():
+    return self.items[-1]
+
+  def __str__():
+    return 'Stack' + str(self.items)
+
+s = Stack()
+for word in ['a', 'b', 'c']:
+  s.push(word)
+print s, s.top(), len(s.items), len('abc')
+squares = []
+for i in range(5):
+  squares.append(i * i)
+squares[0] = -1
+total = 0
+for x in squares:
+  total = total + x
+print squares, total, squares[1] + squares[-2]
+grid = [[1, 2], [3, 4]]
+grid[1][0] = 'x'
+print grid, grid[0][1], 'abc'[1], [] == [], [1, [2]] == [1, [2]], [1] != [2]
+growing = [1]
+for x in growing:
+  if x < 4:
+    growing.append(x + 1)
+print growing
+if [] or not [0]:
+  print 'never'
+)"s;
+
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		tree->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(),
+			"Stack['a', 'b', 'c'] c 3 3\n[-1, 1, 4, 9, 16] 29 10\n[[1, 2], ['x', 4]] 2 b True True True\n[1, 2, 3, 4]\n"s);
+
+		for (const string& statement : { "print [1][1]"s, "print len(1)"s, "for x in 5:\n  print x"s, "x = 1\nx[0] = 2"s,
+			"[1].pop()"s }) {
+			runtime::Closure bad_closure;
+			ASSERT_THROWS(ParseProgramFromString(statement + "\n"s)->Execute(bad_closure, context), runtime_error);
+		}
+	}
+
+	void TestDicts() {
+		const string program = R"(
+class Counter:
+  def __init__():
+    self.counts = {}
+
+  def add(word):
+    if not self.counts.contains(word):
+      self.counts[word] = 0
+    self.counts[word] = self.counts[word] + 1
+
+c = Counter()
+for word in ['b', 'a', 'b', 'c', 'b']:
+  c.add(word)
+print c.counts, len(c.counts), c.counts['b'], c.counts.contains('z')
+for word in c.counts:
+  print word, c.counts[word]
+mixed = {1: 'one', True: 'yes', 'k': [1, {}]}
+mixed[2] = mixed.get(1)
+print mixed, {} == {}, {1: 2, 3: 4} == {3: 4, 1: 2}, {1: 2} != {1: 3}
+if {}:
+  print 'never'
+)"s;
+
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		tree->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(),
+			"{'b': 3, 'a': 1, 'c': 1} 3 3 False\nb 3\na 1\nc 1\n"
+			"{1: 'one', True: 'yes', 'k': [1, {}], 2: 'one'} True True True\n"s);
+
+		for (const string& statement : { "print {}[1]"s, "print {[]: 1}"s, "x = {}\nx.append(1)"s }) {
+			runtime::Closure bad_closure;
+			ASSERT_THROWS(ParseProgramFromString(statement + "\n"s)->Execute(bad_closure, context), runtime_error);
+		}
+	}
+
+	void TestDictKeysFromRangeLoop() {
+		// Счётчик цикла, ставший ключом словаря, не должен изменяться на следующих итерациях
+		const string program = R"(
+d = {}
+for i in range(0, 3):
+  d[i] = i * 10
+print d, d.get(0), d.get(2)
+)"s;
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		tree->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(), "{0: 0, 1: 10, 2: 20} 0 20\n"s);
+	}
+
+	void TestFrameLocalObjects() {
+		const string program = R"(
+class Vector:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def norm2():
+    return self.x * self.x + self.y * self.y
+
+  def keep(holder):
+    holder.kept = self
+    return 0
+
+class Geometry:
+  def length2(x, y):
+    v = Vector(x, y)
+    s = v.x * v.x + v.y * v.y
+    if s > 100:
+      print 'long', s, str(s)
+    return s
+
+  def via_method(x, y):
+    v = Vector(x, y)
+    n = v.norm2()
+    return n
+
+  def leak(x):
+    v = Vector(x, x)
+    v.keep(self)
+    return x
+
+  def stored(x):
+    self.last = x * 2
+    w = x + 1
+    self.w = w
+    u = w
+    return [x - 1, u]
+
+g = Geometry()
+print g.length2(3, 4), g.length2(10, 1), g.via_method(1, 2), g.leak(1), g.stored(5)
+)"s;
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		tree->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(), "long 101 101\n25 101 5 1 [4, 6]\n"s);
+		ASSERT_EQUAL(context.GetFrameArena()->GetLiveCount(), 0u);
+
+		const auto& geometry = *closure.at("Geometry"s).TryAs<runtime::Class>();
+		auto frame_local_count = [&geometry](const string& method) {
+			return dynamic_cast<const ast::MethodBody&>(*geometry.GetMethod(method)->body).GetFrameLocalCount();
+		};
+		// Vector(x, y), оба произведения, сравнение в условии и str(s); сумма возвращается
+		ASSERT_EQUAL(frame_local_count("length2"s), 5u);
+		// norm2 не выпускает self
+		ASSERT_EQUAL(frame_local_count("via_method"s), 1u);
+		ASSERT_EQUAL(frame_local_count("leak"s), 0u);
+		ASSERT_EQUAL(frame_local_count("stored"s), 0u);
+		// Вектор, сохранённый в поле другого объекта, размещён не в памяти кадра
+		const runtime::ObjectHolder& kept = closure.at("g"s).TryAs<runtime::ClassInstance>()->Fields().at("kept"s);
+		ASSERT(kept->GetStorage() != runtime::Storage::Frame);
+
+		// Объекты кадров освобождаются вместе с кадрами
+		runtime::Frame& frame = context.PushFrame();
+		ASSERT_EQUAL(frame.arena.GetLiveCount(), 0u);
+		ASSERT(frame.arena.GetPageCount() > 0u);
+		context.PopFrame();
+	}
+
+	void TestStatementTemporaries() {
+		const string program = R"(
+a = 2
+b = 3
+x = a + b * 4 - 1
+print a + b * 4 - 1, str(a * b), a * b > 5
+i = 0
+while i < 3:
+  print i * 10 + 1
+  i = i + 1
+)"s;
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		// Сумма в x = ..., значения print в верхней строке, условие цикла и значения print в цикле.
+		// Значения x и i присваиваются переменным, а b * 4 передаётся методу __add__ значения a,
+		// если a - экземпляр класса
+		ASSERT_EQUAL(ast::MarkStatementTemporaries(*tree), 1u + 6u + 1u + 2u);
+
+		tree->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(), "13 6 True\n1\n11\n21\n"s);
+		ASSERT(closure.at("x"s)->GetStorage() == runtime::Storage::Shared);
+		ASSERT(closure.at("i"s)->GetStorage() == runtime::Storage::Shared);
+		// Промежуточные значения освобождены вместе со своими инструкциями, и одна страница
+		// использовалась всеми инструкциями
+		runtime::FrameArena& arena = *context.GetFrameArena();
+		ASSERT_EQUAL(arena.GetLiveCount(), 0u);
+		ASSERT_EQUAL(arena.GetPageCount(), 1u);
+
+		context.SetFrameAllocation(false);
+		ASSERT_EQUAL(context.GetFrameArena(), nullptr);
+	}
+
+	void TestMemoryLimit() {
+		const string program = R"(
+class Node:
+  def __init__(text):
+    self.text = text
+
+s = 'x'
+i = 0
+while i < 64:
+  s = s + s
+  n = Node(s)
+  i = i + 1
+)"s;
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		runtime::MemoryAccount account;
+		account.SetHardLimit(1u << 20u);
+		{
+			runtime::MemoryAccount::Scope scope(account);
+			ASSERT_THROWS(tree->Execute(closure, context), runtime_error);
+		}
+		// Строка удваивается, пока следующая не превысит предел
+		ASSERT(account.GetPeak() <= account.GetHardLimit());
+		ASSERT(account.GetPeak() > account.GetHardLimit() / 4u);
+		const int doublings = closure.at("i"s).TryAs<runtime::Number>()->GetValue();
+		ASSERT(doublings >= 17 && doublings < 20);
+		ASSERT(account.GetUsage() > closure.at("s"s).TryAs<runtime::String>()->GetValue().size());
+		closure.clear();
+		ASSERT_EQUAL(account.GetUsage(), 0u);
+	}
+
+	void TestFreshInstances() {
+		const string program = R"(
+class Point:
+  def __init__(x):
+    self.x = x
+
+class Factory:
+  def make(x):
+    return Point(x)
+
+f = Factory()
+a = f.make(1)
+b = f.make(2)
+points = []
+for i in range(0, 3):
+  points.append(Point(i))
+print a.x, b.x
+for i in range(0, 3):
+  p = points[i]
+  print p.x
+)"s;
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto tree = ParseProgramFromString(program);
+		tree->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(), "1 2\n0\n1\n2\n"s);
+		ASSERT(closure.at("a"s).Get() != closure.at("b"s).Get());
+	}
+
+	void TestBuiltinFunctions() {
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		ParseProgramFromString(R"(
+class Pair:
+  def __init__(a, b):
+    self.a = a
+    self.b = b
+
+  def larger():
+    return max(self.a, self.b)
+
+p = Pair(3, -7)
+print abs(p.b), p.larger(), min('b', 'a'), int('-42') + int(True), int(5)
+max = 1
+print max
+)"s)->Execute(closure, context);
+		ASSERT_EQUAL(context.output.str(), "7 3 a -41 5\n1\n"s);
+
+		ASSERT_THROWS(ParseProgramFromString("print abs(1, 2)\n"s), ParseError);
+		for (const string& statement : { "print abs('x')"s, "print int('12a')"s, "print int('')"s }) {
+			runtime::Closure bad_closure;
+			ASSERT_THROWS(ParseProgramFromString(statement + "\n"s)->Execute(bad_closure, context), runtime_error);
+		}
+
+		// Функции программы-хозяина вызываются так же, как стандартные
+		runtime::BuiltinRegistry registry;
+		runtime::RegisterStandardBuiltins(registry);
+		size_t calls = 0;
+		registry.Register("join"s, 3u, [&calls](runtime::Arguments args, runtime::Context& /*context*/) {
+			++calls;
+			string result;
+			for (const runtime::ObjectHolder& arg : args) {
+				result += arg.TryAs<runtime::String>()->GetValue();
+			}
+			return runtime::ObjectHolder::Own(runtime::String(result));
+		});
+		ASSERT_THROWS(registry.Register("join"s, 1u, nullptr), invalid_argument);
+
+		istringstream is("print join('a', 'b', 'c'), abs(-1)\n"s);
+		parse::Lexer lexer(is);
+		runtime::DummyContext host_context;
+		runtime::Closure host_closure;
+		ParseProgram(lexer, registry)->Execute(host_closure, host_context);
+		ASSERT_EQUAL(host_context.output.str(), "abc 1\n"s);
+		ASSERT_EQUAL(calls, 1u);
+		ASSERT_THROWS(ParseProgramFromString("print join('a', 'b', 'c')\n"s), ParseError);
+	}
+
+}  // namespace parse
+
 void TestParseProgram(TestRunner& tr) {
 	RUN_TEST(tr, parse::TestSimpleProgram);
 	RUN_TEST(tr, parse::TestProgramWithClasses);
@@ -253,6 +681,17 @@ void TestParseProgram(TestRunner& tr) {
 	RUN_TEST(tr, parse::TestReturnFromIf);
 	RUN_TEST(tr, parse::TestRecursion);
 	RUN_TEST(tr, parse::TestRecursion2);
+	RUN_TEST(tr, parse::TestDeepTailRecursion);
+	RUN_TEST(tr, parse::TestRecursionDepthLimit);
 	RUN_TEST(tr, parse::TestComplexLogicalExpression);
 	RUN_TEST(tr, parse::TestClassicalPolymorphism);
+	RUN_TEST(tr, parse::TestLoops);
+	RUN_TEST(tr, parse::TestLists);
+	RUN_TEST(tr, parse::TestDicts);
+	RUN_TEST(tr, parse::TestDictKeysFromRangeLoop);
+	RUN_TEST(tr, parse::TestFrameLocalObjects);
+	RUN_TEST(tr, parse::TestStatementTemporaries);
+	RUN_TEST(tr, parse::TestMemoryLimit);
+	RUN_TEST(tr, parse::TestFreshInstances);
+	RUN_TEST(tr, parse::TestBuiltinFunctions);
 }
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "profile.h"
+
+#include <algorithm>
+#include <iomanip>
+
+using namespace std;
+
+namespace profile {
+
+	namespace {
+
+		struct MethodRow {
+			const runtime::Class* cls;
+			const runtime::Method* method;
+		};
+
+		struct CallSiteRow {
+			// Метод, в теле которого находится вызов. Для инструкций верхнего уровня поля равны nullptr
+			MethodRow owner;
+			const ast::MethodCall* call;
+		};
+
+		// Обходит дерево программы и собирает методы классов и места вызовов
+		class Collector {
+		public:
+			void Visit(const ast::Statement& statement) {
+				if (const auto* compound = dynamic_cast<const ast::Compound*>(&statement)) {
+					for (const auto& child : compound->GetStatements()) {
+						Visit(*child);
+					}
+				}
+				else if (const auto* definition = dynamic_cast<const ast::ClassDefinition*>(&statement)) {
+					const runtime::Class& cls = definition->GetClass();
+					for (const runtime::Method& method : cls.GetOwnMethods()) {
+						methods_.push_back({ &cls, &method });
+					}
+				}
+				else if (const auto* assignment = dynamic_cast<const ast::Assignment*>(&statement)) {
+					Visit(assignment->GetValue());
+				}
+				else if (const auto* field_assignment = dynamic_cast<const ast::FieldAssignment*>(&statement)) {
+					Visit(field_assignment->GetValue());
+				}
+				else if (const auto* print = dynamic_cast<const ast::Print*>(&statement)) {
+					VisitAll(print->GetArgs());
+				}
+				else if (const auto* call = dynamic_cast<const ast::MethodCall*>(&statement)) {
+					call_sites_.push_back({ owner_, call });
+					Visit(call->GetObject());
+					VisitAll(call->GetArgs());
+				}
+				else if (const auto* new_instance = dynamic_cast<const ast::NewInstance*>(&statement)) {
+					VisitAll(new_instance->GetArgs());
+				}
+				else if (const auto* builtin = dynamic_cast<const ast::BuiltinCall*>(&statement)) {
+					VisitAll(builtin->GetArgs());
+				}
+				else if (const auto* unary = dynamic_cast<const ast::UnaryOperation*>(&statement)) {
+					Visit(unary->GetArgument());
+				}
+				else if (const auto* binary = dynamic_cast<const ast::BinaryOperation*>(&statement)) {
+					Visit(binary->GetLhs());
+					Visit(binary->GetRhs());
+				}
+				else if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&statement)) {
+					Visit(if_else->GetCondition());
+					Visit(if_else->GetIfBody());
+					if (const ast::Statement* else_body = if_else->GetElseBody()) {
+						Visit(*else_body);
+					}
+				}
+				else if (const auto* loop = dynamic_cast<const ast::While*>(&statement)) {
+					Visit(loop->GetCondition());
+					Visit(loop->GetBody());
+				}
+				else if (const auto* loop = dynamic_cast<const ast::ForRange*>(&statement)) {
+					Visit(loop->GetBegin());
+					Visit(loop->GetEnd());
+					Visit(loop->GetBody());
+				}
+				else if (const auto* loop = dynamic_cast<const ast::ForEach*>(&statement)) {
+					Visit(loop->GetIterable());
+					Visit(loop->GetBody());
+				}
+				else if (const auto* list = dynamic_cast<const ast::ListLiteral*>(&statement)) {
+					VisitAll(list->GetItems());
+				}
+				else if (const auto* dict = dynamic_cast<const ast::DictLiteral*>(&statement)) {
+					for (const auto& [key, value] : dict->GetItems()) {
+						Visit(*key);
+						Visit(*value);
+					}
+				}
+				else if (const auto* index = dynamic_cast<const ast::Index*>(&statement)) {
+					Visit(index->GetObject());
+					Visit(index->GetIndex());
+				}
+				else if (const auto* assignment = dynamic_cast<const ast::IndexAssignment*>(&statement)) {
+					Visit(assignment->GetObject());
+					Visit(assignment->GetIndex());
+					Visit(assignment->GetValue());
+				}
+				else if (const auto* return_statement = dynamic_cast<const ast::Return*>(&statement)) {
+					Visit(return_statement->GetStatement());
+				}
+				else if (const auto* body = dynamic_cast<const ast::MethodBody*>(&statement)) {
+					Visit(body->GetBody());
+				}
+			}
+
+			// Собирает места вызовов в телах найденных методов. Вызывается после обхода программы,
+			// когда вектор methods_ больше не растёт
+			void VisitMethods() {
+				for (const MethodRow& row : methods_) {
+					owner_ = row;
+					Visit(*row.method->body);
+				}
+				owner_ = {};
+			}
+
+			vector<MethodRow>& GetMethods() {
+				return methods_;
+			}
+
+			vector<CallSiteRow>& GetCallSites() {
+				return call_sites_;
+			}
+
+		private:
+			void VisitAll(const vector<unique_ptr<ast::Statement>>& statements) {
+				for (const auto& statement : statements) {
+					Visit(*statement);
+				}
+			}
+
+			vector<MethodRow> methods_;
+			vector<CallSiteRow> call_sites_;
+			MethodRow owner_{};
+		};
+
+		string_view ToString(runtime::Tier tier) {
+			switch (tier) {
+			case runtime::Tier::Interpreter:
+				return "interpreter"sv;
+			case runtime::Tier::Native:
+				return "native"sv;
+			}
+			return "unknown"sv;
+		}
+
+		string MethodName(const MethodRow& row) {
+			return row.cls->GetName() + "."s + row.method->name;
+		}
+
+		// Текст вызова: obj.method/число аргументов. Для сложных выражений объекта выводится <expr>
+		string CallText(const ast::MethodCall& call) {
+			string object;
+			if (const auto* variable = dynamic_cast<const ast::VariableValue*>(&call.GetObject())) {
+				for (const string& id : variable->GetDottedIds()) {
+					object += object.empty() ? id : "."s + id;
+				}
+			}
+			else {
+				object = "<expr>"s;
+			}
+			return object + "."s + call.GetMethodName() + "/"s + to_string(call.GetArgs().size());
+		}
+
+	}  // namespace
+
+	void Dump(const ast::Statement& program, ostream& out) {
+		Collector collector;
+		collector.Visit(program);
+		collector.VisitMethods();
+
+		auto& methods = collector.GetMethods();
+		stable_sort(methods.begin(), methods.end(), [](const MethodRow& lhs, const MethodRow& rhs) {
+			return lhs.method->profile.calls > rhs.method->profile.calls;
+		});
+		out << "Methods:\n"sv;
+		out << setw(12) << "calls"sv << setw(12) << "native"sv << setw(8) << "deopts"sv
+			<< "  "sv << setw(12) << left << "tier"sv << right << "method\n"sv;
+		for (const MethodRow& row : methods) {
+			const runtime::MethodProfile& profile = row.method->profile;
+			out << setw(12) << profile.calls << setw(12) << profile.native_calls << setw(8) << profile.deoptimizations
+				<< "  "sv << setw(12) << left << ToString(profile.tier) << right << MethodName(row) << '\n';
+		}
+
+		auto& call_sites = collector.GetCallSites();
+		stable_sort(call_sites.begin(), call_sites.end(), [](const CallSiteRow& lhs, const CallSiteRow& rhs) {
+			return lhs.call->GetExecutionCount() > rhs.call->GetExecutionCount();
+		});
+		out << "Call sites:\n"sv;
+		out << setw(12) << "executions"sv << "  site\n"sv;
+		for (const CallSiteRow& row : call_sites) {
+			out << setw(12) << row.call->GetExecutionCount() << "  "sv
+				<< (row.owner.method ? MethodName(row.owner) : "<module>"s) << ": "sv << CallText(*row.call) << '\n';
+		}
+	}
+
+}  // namespace profile
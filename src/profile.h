@@ -0,0 +1,18 @@
+#pragma once
+
+#include "statement.h"
+
+#include <ostream>
+
+namespace profile {
+
+	/*
+	Выводит счётчики выполнения программы после её запуска:
+	  - для каждого метода каждого класса - число вызовов, число вызовов машинным кодом,
+	    число деоптимизаций и текущее представление (runtime::MethodProfile);
+	  - для каждого места вызова метода (ast::MethodCall) - сколько раз оно выполнялось.
+	Строки каждой таблицы упорядочены по убыванию числа вызовов
+	*/
+	void Dump(const ast::Statement& program, std::ostream& out);
+
+}  // namespace profile
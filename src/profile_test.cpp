@@ -0,0 +1,55 @@
+#include "lexer.h"
+#include "parse.h"
+#include "profile.h"
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace profile {
+
+	namespace {
+
+		void TestCountersAndDump() {
+			istringstream is(R"(
+class Calc:
+  def twice(x):
+    return x + x
+
+  def sum(n):
+    if n == 0:
+      return 0
+    return self.twice(n) + self.sum(n - 1)
+
+c = Calc()
+print c.sum(10)
+)"s);
+			parse::Lexer lexer(is);
+			auto tree = ParseProgram(lexer);
+			runtime::DummyContext context;
+			runtime::Closure closure;
+			tree->Execute(closure, context);
+			ASSERT_EQUAL(context.output.str(), "110\n"s);
+
+			const auto* calc = closure.at("Calc"s).TryAs<runtime::Class>();
+			ASSERT(calc != nullptr);
+			ASSERT_EQUAL(calc->GetMethod("sum"s)->profile.calls, 11u);
+			ASSERT_EQUAL(calc->GetMethod("twice"s)->profile.calls, 10u);
+
+			ostringstream out;
+			Dump(*tree, out);
+			const string dump = out.str();
+			ASSERT(dump.find("          11           0       0  interpreter Calc.sum\n"s) != string::npos);
+			ASSERT(dump.find("          10  Calc.sum: self.twice/1\n"s) != string::npos);
+			ASSERT(dump.find("           1  <module>: c.sum/1\n"s) != string::npos);
+			// Строки упорядочены по убыванию числа вызовов
+			ASSERT(dump.find("Calc.sum\n"s) < dump.find("Calc.twice\n"s));
+			ASSERT(dump.find("self.sum/1\n"s) < dump.find("c.sum/1\n"s));
+		}
+
+	}  // namespace
+
+	void RunProfileTests(TestRunner& tr) {
+		RUN_TEST(tr, profile::TestCountersAndDump);
+	}
+
+}  // namespace profile
@@ -2,21 +2,116 @@
 
 #include <algorithm>
 #include <cassert>
+#include <charconv>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <new>
 #include <optional>
 #include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 using namespace std;
 
 namespace runtime {
 
 	namespace {
-		const string STR_METHOD = "__str__"s;
-		const string EQ_METHOD = "__eq__"s;
-		const string LT_METHOD = "__lt__"s;
+		// Пул текущего потока (см. ObjectPool::ForThread), пока он существует
+		thread_local ObjectPool* current_pool = nullptr;
+		// Счёт памяти, активный в текущем потоке (см. MemoryAccount::Scope)
+		thread_local MemoryAccount* active_account = nullptr;
+
+		// Записи счетов памяти по их номерам; номер 0 означает, что объект не записан на счёт.
+		// Запись занята, пока жив её счёт или на неё записаны живые объекты
+		struct Ledger {
+			std::atomic<MemoryAccount*> owner{ nullptr };
+			std::atomic<size_t> usage{ 0u };
+		};
+		Ledger ledgers[MemoryAccount::MAX_ACCOUNTS + 1u];
+
+		// Имена специальных методов в порядке перечисления SpecialMethod
+		const string SPECIAL_METHOD_NAMES[SPECIAL_METHOD_COUNT] = {
+			"__init__"s, "__str__"s, "__eq__"s, "__lt__"s, "__add__"s, "__cmp__"s
+		};
 	} // namespace
 
-	ObjectHolder::ObjectHolder(std::shared_ptr<Object> data)
-		: data_(std::move(data)) {
+	void Object::Destroy() noexcept {
+		if (account_ != 0u) {
+			MemoryAccount::Release(account_, size_ + payload_);
+		}
+		switch (storage_) {
+		case Storage::Unmanaged:
+			break;
+		case Storage::Heap:
+			delete this;
+			break;
+		case Storage::Pool: {
+			// В пуле размещаются только экземпляры классов (см. Class::CreateInstance)
+			InstancePool* pool = static_cast<ClassInstance*>(this)->pool_;
+			const size_t size = size_;
+			this->~Object();
+			pool->Deallocate(this, size);
+			break;
+		}
+		case Storage::Frame: {
+			const size_t size = size_;
+			this->~Object();
+			FrameArena::Deallocate(this, size);
+			break;
+		}
+		case Storage::Shared: {
+			const size_t size = size_;
+			this->~Object();
+			ObjectPool::Deallocate(this, size);
+			break;
+		}
+		}
+	}
+
+	void Object::ChargePayload() {
+		const size_t payload = std::min<size_t>(GetPayloadSize(), std::numeric_limits<uint32_t>::max());
+		const size_t charged = payload_;
+		if (payload < charged) {
+			MemoryAccount::Release(account_, charged - payload);
+		}
+		else if (payload > charged) {
+			// Пределы проверяются, только если объект растёт в потоке, где его счёт активен
+			if (active_account && active_account->id_ == account_) {
+				active_account->Charge(payload - charged);
+			}
+			else {
+				ledgers[account_].usage.fetch_add(payload - charged, std::memory_order_relaxed);
+			}
+		}
+		payload_ = static_cast<uint32_t>(payload);
+	}
+
+	ObjectHolder::ObjectHolder(Object* data) noexcept
+		: data_(data) {
+		if (data_) {
+			data_->AddRef();
+		}
+	}
+
+	ObjectHolder ObjectHolder::Adopt(Object* object, Storage storage, size_t size) {
+		assert(object->storage_ == Storage::Unmanaged && size <= std::numeric_limits<uint16_t>::max());
+		object->ref_count_.store(0u, std::memory_order_relaxed);
+		object->storage_ = storage;
+		object->size_ = static_cast<uint16_t>(size);
+		ObjectHolder holder(object);
+		if (MemoryAccount* account = active_account) {
+			// Если предел превышен, объект освобождается вместе с holder и возвращает учтённую память
+			account->Charge(size);
+			object->account_ = account->id_;
+			object->ChargePayload();
+		}
+		return holder;
 	}
 
 	void ObjectHolder::AssertIsValid() const {
@@ -24,8 +119,7 @@ namespace runtime {
 	}
 
 	ObjectHolder ObjectHolder::Share(Object& object) {
-		// Возвращаем невладеющий shared_ptr (его deleter ничего не делает)
-		return ObjectHolder(std::shared_ptr<Object>(&object, [](auto* /*p*/) { /* do nothing */ }));
+		return ObjectHolder(&object);
 	}
 
 	ObjectHolder ObjectHolder::None() {
@@ -43,28 +137,178 @@ namespace runtime {
 	}
 
 	Object* ObjectHolder::Get() const {
-		return data_.get();
+		return data_;
 	}
 
 	ObjectHolder::operator bool() const {
 		return Get() != nullptr;
 	}
 
-	bool IsTrue(const ObjectHolder& object) {		
-		if (const Number* number_ptr = object.TryAs<Number>()) {
-			return number_ptr->GetValue() != 0;
+	Closure::Closure(std::initializer_list<std::pair<std::string, ObjectHolder>> items) {
+		for (const auto& [name, value] : items) {
+			(*this)[name] = value;
+		}
+	}
+
+	Closure::iterator Closure::find(const std::string& name) {
+		const size_t index = Find(name);
+		return { this, index != NOT_FOUND && entries_[index].bound ? index : entries_.size() };
+	}
+
+	Closure::const_iterator Closure::find(const std::string& name) const {
+		const size_t index = Find(name);
+		return { this, index != NOT_FOUND && entries_[index].bound ? index : entries_.size() };
+	}
+
+	ObjectHolder& Closure::at(const std::string& name) {
+		return const_cast<ObjectHolder&>(std::as_const(*this).at(name));
+	}
+
+	const ObjectHolder& Closure::at(const std::string& name) const {
+		const size_t index = Find(name);
+		if (index == NOT_FOUND || !entries_[index].bound) {
+			throw std::out_of_range("Variable "s + name + " not found"s);
+		}
+		return entries_[index].item.second;
+	}
+
+	ObjectHolder& Closure::operator[](const std::string& name) {
+		Entry& entry = entries_[Declare(name)];
+		if (!entry.bound) {
+			entry.bound = true;
+			++size_;
+		}
+		return entry.item.second;
+	}
+
+	std::pair<Closure::iterator, bool> Closure::insert(std::pair<std::string, ObjectHolder> item) {
+		const size_t index = Declare(item.first);
+		Entry& entry = entries_[index];
+		if (entry.bound) {
+			return { iterator{ this, index }, false };
+		}
+		Bind(index, std::move(item.second));
+		return { iterator{ this, index }, true };
+	}
+
+	Closure::iterator Closure::erase(iterator it) {
+		Entry& entry = entries_[it.index_];
+		entry.bound = false;
+		entry.item.second = ObjectHolder::None();
+		--size_;
+		return { this, it.index_ + 1u };
+	}
+
+	size_t Closure::erase(const std::string& name) {
+		const auto it = find(name);
+		if (it == end()) {
+			return 0u;
+		}
+		erase(it);
+		return 1u;
+	}
+
+	void Closure::clear() {
+		for (size_t i = 0u; size_ > 0u; ++i) {
+			Entry& entry = entries_[i];
+			if (entry.bound) {
+				entry.bound = false;
+				entry.item.second = ObjectHolder::None();
+				--size_;
+			}
+		}
+	}
+
+	size_t Closure::Declare(const std::string& name) {
+		const size_t index = Find(name);
+		return index != NOT_FOUND ? index : Insert(name);
+	}
+
+	void Closure::Bind(size_t index, ObjectHolder value) {
+		Entry& entry = entries_[index];
+		if (!entry.bound) {
+			entry.bound = true;
+			++size_;
+		}
+		entry.item.second = std::move(value);
+	}
+
+	size_t Closure::Find(const std::string& name) const {
+		if (index_.empty()) {
+			for (size_t i = 0u; i < entries_.size(); ++i) {
+				if (entries_[i].item.first == name) {
+					return i;
+				}
+			}
+			return NOT_FOUND;
 		}
-		else if (const String* string_ptr = object.TryAs<String>()) {
-			return !string_ptr->GetValue().empty();
-		} else if (const Bool* bool_ptr = object.TryAs<Bool>()) {
-			return bool_ptr->GetValue();
+		const size_t mask = index_.size() - 1u;
+		for (size_t slot = std::hash<std::string>{}(name) & mask;; slot = (slot + 1u) & mask) {
+			const uint32_t index = index_[slot];
+			if (index == EMPTY_SLOT) {
+				return NOT_FOUND;
+			}
+			if (entries_[index].item.first == name) {
+				return index;
+			}
+		}
+	}
+
+	size_t Closure::Insert(const std::string& name) {
+		entries_.push_back({ { name, ObjectHolder::None() }, false });
+		const size_t index = entries_.size() - 1u;
+		if (entries_.size() <= LINEAR_LIMIT) {
+			return index;
+		}
+		// Индекс заполнен не больше чем наполовину
+		if (entries_.size() * 2u > index_.size()) {
+			index_.assign(std::max<size_t>(index_.size() * 2u, LINEAR_LIMIT * 4u), EMPTY_SLOT);
+			for (size_t i = 0u; i < entries_.size(); ++i) {
+				AddToIndex(i);
+			}
+		}
+		else {
+			AddToIndex(index);
+		}
+		return index;
+	}
+
+	void Closure::AddToIndex(size_t index) {
+		const size_t mask = index_.size() - 1u;
+		size_t slot = std::hash<std::string>{}(entries_[index].item.first) & mask;
+		while (index_[slot] != EMPTY_SLOT) {
+			slot = (slot + 1u) & mask;
+		}
+		index_[slot] = static_cast<uint32_t>(index);
+	}
+
+	size_t Closure::SkipFree(size_t index) const {
+		while (index < entries_.size() && !entries_[index].bound) {
+			++index;
+		}
+		return index;
+	}
+
+	bool IsTrue(const ObjectHolder& object) {
+		switch (object.GetType()) {
+		case ObjectType::Number:
+			return static_cast<const Number*>(object.Get())->GetValue() != 0;
+		case ObjectType::String:
+			return !static_cast<const String*>(object.Get())->GetValue().empty();
+		case ObjectType::Bool:
+			return static_cast<const Bool*>(object.Get())->GetValue();
+		case ObjectType::List:
+			return static_cast<const List*>(object.Get())->Size() != 0u;
+		case ObjectType::Dict:
+			return static_cast<const Dict*>(object.Get())->Size() != 0u;
+		default:
+			return false;
 		}
-		return false;
 	}
 
 	void ClassInstance::Print(std::ostream& os, Context& context) {
-		if (HasMethod(STR_METHOD, 0u)) {
-			Call(STR_METHOD, {}, context)->Print(os, context);
+		if (const Method* str_method = FindMethod(SpecialMethod::Str, 0u)) {
+			Call(*str_method, {}, context)->Print(os, context);
 		}
 		else {
 			os << this;
@@ -72,56 +316,597 @@ namespace runtime {
 	}
 
 	bool ClassInstance::HasMethod(const std::string& method, size_t argument_count) const {
+		return FindMethod(method, argument_count) != nullptr;
+	}
+
+	const Method* ClassInstance::FindMethod(const std::string& method, size_t argument_count) const {
+		const Method* method_ptr = cls_.GetMethod(method);
+		return method_ptr && method_ptr->formal_params.size() == argument_count ? method_ptr : nullptr;
+	}
+
+	const Method* ClassInstance::FindMethod(SpecialMethod method, size_t argument_count) const {
 		const Method* method_ptr = cls_.GetMethod(method);
-		return method_ptr && method_ptr->formal_params.size() == argument_count;
+		return method_ptr && method_ptr->formal_params.size() == argument_count ? method_ptr : nullptr;
 	}
 
-	Closure& ClassInstance::Fields() {
+	InstanceFields& ClassInstance::Fields() {
 		return fields_;
 	}
 
-	const Closure& ClassInstance::Fields() const {
+	const InstanceFields& ClassInstance::Fields() const {
 		return fields_;
 	}
 
 	ClassInstance::ClassInstance(const Class& cls)
-		: cls_(cls) {
+		: Container(TYPE)
+		, cls_(cls)
+		, fields_(cls.GetRootShape()) {
+	}
+
+	Shape::Shape()
+		: root_(this) {
+	}
+
+	Shape::Shape(const Shape& parent, const std::string& name)
+		: root_(parent.root_)
+		, field_names_(parent.field_names_)
+		, slots_(parent.slots_) {
+		slots_.emplace(name, field_names_.size());
+		field_names_.push_back(name);
+		root_->max_field_count_ = std::max(root_->max_field_count_, field_names_.size());
+	}
+
+	size_t Shape::FindSlot(const std::string& name) const {
+		const auto it = slots_.find(name);
+		return it != slots_.end() ? it->second : NO_SLOT;
+	}
+
+	const Shape* Shape::AddField(const std::string& name) const {
+		assert(FindSlot(name) == NO_SLOT);
+		auto& transition = transitions_[name];
+		if (!transition) {
+			transition.reset(new Shape(*this, name));
+		}
+		return transition.get();
+	}
+
+	InstanceFields::InstanceFields(const Shape& root)
+		: shape_(&root) {
+		values_.reserve(root.GetExpectedFieldCount());
+	}
+
+	ObjectHolder& InstanceFields::operator[](const std::string& name) {
+		if (const size_t slot = shape_->FindSlot(name); slot != Shape::NO_SLOT) {
+			return values_[slot];
+		}
+		return AddSlot(shape_->AddField(name), ObjectHolder::None());
+	}
+
+	ObjectHolder& InstanceFields::at(const std::string& name) {
+		return const_cast<ObjectHolder&>(std::as_const(*this).at(name));
+	}
+
+	const ObjectHolder& InstanceFields::at(const std::string& name) const {
+		const size_t slot = shape_->FindSlot(name);
+		if (slot == Shape::NO_SLOT) {
+			throw std::out_of_range("Field "s + name + " not found"s);
+		}
+		return values_[slot];
+	}
+
+	InstanceFields::iterator InstanceFields::find(const std::string& name) {
+		const size_t slot = shape_->FindSlot(name);
+		return { this, slot != Shape::NO_SLOT ? slot : values_.size() };
+	}
+
+	InstanceFields::const_iterator InstanceFields::find(const std::string& name) const {
+		const size_t slot = shape_->FindSlot(name);
+		return { this, slot != Shape::NO_SLOT ? slot : values_.size() };
+	}
+
+	ObjectHolder& InstanceFields::AddSlot(const Shape* new_shape, ObjectHolder value) {
+		assert(new_shape->GetFieldCount() == values_.size() + 1u);
+		shape_ = new_shape;
+		return values_.emplace_back(std::move(value));
 	}
 
 	ObjectHolder ClassInstance::Call(const std::string& method,
-		const std::vector<ObjectHolder>& actual_args,
+		Arguments actual_args,
 		Context& context) {
-		if (!HasMethod(method, actual_args.size())) {
+		const Method* method_ptr = FindMethod(method, actual_args.size());
+		if (!method_ptr) {
 			throw std::runtime_error("Class "s + cls_.GetName() + " does not implement "s + method + " method with "s + std::to_string(actual_args.size()) + " parameters"s);
 		}
-		const Method* method_ptr = cls_.GetMethod(method);
-		Closure closure;
-		closure["self"s] = ObjectHolder::Share(*this);
-		for (auto i = 0u; i < actual_args.size(); ++i) {
-			closure[method_ptr->formal_params[i]] = actual_args[i];
+		return Call(*method_ptr, actual_args, context);
+	}
+
+	namespace {
+
+		// Связывает self и параметры метода method в кадре frame, в котором нет переменных.
+		// Номера переменных кадра для self и параметров вычисляются при первом вызове method
+		// в этом кадре, а затем аргументы связываются по позиции
+		template <typename Value>
+		void BindParameters(Frame& frame, const Method& method, ObjectHolder self, Value* args) {
+			if (frame.method != &method) {
+				frame.method = &method;
+				frame.slots.clear();
+				frame.slots.push_back(frame.locals.Declare("self"s));
+				for (const std::string& param : method.formal_params) {
+					frame.slots.push_back(frame.locals.Declare(param));
+				}
+			}
+			frame.locals.Bind(frame.slots[0], std::move(self));
+			for (size_t i = 1u; i < frame.slots.size(); ++i) {
+				if constexpr (std::is_const_v<Value>) {
+					frame.locals.Bind(frame.slots[i], args[i - 1u]);
+				}
+				else {
+					frame.locals.Bind(frame.slots[i], std::move(args[i - 1u]));
+				}
+			}
+		}
+
+	}  // namespace
+
+	ObjectHolder ClassInstance::Call(const Method& method,
+		Arguments actual_args,
+		Context& context) {
+		assert(method.formal_params.size() == actual_args.size());
+		++method.profile.calls;
+		if (CallCache* cache = context.GetCallCache()) {
+			if (std::optional<ObjectHolder> result = cache->TryCall(*this, method, actual_args, context)) {
+				return std::move(*result);
+			}
+		}
+		return Invoke(method, actual_args, context);
+	}
+
+	ObjectHolder ClassInstance::Invoke(const Method& method,
+		Arguments actual_args,
+		Context& context) {
+		if (MethodCompiler* compiler = context.GetMethodCompiler()) {
+			if (std::optional<ObjectHolder> result = compiler->TryCall(*this, method, actual_args, context)) {
+				return std::move(*result);
+			}
+		}
+
+		struct FrameGuard {
+			Context& context;
+			Frame& frame;
+			explicit FrameGuard(Context& ctx)
+				: context(ctx)
+				, frame(ctx.PushFrame()) {
+			}
+			~FrameGuard() {
+				context.PopFrame();
+			}
+		} guard{ context };
+
+		Frame& frame = guard.frame;
+		BindParameters(frame, method, ObjectHolder::Share(*this), actual_args.begin());
+
+		ObjectHolder result = method.body->Execute(frame.locals, context);
+		// Хвостовые вызовы выполняются в цикле в кадре текущего вызова
+		while (TailCall* tail_call = context.GetTailCall()) {
+			const Method& next_method = *tail_call->method;
+			++next_method.profile.calls;
+			frame.locals.clear();
+			BindParameters(frame, next_method, std::move(tail_call->object), tail_call->args.data());
+			context.ClearTailCall();
+			result = next_method.body->Execute(frame.locals, context);
+		}
+		return result;
+	}
+
+	Frame& Context::PushFrame() {
+		if (call_depth_ >= max_call_depth_) {
+			throw std::runtime_error("Maximum recursion depth exceeded"s);
+		}
+		if (call_depth_ == frames_.size()) {
+			frames_.push_back(std::make_unique<Frame>());
+		}
+		return *frames_[call_depth_++];
+	}
+
+	void Context::PopFrame() {
+		frames_[--call_depth_]->locals.clear();
+	}
+
+	static_assert(ObjectPool::SIZE_STEP % alignof(std::max_align_t) == 0u);
+	static_assert(ObjectPool::HUGE_PAGE_SIZE % ObjectPool::SLAB_SIZE == 0u);
+
+	ObjectPool::ObjectPool(bool thread_pool) {
+		for (size_t i = 0u; i < SIZE_CLASS_COUNT; ++i) {
+			size_classes_[i].stats.block_size = (i + 1u) * SIZE_STEP;
+		}
+		if (thread_pool) {
+			current_pool = this;
+		}
+	}
+
+	ObjectPool::~ObjectPool() {
+		if (current_pool == this) {
+			current_pool = nullptr;
+		}
+		CollectRemoteFrees();
+		size_t live = 0u;
+		for (const SizeClass& size_class : size_classes_) {
+			live += size_class.stats.live;
+		}
+		if (live == 0u) {
+			for (const auto& [chunk, size] : chunks_) {
+				::operator delete(chunk, std::align_val_t{ size });
+			}
+			return;
+		}
+		// Блоки, пережившие пул, возвращаются в списки своих страниц, а страницы не освобождаются
+		for (SizeClass& size_class : size_classes_) {
+			for (Slab* slab = size_class.slabs; slab; slab = slab->next) {
+				slab->owner.store(nullptr, std::memory_order_release);
+			}
+		}
+	}
+
+	void ObjectPool::Deallocate(void* block, size_t size) noexcept {
+		auto* slab = reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(block) & ~uintptr_t{ SLAB_SIZE - 1u });
+		auto* free_block = static_cast<FreeBlock*>(block);
+		ObjectPool* owner = slab->owner.load(std::memory_order_relaxed);
+		if (owner && owner == current_pool) {
+			SizeClass& size_class = owner->size_classes_[(size - 1u) / SIZE_STEP];
+			free_block->next = size_class.free;
+			size_class.free = free_block;
+			--size_class.stats.live;
+			return;
+		}
+		FreeBlock* head = slab->remote_free.load(std::memory_order_relaxed);
+		do {
+			free_block->next = head;
+		} while (!slab->remote_free.compare_exchange_weak(head, free_block, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	size_t ObjectPool::CollectRemoteFrees() {
+		size_t count = 0u;
+		for (SizeClass& size_class : size_classes_) {
+			count += CollectRemoteFrees(size_class);
+		}
+		return count;
+	}
+
+	size_t ObjectPool::CollectRemoteFrees(SizeClass& size_class) {
+		size_t count = 0u;
+		for (Slab* slab = size_class.slabs; slab; slab = slab->next) {
+			if (!slab->remote_free.load(std::memory_order_relaxed)) {
+				continue;
+			}
+			for (FreeBlock* block = slab->remote_free.exchange(nullptr, std::memory_order_acquire); block;) {
+				FreeBlock* next = block->next;
+				block->next = size_class.free;
+				size_class.free = block;
+				block = next;
+				++count;
+			}
+		}
+		size_class.stats.remote_frees += count;
+		size_class.stats.live -= count;
+		return count;
+	}
+
+	void* ObjectPool::Refill(SizeClass& size_class) {
+		if (CollectRemoteFrees(size_class) > 0u) {
+			FreeBlock* block = size_class.free;
+			size_class.free = block->next;
+			++size_class.stats.reused;
+			return block;
+		}
+		Slab* slab = NewSlab();
+		slab->next = size_class.slabs;
+		size_class.slabs = slab;
+		const size_t block_size = size_class.stats.block_size;
+		const size_t block_count = (SLAB_SIZE - HEADER_SIZE) / block_size;
+		size_class.stats.capacity += block_count;
+		std::byte* block = reinterpret_cast<std::byte*>(slab) + HEADER_SIZE;
+		size_class.next = block + block_size;
+		size_class.end = block + block_count * block_size;
+		return block;
+	}
+
+	ObjectPool::Slab* ObjectPool::NewSlab() {
+		if (chunk_next_ == chunk_end_) {
+			const size_t size = huge_pages_ ? HUGE_PAGE_SIZE : SLAB_SIZE;
+			void* chunk = ::operator new(size, std::align_val_t{ size });
+#ifdef __linux__
+			if (huge_pages_) {
+				// Подсказка ядру; без поддержки огромных страниц память остаётся обычной
+				madvise(chunk, size, MADV_HUGEPAGE);
+			}
+#endif
+			chunks_.emplace_back(chunk, size);
+			reserved_bytes_ += size;
+			chunk_next_ = static_cast<std::byte*>(chunk);
+			chunk_end_ = chunk_next_ + size;
+		}
+		auto* slab = new (chunk_next_) Slab{ this, nullptr, nullptr };
+		chunk_next_ += SLAB_SIZE;
+		return slab;
+	}
+
+	std::vector<ObjectPool::SizeClassStats> ObjectPool::GetStats() const {
+		std::vector<SizeClassStats> stats;
+		for (const SizeClass& size_class : size_classes_) {
+			if (size_class.stats.allocations > 0u) {
+				stats.push_back(size_class.stats);
+			}
+		}
+		return stats;
+	}
+
+	void ObjectPool::Dump(std::ostream& out) const {
+		out << "Object pool:\n"sv;
+		out << std::setw(8) << "block"sv << std::setw(14) << "allocations"sv << std::setw(8) << "hit %"sv
+			<< std::setw(10) << "live"sv << std::setw(10) << "capacity"sv << std::setw(8) << "used %"sv
+			<< std::setw(10) << "remote"sv << '\n';
+		for (const SizeClassStats& stats : GetStats()) {
+			const double hit_rate = 100.0 * static_cast<double>(stats.reused) / static_cast<double>(stats.allocations);
+			const double occupancy = stats.capacity > 0u
+				? 100.0 * static_cast<double>(stats.live) / static_cast<double>(stats.capacity)
+				: 0.0;
+			out << std::setw(8) << stats.block_size << std::setw(14) << stats.allocations << std::setw(8) << std::fixed
+				<< std::setprecision(1) << hit_rate << std::setw(10) << stats.live << std::setw(10) << stats.capacity
+				<< std::setw(8) << occupancy << std::setw(10) << stats.remote_frees << '\n';
+		}
+		out << "  reserved: "sv << reserved_bytes_ / 1024u << " KiB"sv << (huge_pages_ ? ", huge pages requested\n"sv : "\n"sv);
+	}
+
+	MemoryAccount::Scope::Scope(MemoryAccount& account)
+		: previous_(std::exchange(active_account, &account)) {
+	}
+
+	MemoryAccount::Scope::~Scope() {
+		active_account = previous_;
+	}
+
+	MemoryAccount::MemoryAccount() {
+		for (size_t id = 1u; id <= MAX_ACCOUNTS; ++id) {
+			Ledger& ledger = ledgers[id];
+			MemoryAccount* expected = nullptr;
+			if (ledger.usage.load(std::memory_order_acquire) == 0u
+				&& ledger.owner.compare_exchange_strong(expected, this, std::memory_order_acq_rel)) {
+				id_ = static_cast<uint8_t>(id);
+				return;
+			}
+		}
+		throw std::runtime_error("Too many memory accounts"s);
+	}
+
+	MemoryAccount::~MemoryAccount() {
+		if (active_account == this) {
+			active_account = nullptr;
+		}
+		ledgers[id_].owner.store(nullptr, std::memory_order_release);
+	}
+
+	MemoryAccount* MemoryAccount::GetActive() {
+		return active_account;
+	}
+
+	size_t MemoryAccount::GetUsage() const {
+		return ledgers[id_].usage.load(std::memory_order_relaxed);
+	}
+
+	void MemoryAccount::SetSoftLimit(size_t limit, SoftLimitHandler handler) {
+		soft_limit_ = limit;
+		soft_limit_handler_ = std::move(handler);
+		soft_limit_reached_ = false;
+	}
+
+	void MemoryAccount::Charge(size_t size) {
+		std::atomic<size_t>& ledger_usage = ledgers[id_].usage;
+		const size_t usage = ledger_usage.fetch_add(size, std::memory_order_relaxed) + size;
+		if (usage > hard_limit_) {
+			ledger_usage.fetch_sub(size, std::memory_order_relaxed);
+			throw std::runtime_error("Memory limit exceeded: "s + std::to_string(usage) + " bytes would be in use, limit is "s
+				+ std::to_string(hard_limit_));
+		}
+		peak_ = std::max(peak_, usage);
+		if (usage <= soft_limit_) {
+			soft_limit_reached_ = false;
+		}
+		else if (!soft_limit_reached_) {
+			soft_limit_reached_ = true;
+			if (soft_limit_handler_) {
+				soft_limit_handler_(*this);
+			}
+		}
+	}
+
+	void MemoryAccount::Release(uint8_t id, size_t size) noexcept {
+		ledgers[id].usage.fetch_sub(size, std::memory_order_release);
+	}
+
+	FrameArena::~FrameArena() {
+		for (Page* page = used_pages_; page;) {
+			Page* next = page->next;
+			if (page->live > 0u) {
+				page->owner = nullptr;
+			}
+			else {
+				::operator delete(page, std::align_val_t{ PAGE_SIZE });
+			}
+			page = next;
+		}
+		for (Page* page = free_pages_; page;) {
+			Page* next = page->next;
+			::operator delete(page, std::align_val_t{ PAGE_SIZE });
+			page = next;
 		}
-		return method_ptr->body->Execute(closure, context);
+	}
+
+	void* FrameArena::Allocate(size_t size) {
+		size = (size + alignof(std::max_align_t) - 1u) / alignof(std::max_align_t) * alignof(std::max_align_t);
+		if (size == 0u || size > MAX_BLOCK_SIZE) {
+			return ::operator new(size);
+		}
+		if (!current_ || current_->used + size > PAGE_SIZE) {
+			NextPage();
+		}
+		void* block = reinterpret_cast<std::byte*>(current_) + current_->used;
+		current_->used += size;
+		++current_->live;
+		++live_count_;
+		return block;
+	}
+
+	void FrameArena::Deallocate(void* block, size_t size) noexcept {
+		size = (size + alignof(std::max_align_t) - 1u) / alignof(std::max_align_t) * alignof(std::max_align_t);
+		if (size == 0u || size > MAX_BLOCK_SIZE) {
+			::operator delete(block);
+			return;
+		}
+		auto* page = reinterpret_cast<Page*>(reinterpret_cast<uintptr_t>(block) & ~uintptr_t{ PAGE_SIZE - 1u });
+		FrameArena* owner = page->owner;
+		if (owner) {
+			--owner->live_count_;
+		}
+		if (--page->live > 0u) {
+			return;
+		}
+		if (owner) {
+			owner->Recycle(page);
+		}
+		else {
+			::operator delete(page, std::align_val_t{ PAGE_SIZE });
+		}
+	}
+
+	void FrameArena::NextPage() {
+		Page* page = free_pages_;
+		if (page) {
+			free_pages_ = page->next;
+		}
+		else {
+			page = static_cast<Page*>(::operator new(PAGE_SIZE, std::align_val_t{ PAGE_SIZE }));
+			++page_count_;
+		}
+		*page = { this, nullptr, used_pages_, 0u, HEADER_SIZE };
+		if (used_pages_) {
+			used_pages_->prev = page;
+		}
+		used_pages_ = page;
+		current_ = page;
+	}
+
+	void FrameArena::Recycle(Page* page) noexcept {
+		if (page == current_) {
+			// Текущая страница остаётся текущей и заполняется заново
+			page->used = HEADER_SIZE;
+			return;
+		}
+		if (page->prev) {
+			page->prev->next = page->next;
+		}
+		else {
+			used_pages_ = page->next;
+		}
+		if (page->next) {
+			page->next->prev = page->prev;
+		}
+		page->next = free_pages_;
+		free_pages_ = page;
 	}
 
 	Class::Class(std::string name, std::vector<Method> methods, const Class* parent)
-		: name_(std::move(name))
+		: Object(TYPE)
+		, name_(std::move(name))
 		, methods_(std::move(methods))
-		, parent_(parent) {
+		, parent_(parent)
+		, root_shape_(std::make_unique<Shape>()) {
+		if (parent_) {
+			method_table_ = parent_->method_table_;
+		}
+		for (const Method& method : methods_) {
+			method_table_[method.name] = &method;
+		}
+		for (size_t i = 0u; i < SPECIAL_METHOD_COUNT; ++i) {
+			special_methods_[i] = GetMethod(SPECIAL_METHOD_NAMES[i]);
+		}
 	}
 
 	const Method* Class::GetMethod(const std::string& name) const {
-		const auto method_it = std::find_if(methods_.begin(), methods_.end(),
-			[&name](const Method& m) {
-				return m.name == name;
-			}
-		);
-		if (method_it != methods_.end()) {
-			return &(*method_it);
+		const auto method_it = method_table_.find(name);
+		return method_it != method_table_.end() ? method_it->second : nullptr;
+	}
+
+	static_assert(InstancePool::SIZE_STEP % alignof(std::max_align_t) == 0u);
+
+	void InstancePool::Release() noexcept {
+		released_ = true;
+		if (live_count_ == 0u) {
+			delete this;
 		}
-		else if (!parent_) {
-			return nullptr;
+	}
+
+	void* InstancePool::Allocate(size_t size) {
+		if (size == 0u || size > MAX_BLOCK_SIZE) {
+			void* block = ::operator new(size);
+			++live_count_;
+			return block;
 		}
-		return parent_->GetMethod(name);
+		const size_t size_class = (size - 1u) / SIZE_STEP;
+		if (!free_lists_[size_class]) {
+			Refill(size_class);
+		}
+		FreeBlock* block = free_lists_[size_class];
+		free_lists_[size_class] = block->next;
+		++live_count_;
+		return block;
+	}
+
+	void InstancePool::Deallocate(void* block, size_t size) noexcept {
+		if (size == 0u || size > MAX_BLOCK_SIZE) {
+			::operator delete(block);
+		}
+		else {
+			const size_t size_class = (size - 1u) / SIZE_STEP;
+			auto* free_block = static_cast<FreeBlock*>(block);
+			free_block->next = free_lists_[size_class];
+			free_lists_[size_class] = free_block;
+		}
+		if (--live_count_ == 0u && released_) {
+			delete this;
+		}
+	}
+
+	void InstancePool::Refill(size_t size_class) {
+		const size_t block_size = (size_class + 1u) * SIZE_STEP;
+		const size_t page_size = std::max(next_page_size_, block_size);
+		next_page_size_ = std::min(next_page_size_ * 2u, MAX_PAGE_SIZE);
+		// new[] выравнивает память не хуже max_align_t, а размер блока кратен SIZE_STEP
+		std::byte* page = pages_.emplace_back(new std::byte[page_size]).get();
+		reserved_bytes_ += page_size;
+		for (size_t offset = page_size / block_size * block_size; offset > 0u;) {
+			offset -= block_size;
+			auto* block = reinterpret_cast<FreeBlock*>(page + offset);
+			block->next = free_lists_[size_class];
+			free_lists_[size_class] = block;
+		}
+	}
+
+	ObjectHolder Class::CreateInstance() const {
+		void* block = instance_pool_->Allocate(sizeof(ClassInstance));
+		ClassInstance* instance;
+		try {
+			instance = new (block) ClassInstance(*this);
+		}
+		catch (...) {
+			instance_pool_->Deallocate(block, sizeof(ClassInstance));
+			throw;
+		}
+		instance->pool_ = instance_pool_.get();
+		return ObjectHolder::Adopt(instance, Storage::Pool, sizeof(ClassInstance));
+	}
+
+	ObjectHolder Class::CreateInstance(FrameArena& arena) const {
+		return arena.Create<ClassInstance>(*this);
 	}
 
 	void Class::Print(ostream& os, Context& /*context*/) {
@@ -132,69 +917,607 @@ namespace runtime {
 		os << (GetValue() ? "True"sv : "False"sv);
 	}
 
-	bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-		const Number* num_lhs_ptr = lhs.TryAs<Number>();
-		const Number* num_rhs_ptr = rhs.TryAs<Number>();
-		if (num_lhs_ptr && num_rhs_ptr) {
-			return num_lhs_ptr->GetValue() == num_rhs_ptr->GetValue();
+	namespace {
+		// Выводит элемент контейнера: строку - в одинарных кавычках, пустое значение - как None
+		void PrintItem(std::ostream& os, const ObjectHolder& item, Context& context) {
+			if (const String* str = item.TryAs<String>()) {
+				os << '\'' << str->GetValue() << '\'';
+			}
+			else if (item) {
+				item->Print(os, context);
+			}
+			else {
+				os << "None"sv;
+			}
 		}
-		const String* str_lhs_ptr = lhs.TryAs<String>();
-		const String* str_rhs_ptr = rhs.TryAs<String>();
-		if (str_lhs_ptr && str_rhs_ptr) {
-			return str_lhs_ptr->GetValue() == str_rhs_ptr->GetValue();
+
+		// Выполняет print_items, выставив флаг printing контейнера на время вывода
+		template <typename PrintItems>
+		void PrintContainer(bool& printing, PrintItems print_items) {
+			printing = true;
+			try {
+				print_items();
+			}
+			catch (...) {
+				printing = false;
+				throw;
+			}
+			printing = false;
 		}
-		const Bool* bool_lhs_ptr = lhs.TryAs<Bool>();
-		const Bool* bool_rhs_ptr = rhs.TryAs<Bool>();
-		if (bool_lhs_ptr && bool_rhs_ptr) {
-			return bool_lhs_ptr->GetValue() == bool_rhs_ptr->GetValue();
+	}  // namespace
+
+	void List::Print(std::ostream& os, Context& context) {
+		if (printing_) {
+			os << "[...]"sv;
+			return;
 		}
-		ClassInstance* cls_instance_ptr = lhs.TryAs<ClassInstance>();
-		if (cls_instance_ptr && cls_instance_ptr->HasMethod(EQ_METHOD, 1u)) {
-			return cls_instance_ptr->Call(EQ_METHOD, { rhs }, context).TryAs<Bool>()->GetValue();
+		PrintContainer(printing_, [&] {
+			os << '[';
+			// Индексы вместо итераторов: __str__ элемента может добавить элементы в список
+			for (size_t i = 0u; i < items_.size(); ++i) {
+				if (i > 0u) {
+					os << ", "sv;
+				}
+				PrintItem(os, ObjectHolder(items_[i]), context);
+			}
+			os << ']';
+		});
+	}
+
+	ObjectHolder& List::At(int index) {
+		return const_cast<ObjectHolder&>(std::as_const(*this).At(index));
+	}
+
+	const ObjectHolder& List::At(int index) const {
+		const auto size = static_cast<int64_t>(items_.size());
+		const int64_t position = index < 0 ? size + index : index;
+		if (position < 0 || position >= size) {
+			throw std::runtime_error("List index out of range"s);
 		}
-		if (!bool(lhs) && !bool(rhs)) {
-			return true;
+		return items_[static_cast<size_t>(position)];
+	}
+
+	void List::Clear() {
+		// Элементы уничтожаются после того, как список стал пустым: их деструкторы могут обратиться к нему
+		const std::vector<ObjectHolder> items = std::exchange(items_, {});
+		UpdateMemoryCharge();
+	}
+
+	bool List::HasMethod(const std::string& method, size_t argument_count) {
+		return method == "append"sv && argument_count == 1u;
+	}
+
+	ObjectHolder List::Call(const std::string& method, Arguments actual_args) {
+		if (!HasMethod(method, actual_args.size())) {
+			throw std::runtime_error("List has no method "s + method + " taking "s
+				+ std::to_string(actual_args.size()) + " arguments"s);
 		}
-		throw std::runtime_error("Cannot compare objects for equality"s);
+		Append(actual_args.front());
+		return ObjectHolder::None();
 	}
 
-	bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-		const Number* num_lhs_ptr = lhs.TryAs<Number>();
-		const Number* num_rhs_ptr = rhs.TryAs<Number>();
-		if (num_lhs_ptr && num_rhs_ptr) {
-			return num_lhs_ptr->GetValue() < num_rhs_ptr->GetValue();
+	namespace {
+		// Возвращает значение объекта-значения, тип которого уже проверен по тегу
+		template <typename T>
+		const auto& ValueOf(const ObjectHolder& object) {
+			return static_cast<const T*>(object.Get())->GetValue();
 		}
-		const String* str_lhs_ptr = lhs.TryAs<String>();
-		const String* str_rhs_ptr = rhs.TryAs<String>();
-		if (str_lhs_ptr && str_rhs_ptr) {
-			return str_lhs_ptr->GetValue() < str_rhs_ptr->GetValue();
+
+		// Тип объекта-значения, соответствующий тегу type, либо void
+		template <ObjectType type>
+		using ValueObjectOf = std::conditional_t<type == ObjectType::Number, Number,
+			std::conditional_t<type == ObjectType::String, String,
+			std::conditional_t<type == ObjectType::Bool, Bool, void>>>;
+
+		// Вызывает у lhs специальный метод method, принимающий один аргумент, и приводит результат к bool
+		std::optional<bool> CallComparisonMethod(ClassInstance& lhs, SpecialMethod method,
+			const ObjectHolder& rhs, Context& context) {
+			if (const Method* method_ptr = lhs.FindMethod(method, 1u)) {
+				return lhs.Call(*method_ptr, Arguments(&rhs, 1u), context).TryAs<Bool>()->GetValue();
+			}
+			return std::nullopt;
 		}
-		const Bool* bool_lhs_ptr = lhs.TryAs<Bool>();
-		const Bool* bool_rhs_ptr = rhs.TryAs<Bool>();
-		if (bool_lhs_ptr && bool_rhs_ptr) {
-			return bool_lhs_ptr->GetValue() < bool_rhs_ptr->GetValue();
+
+		[[noreturn]] void ThrowUncomparable(CompareOp op) {
+			if (op == CompareOp::Equal || op == CompareOp::NotEqual) {
+				throw std::runtime_error("Cannot compare objects for equality"s);
+			}
+			throw std::runtime_error("Cannot compare objects for less"s);
 		}
-		ClassInstance* cls_instance_ptr = lhs.TryAs<ClassInstance>();
-		if (cls_instance_ptr && cls_instance_ptr->HasMethod(LT_METHOD, 1u)) {
-			return cls_instance_ptr->Call(LT_METHOD, { rhs }, context).TryAs<Bool>()->GetValue();
+
+		// Сравнение, в котором lhs - экземпляр класса
+		bool CompareInstance(CompareOp op, ClassInstance& lhs, const ObjectHolder& rhs, Context& context) {
+			if (const Method* cmp = lhs.FindMethod(SpecialMethod::Cmp, 1u)) {
+				const ObjectHolder result = lhs.Call(*cmp, Arguments(&rhs, 1u), context);
+				const Number* number = result.TryAs<Number>();
+				if (!number) {
+					throw std::runtime_error("Method __cmp__ must return a number"s);
+				}
+				return CompareValues(op, number->GetValue(), 0);
+			}
+
+			const auto equal = [&]() {
+				if (const auto result = CallComparisonMethod(lhs, SpecialMethod::Eq, rhs, context)) {
+					return *result;
+				}
+				ThrowUncomparable(CompareOp::Equal);
+			};
+			const auto less = [&]() {
+				if (const auto result = CallComparisonMethod(lhs, SpecialMethod::Lt, rhs, context)) {
+					return *result;
+				}
+				ThrowUncomparable(CompareOp::Less);
+			};
+
+			switch (op) {
+			case CompareOp::Equal:
+				return equal();
+			case CompareOp::NotEqual:
+				return !equal();
+			case CompareOp::Less:
+				return less();
+			case CompareOp::GreaterOrEqual:
+				return !less();
+			case CompareOp::Greater:
+			case CompareOp::LessOrEqual:
+				break;
+			}
+
+			// lhs > rhs равносильно rhs < lhs, если оба объекта упорядочены одним методом __lt__
+			bool greater = false;
+			auto* rhs_instance = rhs.TryAs<ClassInstance>();
+			if (rhs_instance && &rhs_instance->GetClass() == &lhs.GetClass() && lhs.FindMethod(SpecialMethod::Lt, 1u)) {
+				greater = *CallComparisonMethod(*rhs_instance, SpecialMethod::Lt, ObjectHolder::Share(lhs), context);
+			}
+			else {
+				greater = !less() && !equal();
+			}
+			return op == CompareOp::Greater ? greater : !greater;
 		}
-		throw std::runtime_error("Cannot compare objects for less"s);
+
+		// Ядра операций сравнения. Числа, строки и логические значения сравниваются
+		// со значениями того же типа
+		template <ObjectType L, ObjectType R>
+		struct CompareKernel {
+			static bool Call(CompareOp op, const ObjectHolder& lhs, const ObjectHolder& rhs, Context& /*context*/) {
+				using Value = ValueObjectOf<L>;
+				if constexpr (L == R && !std::is_void_v<Value>) {
+					return CompareValues(op, ValueOf<Value>(lhs), ValueOf<Value>(rhs));
+				}
+				else if constexpr (L == ObjectType::None && R == ObjectType::None) {
+					if (op == CompareOp::Equal || op == CompareOp::NotEqual) {
+						return op == CompareOp::Equal;
+					}
+					ThrowUncomparable(op);
+				}
+				else {
+					ThrowUncomparable(op);
+				}
+			}
+		};
+
+		// Списки равны, если равны их длины и попарно равны элементы
+		template <>
+		struct CompareKernel<ObjectType::List, ObjectType::List> {
+			static bool Call(CompareOp op, const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+				if (op != CompareOp::Equal && op != CompareOp::NotEqual) {
+					ThrowUncomparable(op);
+				}
+				const auto& lhs_items = static_cast<const List*>(lhs.Get())->GetItems();
+				const auto& rhs_items = static_cast<const List*>(rhs.Get())->GetItems();
+				bool equal = lhs.Get() == rhs.Get();
+				if (!equal && lhs_items.size() == rhs_items.size()) {
+					equal = true;
+					for (size_t i = 0u; equal && i < lhs_items.size(); ++i) {
+						equal = Compare(CompareOp::Equal, lhs_items[i], rhs_items[i], context);
+					}
+				}
+				return (op == CompareOp::Equal) == equal;
+			}
+		};
+
+		// Словари равны, если содержат одинаковые ключи с равными значениями
+		template <>
+		struct CompareKernel<ObjectType::Dict, ObjectType::Dict> {
+			static bool Call(CompareOp op, const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+				if (op != CompareOp::Equal && op != CompareOp::NotEqual) {
+					ThrowUncomparable(op);
+				}
+				const auto& lhs_dict = *static_cast<const Dict*>(lhs.Get());
+				const auto& rhs_dict = *static_cast<const Dict*>(rhs.Get());
+				bool equal = &lhs_dict == &rhs_dict;
+				if (!equal && lhs_dict.Size() == rhs_dict.Size()) {
+					equal = true;
+					for (size_t i = 0u; equal && i < lhs_dict.Size(); ++i) {
+						// Копия: __eq__ значения может добавить элементы в словарь
+						const Dict::Entry entry = lhs_dict.GetEntries()[i];
+						const ObjectHolder* other = rhs_dict.Find(entry.key);
+						equal = other && Compare(CompareOp::Equal, entry.value, ObjectHolder(*other), context);
+					}
+				}
+				return (op == CompareOp::Equal) == equal;
+			}
+		};
+
+		template <ObjectType R>
+		struct CompareKernel<ObjectType::ClassInstance, R> {
+			static bool Call(CompareOp op, const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+				return CompareInstance(op, *static_cast<ClassInstance*>(lhs.Get()), rhs, context);
+			}
+		};
+	}  // namespace
+
+	bool Compare(CompareOp op, const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+		return BinaryDispatch<CompareKernel>::Get(lhs.GetType(), rhs.GetType())(op, lhs, rhs, context);
+	}
+
+	bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+		return Compare(CompareOp::Equal, lhs, rhs, context);
+	}
+
+	bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+		return Compare(CompareOp::Less, lhs, rhs, context);
 	}
 
 	bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-		return !Equal(lhs, rhs, context);
+		return Compare(CompareOp::NotEqual, lhs, rhs, context);
 	}
 
 	bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-		return !Less(lhs, rhs, context) && !Equal(lhs, rhs, context);
+		return Compare(CompareOp::Greater, lhs, rhs, context);
 	}
 
 	bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-		return Less(lhs, rhs, context) || Equal(lhs, rhs, context);
+		return Compare(CompareOp::LessOrEqual, lhs, rhs, context);
 	}
 
 	bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-		return !Less(lhs, rhs, context);
+		return Compare(CompareOp::GreaterOrEqual, lhs, rhs, context);
+	}
+
+	namespace {
+		// Перемешивает биты целого, чтобы от всех битов значения зависели и номер группы, и
+		// управляющий байт
+		size_t MixHash(uint64_t value) {
+			value ^= value >> 33u;
+			value *= 0xFF51AFD7ED558CCDull;
+			value ^= value >> 33u;
+			return static_cast<size_t>(value);
+		}
+
+		size_t HashKey(const ObjectHolder& key) {
+			switch (key.GetType()) {
+			case ObjectType::Number:
+				return MixHash(static_cast<uint64_t>(static_cast<int64_t>(ValueOf<Number>(key))));
+			case ObjectType::String:
+				return std::hash<std::string>{}(ValueOf<String>(key));
+			case ObjectType::Bool:
+				return MixHash(ValueOf<Bool>(key) ? 0x9E3779B97F4A7C15ull : 0x7F4A7C159E3779B9ull);
+			default:
+				throw std::runtime_error("Dict keys must be numbers, strings or bools"s);
+			}
+		}
+
+		// Ключи разных типов различны: 1 и True - разные ключи
+		bool SameKey(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+			if (lhs.GetType() != rhs.GetType()) {
+				return false;
+			}
+			switch (lhs.GetType()) {
+			case ObjectType::Number:
+				return ValueOf<Number>(lhs) == ValueOf<Number>(rhs);
+			case ObjectType::String:
+				return ValueOf<String>(lhs) == ValueOf<String>(rhs);
+			default:
+				return ValueOf<Bool>(lhs) == ValueOf<Bool>(rhs);
+			}
+		}
+
+		constexpr uint64_t REPEATED_BYTE = 0x0101010101010101ull;
+		constexpr uint64_t HIGH_BITS = 0x8080808080808080ull;
+
+		// Возвращает ненулевое значение, если среди байтов group есть равный byte. Может сработать
+		// и без совпадения, поэтому кандидаты затем проверяются побайтно
+		uint64_t MatchByte(uint64_t group, uint8_t byte) {
+			const uint64_t x = group ^ (REPEATED_BYTE * byte);
+			return (x - REPEATED_BYTE) & ~x & HIGH_BITS;
+		}
+
+		int IndexValue(const ObjectHolder& index) {
+			if (index.GetType() != ObjectType::Number) {
+				throw std::runtime_error("Index must be a number"s);
+			}
+			return ValueOf<Number>(index);
+		}
+	}  // namespace
+
+	size_t Dict::Probe(const ObjectHolder& key, size_t hash, size_t& free_slot) const {
+		const auto tag = static_cast<uint8_t>(hash & 0x7Fu);
+		const size_t group_mask = control_.size() / GROUP_SIZE - 1u;
+		size_t group = (hash >> 7u) & group_mask;
+		// Шаги 1, 2, 3... между группами: при числе групп - степени двойки обходятся все группы.
+		// Таблица заполнена не больше чем на 7/8, поэтому свободная ячейка найдётся
+		for (size_t step = 1u;; ++step) {
+			const size_t first = group * GROUP_SIZE;
+			uint64_t word = 0;
+			std::memcpy(&word, &control_[first], GROUP_SIZE);
+			if (MatchByte(word, tag) != 0u) {
+				for (size_t i = first; i < first + GROUP_SIZE; ++i) {
+					if (control_[i] == tag) {
+						const Entry& entry = entries_[slots_[i]];
+						if (entry.hash == hash && SameKey(entry.key, key)) {
+							return slots_[i];
+						}
+					}
+				}
+			}
+			if ((word & HIGH_BITS) != 0u) {
+				// Поиск заканчивается на первой группе со свободной ячейкой
+				for (size_t i = first;; ++i) {
+					if (control_[i] == EMPTY) {
+						free_slot = i;
+						return NOT_FOUND;
+					}
+				}
+			}
+			group = (group + step) & group_mask;
+		}
+	}
+
+	void Dict::Rehash(size_t capacity) {
+		control_.assign(capacity, EMPTY);
+		slots_.assign(capacity, 0u);
+		for (size_t index = 0u; index < entries_.size(); ++index) {
+			const Entry& entry = entries_[index];
+			size_t free_slot = 0u;
+			Probe(entry.key, entry.hash, free_slot);
+			control_[free_slot] = static_cast<uint8_t>(entry.hash & 0x7Fu);
+			slots_[free_slot] = static_cast<uint32_t>(index);
+		}
+	}
+
+	void Dict::Reserve(size_t count) {
+		entries_.reserve(count);
+		size_t capacity = std::max(control_.size(), GROUP_SIZE * 2u);
+		while (count * 8u > capacity * 7u) {
+			capacity *= 2u;
+		}
+		if (capacity != control_.size()) {
+			Rehash(capacity);
+		}
+		UpdateMemoryCharge();
+	}
+
+	void Dict::Clear() {
+		// Значения уничтожаются после того, как словарь стал пустым: их деструкторы могут обратиться к нему
+		const std::vector<Entry> entries = std::exchange(entries_, {});
+		control_.clear();
+		slots_.clear();
+		UpdateMemoryCharge();
+	}
+
+	ObjectHolder* Dict::Find(const ObjectHolder& key) {
+		return const_cast<ObjectHolder*>(std::as_const(*this).Find(key));
+	}
+
+	const ObjectHolder* Dict::Find(const ObjectHolder& key) const {
+		const size_t hash = HashKey(key);
+		if (entries_.empty()) {
+			return nullptr;
+		}
+		size_t free_slot = 0u;
+		const size_t index = Probe(key, hash, free_slot);
+		return index != NOT_FOUND ? &entries_[index].value : nullptr;
+	}
+
+	ObjectHolder& Dict::Set(const ObjectHolder& key, ObjectHolder value) {
+		const size_t hash = HashKey(key);
+		if (control_.empty()) {
+			Rehash(GROUP_SIZE * 2u);
+		}
+		size_t free_slot = 0u;
+		if (const size_t index = Probe(key, hash, free_slot); index != NOT_FOUND) {
+			return entries_[index].value = std::move(value);
+		}
+		if ((entries_.size() + 1u) * 8u > control_.size() * 7u) {
+			Rehash(control_.size() * 2u);
+			Probe(key, hash, free_slot);
+		}
+		control_[free_slot] = static_cast<uint8_t>(hash & 0x7Fu);
+		slots_[free_slot] = static_cast<uint32_t>(entries_.size());
+		entries_.push_back({ key, std::move(value), hash });
+		UpdateMemoryCharge();
+		return entries_.back().value;
+	}
+
+	void Dict::Print(std::ostream& os, Context& context) {
+		if (printing_) {
+			os << "{...}"sv;
+			return;
+		}
+		PrintContainer(printing_, [&] {
+			os << '{';
+			for (size_t i = 0u; i < entries_.size(); ++i) {
+				if (i > 0u) {
+					os << ", "sv;
+				}
+				const Entry entry = entries_[i];
+				PrintItem(os, entry.key, context);
+				os << ": "sv;
+				PrintItem(os, entry.value, context);
+			}
+			os << '}';
+		});
+	}
+
+	bool Dict::HasMethod(const std::string& method, size_t argument_count) {
+		return (method == "get"sv || method == "contains"sv) && argument_count == 1u;
+	}
+
+	ObjectHolder Dict::Call(const std::string& method, Arguments actual_args) {
+		if (!HasMethod(method, actual_args.size())) {
+			throw std::runtime_error("Dict has no method "s + method + " taking "s
+				+ std::to_string(actual_args.size()) + " arguments"s);
+		}
+		const ObjectHolder* value = Find(actual_args.front());
+		if (method == "contains"sv) {
+			return ObjectHolder::Own(Bool(value != nullptr));
+		}
+		return value ? *value : ObjectHolder::None();
+	}
+
+	bool HasBuiltinMethod(const ObjectHolder& object, const std::string& method, size_t argument_count) {
+		switch (object.GetType()) {
+		case ObjectType::List:
+			return List::HasMethod(method, argument_count);
+		case ObjectType::Dict:
+			return Dict::HasMethod(method, argument_count);
+		default:
+			return false;
+		}
+	}
+
+	ObjectHolder CallBuiltinMethod(const ObjectHolder& object, const std::string& method,
+		Arguments actual_args) {
+		if (auto* list = object.TryAs<List>()) {
+			return list->Call(method, actual_args);
+		}
+		if (auto* dict = object.TryAs<Dict>()) {
+			return dict->Call(method, actual_args);
+		}
+		throw std::runtime_error("Object is not a class instance"s);
+	}
+
+	ObjectHolder GetItem(const ObjectHolder& object, const ObjectHolder& index) {
+		switch (object.GetType()) {
+		case ObjectType::List:
+			return static_cast<const List*>(object.Get())->At(IndexValue(index));
+		case ObjectType::String: {
+			const std::string& str = ValueOf<String>(object);
+			const int value = IndexValue(index);
+			const auto size = static_cast<int64_t>(str.size());
+			const int64_t position = value < 0 ? size + value : value;
+			if (position < 0 || position >= size) {
+				throw std::runtime_error("String index out of range"s);
+			}
+			return ObjectHolder::Own(String(std::string(1u, str[static_cast<size_t>(position)])));
+		}
+		case ObjectType::Dict:
+			if (const ObjectHolder* value = static_cast<const Dict*>(object.Get())->Find(index)) {
+				return *value;
+			}
+			throw std::runtime_error("Key not found in dict"s);
+		default:
+			throw std::runtime_error("Object is not indexable"s);
+		}
+	}
+
+	void SetItem(const ObjectHolder& object, const ObjectHolder& index, ObjectHolder value) {
+		if (auto* list = object.TryAs<List>()) {
+			list->At(IndexValue(index)) = std::move(value);
+		}
+		else if (auto* dict = object.TryAs<Dict>()) {
+			dict->Set(index, std::move(value));
+		}
+		else {
+			throw std::runtime_error("Object does not support item assignment"s);
+		}
+	}
+
+	int GetLength(const ObjectHolder& object) {
+		switch (object.GetType()) {
+		case ObjectType::List:
+			return static_cast<int>(static_cast<const List*>(object.Get())->Size());
+		case ObjectType::Dict:
+			return static_cast<int>(static_cast<const Dict*>(object.Get())->Size());
+		case ObjectType::String:
+			return static_cast<int>(ValueOf<String>(object).size());
+		default:
+			throw std::runtime_error("len() argument must be a list, a dict or a string"s);
+		}
+	}
+
+	size_t GetIterationSize(const ObjectHolder& iterable) {
+		switch (iterable.GetType()) {
+		case ObjectType::List:
+			return static_cast<const List*>(iterable.Get())->Size();
+		case ObjectType::Dict:
+			return static_cast<const Dict*>(iterable.Get())->Size();
+		default:
+			throw std::runtime_error("Object is not iterable"s);
+		}
+	}
+
+	const ObjectHolder& GetIterationItem(const ObjectHolder& iterable, size_t index) {
+		if (const auto* list = iterable.TryAs<List>()) {
+			return list->GetItems()[index];
+		}
+		return iterable.TryAs<Dict>()->GetEntries()[index].key;
+	}
+
+	const BuiltinFunction& BuiltinRegistry::Register(std::string name, size_t arity, BuiltinFunction::Callable callable) {
+		if (functions_.count(name) > 0) {
+			throw std::invalid_argument("Builtin function "s + name + " is already registered"s);
+		}
+		auto key = name;
+		BuiltinFunction function{ std::move(name), arity, std::move(callable) };
+		return functions_.emplace(std::move(key), std::move(function)).first->second;
+	}
+
+	const BuiltinFunction* BuiltinRegistry::Find(const std::string& name) const {
+		const auto it = functions_.find(name);
+		return it != functions_.end() ? &it->second : nullptr;
+	}
+
+	namespace {
+
+		int ParseInt(const std::string& text) {
+			int value = 0;
+			const char* end = text.data() + text.size();
+			const auto [ptr, error] = std::from_chars(text.data(), end, value);
+			if (error != std::errc{} || ptr != end || text.empty()) {
+				throw std::runtime_error("int() argument is not a number: '"s + text + "'"s);
+			}
+			return value;
+		}
+
+	}  // namespace
+
+	void RegisterStandardBuiltins(BuiltinRegistry& registry) {
+		registry.Register("abs"s, 1u, [](Arguments args, Context& /*context*/) {
+			if (args[0].GetType() != ObjectType::Number) {
+				throw std::runtime_error("abs() argument must be a number"s);
+			}
+			const int value = ValueOf<Number>(args[0]);
+			return value < 0 ? ObjectHolder::Own(Number(-value)) : args[0];
+		});
+		registry.Register("min"s, 2u, [](Arguments args, Context& context) {
+			return Less(args[1], args[0], context) ? args[1] : args[0];
+		});
+		registry.Register("max"s, 2u, [](Arguments args, Context& context) {
+			return Less(args[0], args[1], context) ? args[1] : args[0];
+		});
+		registry.Register("int"s, 1u, [](Arguments args, Context& /*context*/) {
+			switch (args[0].GetType()) {
+			case ObjectType::Number:
+				return args[0];
+			case ObjectType::Bool:
+				return ObjectHolder::Own(Number(ValueOf<Bool>(args[0]) ? 1 : 0));
+			case ObjectType::String:
+				return ObjectHolder::Own(Number(ParseInt(ValueOf<String>(args[0]))));
+			default:
+				throw std::runtime_error("int() argument must be a string, a number or a bool"s);
+			}
+		});
+	}
+
+	const BuiltinRegistry& StandardBuiltins() {
+		static const BuiltinRegistry registry = [] {
+			BuiltinRegistry result;
+			RegisterStandardBuiltins(result);
+			return result;
+		}();
+		return registry;
 	}
 
-}  // namespace runtime
\ No newline at end of file
+}  // namespace runtime
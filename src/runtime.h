@@ -1,29 +1,410 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace runtime {
 
-	// Контекст исполнения инструкций Mython
-	class Context {
-	public:
-		// Возвращает поток вывода для команд print
-		virtual std::ostream& GetOutputStream() = 0;
+	class Context;
+	class ClassInstance;
+	class Container;
 
-	protected:
-		~Context() = default;
+	// Тип объекта Mython. Хранится в каждом объекте и позволяет определить тип без dynamic_cast
+	enum class ObjectType : uint8_t {
+		None,           // пустой ObjectHolder
+		Number,
+		String,
+		Bool,
+		Class,
+		ClassInstance,
+		List,
+		Dict,
+		Other,          // прочие наследники Object
+	};
+
+	// Количество значений ObjectType
+	inline constexpr size_t OBJECT_TYPE_COUNT = 9u;
+
+	// Память, в которой размещён объект. Определяет, как объект освобождается, когда исчезает
+	// последний владеющий им ObjectHolder
+	enum class Storage : uint8_t {
+		Unmanaged,  // объект создан вне ObjectHolder (константа, переменная на стеке) и не освобождается им
+		Heap,       // оператор new (см. ObjectHolder::Own)
+		Pool,       // пул экземпляров класса (см. Class::CreateInstance)
+		Frame,      // память кадра вызова (см. FrameArena)
+		Shared,     // пул размеров потока, создавшего объект (см. ObjectPool)
+	};
+
+	// Способ изменения счётчика ссылок объекта
+	enum class RefCountPolicy : uint8_t {
+		Local,   // обычные операции: объект используется одним потоком
+		Atomic,  // атомарные операции: объект разделяется между потоками
 	};
 
-	// Базовый класс для всех объектов языка Mython
+	/*
+	Базовый класс для всех объектов языка Mython. Объект хранит счётчик владеющих им ObjectHolder
+	(интрузивный подсчёт ссылок), поэтому ObjectHolder - это один указатель, а ObjectHolder для
+	любого объекта создаётся без выделения памяти. Интерпретатор выполняет программу в одном
+	потоке, поэтому по умолчанию счётчик изменяется без атомарных операций.
+	Объекты, созданные вне ObjectHolder (Storage::Unmanaged), считаются бессмертными: их счётчик
+	начинается с UNMANAGED_REF_COUNT и не достигает нуля
+	*/
 	class Object {
 	public:
+		static constexpr uint32_t UNMANAGED_REF_COUNT = 1u << 30;
+
 		virtual ~Object() = default;
 		// выводит в os своё представление в виде строки
 		virtual void Print(std::ostream& os, Context& context) = 0;
+
+		// Возвращает тип объекта
+		[[nodiscard]] ObjectType GetType() const {
+			return type_;
+		}
+
+		// Возвращает память, в которой размещён объект
+		[[nodiscard]] Storage GetStorage() const {
+			return storage_;
+		}
+
+		// Возвращает число владеющих объектом ObjectHolder
+		[[nodiscard]] uint32_t GetRefCount() const {
+			return ref_count_.load(std::memory_order_relaxed);
+		}
+
+		[[nodiscard]] RefCountPolicy GetRefCountPolicy() const {
+			return policy_;
+		}
+		// Задаёт способ изменения счётчика ссылок. Вызывается, пока объект доступен одному потоку,
+		// например перед передачей объекта другому потоку
+		void SetRefCountPolicy(RefCountPolicy policy) {
+			policy_ = policy;
+		}
+
+		// Учитывает в счёте памяти объекта (см. MemoryAccount) изменение размера его памяти вне
+		// блока объекта. Вызывается после роста строки, массива элементов или полей
+		void UpdateMemoryCharge() {
+			if (account_ != 0u) {
+				ChargePayload();
+			}
+		}
+
+	protected:
+		Object() = default;
+		explicit Object(ObjectType type)
+			: type_(type) {
+		}
+
+		// Копия получает собственный счётчик ссылок и размещение: копируется только тип
+		Object(const Object& other)
+			: type_(other.type_) {
+		}
+		Object& operator=(const Object& /*other*/) {
+			return *this;
+		}
+
+		// Возвращает размер памяти, которую объект занимает вне своего блока: буфер строки,
+		// массивы элементов и полей
+		[[nodiscard]] virtual size_t GetPayloadSize() const {
+			return 0u;
+		}
+
+	private:
+		friend class ObjectHolder;
+
+		void AddRef() const noexcept {
+			if (policy_ == RefCountPolicy::Local) {
+				ref_count_.store(ref_count_.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+			}
+			else {
+				ref_count_.fetch_add(1u, std::memory_order_relaxed);
+			}
+		}
+
+		void Release() const noexcept {
+			uint32_t count;
+			if (policy_ == RefCountPolicy::Local) {
+				count = ref_count_.load(std::memory_order_relaxed) - 1u;
+				ref_count_.store(count, std::memory_order_relaxed);
+			}
+			else {
+				count = ref_count_.fetch_sub(1u, std::memory_order_acq_rel) - 1u;
+			}
+			if (count == 0u) {
+				const_cast<Object*>(this)->Destroy();
+			}
+		}
+
+		// Уничтожает объект и возвращает его память туда, откуда она выделена
+		void Destroy() noexcept;
+		// Списывает на счёт объекта разницу между GetPayloadSize и учтённым размером
+		void ChargePayload();
+
+		mutable std::atomic<uint32_t> ref_count_{ UNMANAGED_REF_COUNT };
+		// Размер блока памяти объекта для Storage::Pool, Storage::Frame и Storage::Shared
+		uint16_t size_ = 0;
+		ObjectType type_ = ObjectType::Other;
+		Storage storage_ = Storage::Unmanaged;
+		RefCountPolicy policy_ = RefCountPolicy::Local;
+		// Номер счёта памяти, на который записан объект (см. MemoryAccount), либо 0
+		uint8_t account_ = 0;
+		// Учтённый в счёте размер памяти вне блока объекта
+		uint32_t payload_ = 0;
+	};
+
+	/*
+	Пулы объектов по классам размеров с шагом SIZE_STEP, по одному набору на поток. Из них
+	ObjectHolder::Own выделяет объекты не больше MAX_BLOCK_SIZE: числа, строки, Bool, экземпляры
+	классов и прочие. Память нарезается из страниц размером SLAB_SIZE, выровненных по своему
+	размеру; каждая страница отдана одному классу размеров, а в её заголовке записан пул-владелец,
+	так что пул блока находится по его адресу. Блоки выдаются подряд из последней страницы класса,
+	а освобождённые блоки образуют список и выдаются снова в первую очередь.
+	Блок, освобождённый в другом потоке, добавляется в атомарный список своей страницы и
+	возвращается в пул, когда у пула кончаются блоки этого размера (см. CollectRemoteFrees).
+	Страницы можно брать из огромных страниц памяти (SetHugePages): тогда память запрашивается
+	участками по HUGE_PAGE_SIZE, которые в Linux помечаются для размещения в огромных страницах.
+	Страницы пула освобождаются вместе с ним, если в них не осталось живых блоков, иначе
+	остаются до конца программы
+	*/
+	class ObjectPool {
+	public:
+		static constexpr size_t SIZE_STEP = 16u;
+		static constexpr size_t MAX_BLOCK_SIZE = 256u;
+		static constexpr size_t SIZE_CLASS_COUNT = MAX_BLOCK_SIZE / SIZE_STEP;
+		static constexpr size_t SLAB_SIZE = 32u * 1024u;
+		static constexpr size_t HUGE_PAGE_SIZE = 2u * 1024u * 1024u;
+
+		// Счётчики класса размеров
+		struct SizeClassStats {
+			size_t block_size = 0;
+			// Выданные блоки и среди них - взятые из списка освобождённых
+			uint64_t allocations = 0;
+			uint64_t reused = 0;
+			// Блоки, освобождённые другими потоками и вернувшиеся в пул
+			uint64_t remote_frees = 0;
+			// Выданные и ещё не возвращённые блоки
+			size_t live = 0;
+			// Число блоков, помещающихся в страницы класса
+			size_t capacity = 0;
+		};
+
+		// Пул, не связанный с потоком: все возвращаемые в него блоки проходят через
+		// списки страниц, как блоки из других потоков
+		ObjectPool()
+			: ObjectPool(false) {
+		}
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+		~ObjectPool();
+
+		// Возвращает пул текущего потока
+		[[nodiscard]] static ObjectPool& ForThread() {
+			static thread_local ObjectPool pool(true);
+			return pool;
+		}
+
+		// Выделяет блок размером size байт (не больше MAX_BLOCK_SIZE), выровненный по SIZE_STEP
+		[[nodiscard]] void* Allocate(size_t size) {
+			SizeClass& size_class = size_classes_[(size - 1u) / SIZE_STEP];
+			++size_class.stats.allocations;
+			++size_class.stats.live;
+			if (FreeBlock* block = size_class.free) {
+				size_class.free = block->next;
+				++size_class.stats.reused;
+				return block;
+			}
+			if (size_class.next != size_class.end) {
+				void* block = size_class.next;
+				size_class.next += size_class.stats.block_size;
+				return block;
+			}
+			return Refill(size_class);
+		}
+
+		// Возвращает блок, выделенный Allocate с тем же size в любом потоке
+		static void Deallocate(void* block, size_t size) noexcept;
+
+		// Забирает в списки освобождённых блоков блоки, которые вернули другие потоки.
+		// Возвращает их число
+		size_t CollectRemoteFrees();
+
+		// Включает и выключает выделение объектов из пула в ObjectHolder::Own. По умолчанию включено
+		[[nodiscard]] bool IsEnabled() const {
+			return enabled_;
+		}
+		void SetEnabled(bool enabled) {
+			enabled_ = enabled;
+		}
+
+		// Включает и выключает запрос новой памяти участками в огромных страницах
+		[[nodiscard]] bool GetHugePages() const {
+			return huge_pages_;
+		}
+		void SetHugePages(bool huge_pages) {
+			huge_pages_ = huge_pages;
+		}
+
+		// Возвращает счётчики классов размеров, из которых выделялись блоки
+		[[nodiscard]] std::vector<SizeClassStats> GetStats() const;
+
+		// Возвращает суммарный размер запрошенной пулом памяти в байтах
+		[[nodiscard]] size_t GetReservedBytes() const {
+			return reserved_bytes_;
+		}
+
+		// Выводит для каждого класса размеров число выделений, долю повторно использованных
+		// блоков и заполненность страниц
+		void Dump(std::ostream& out) const;
+
+	private:
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		// Заголовок страницы
+		struct Slab {
+			// nullptr, если пул уничтожен раньше блоков страницы
+			std::atomic<ObjectPool*> owner;
+			// Блоки, освобождённые другими потоками
+			std::atomic<FreeBlock*> remote_free;
+			// Следующая страница того же класса размеров
+			Slab* next;
+		};
+
+		struct SizeClass {
+			FreeBlock* free = nullptr;
+			// Свободная часть последней страницы
+			std::byte* next = nullptr;
+			std::byte* end = nullptr;
+			Slab* slabs = nullptr;
+			SizeClassStats stats;
+		};
+
+		static constexpr size_t HEADER_SIZE = (sizeof(Slab) + SIZE_STEP - 1u) / SIZE_STEP * SIZE_STEP;
+
+		explicit ObjectPool(bool thread_pool);
+
+		// Выдаёт блок класса size_class, когда в пуле не осталось свободных
+		void* Refill(SizeClass& size_class);
+		size_t CollectRemoteFrees(SizeClass& size_class);
+		// Возвращает новую страницу
+		Slab* NewSlab();
+
+		std::array<SizeClass, SIZE_CLASS_COUNT> size_classes_;
+		// Свободная часть последнего запрошенного участка памяти
+		std::byte* chunk_next_ = nullptr;
+		std::byte* chunk_end_ = nullptr;
+		// Запрошенные участки и их размеры
+		std::vector<std::pair<void*, size_t>> chunks_;
+		size_t reserved_bytes_ = 0;
+		bool enabled_ = true;
+		bool huge_pages_ = false;
+	};
+
+	/*
+	Счёт памяти интерпретатора. Пока счёт активен в потоке (см. Scope), на него записываются все
+	объекты, которые создаёт этот поток: блок объекта и память вне блока - буфер строки, массивы
+	элементов списка и словаря, поля экземпляра. Объект возвращает записанную память на свой счёт,
+	когда освобождается, в любом потоке и даже после уничтожения счёта.
+	При превышении мягкого предела вызывается обработчик (один раз, пока использование снова не
+	опустится до предела), а выделение сверх жёсткого предела не записывается на счёт и
+	выбрасывает runtime_error: объект, на котором превышен предел, при этом освобождается.
+	Одновременно существует не больше MAX_ACCOUNTS счетов, вместе с уничтоженными, объекты
+	которых ещё живы
+	*/
+	class MemoryAccount {
+	public:
+		static constexpr size_t MAX_ACCOUNTS = 255u;
+		// Предел, означающий его отсутствие
+		static constexpr size_t NO_LIMIT = static_cast<size_t>(-1);
+
+		using SoftLimitHandler = std::function<void(const MemoryAccount&)>;
+
+		// Делает счёт активным в текущем потоке, а при уничтожении восстанавливает прежний
+		class Scope {
+		public:
+			explicit Scope(MemoryAccount& account);
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+			~Scope();
+
+		private:
+			MemoryAccount* previous_;
+		};
+
+		// Если свободных номеров счетов нет, выбрасывает runtime_error
+		MemoryAccount();
+		MemoryAccount(const MemoryAccount&) = delete;
+		MemoryAccount& operator=(const MemoryAccount&) = delete;
+		~MemoryAccount();
+
+		// Возвращает счёт, активный в текущем потоке, либо nullptr
+		[[nodiscard]] static MemoryAccount* GetActive();
+
+		// Возвращает число байт, записанных на счёт и ещё не возвращённых
+		[[nodiscard]] size_t GetUsage() const;
+		// Возвращает наибольшее значение GetUsage за время жизни счёта
+		[[nodiscard]] size_t GetPeak() const {
+			return peak_;
+		}
+
+		[[nodiscard]] size_t GetSoftLimit() const {
+			return soft_limit_;
+		}
+		// Задаёт мягкий предел и обработчик его превышения. Исключение обработчика
+		// передаётся коду, создававшему объект
+		void SetSoftLimit(size_t limit, SoftLimitHandler handler);
+
+		[[nodiscard]] size_t GetHardLimit() const {
+			return hard_limit_;
+		}
+		void SetHardLimit(size_t limit) {
+			hard_limit_ = limit;
+		}
+
+	private:
+		friend class Object;
+		friend class ObjectHolder;
+
+		// Записывает на счёт size байт и проверяет пределы. Если жёсткий предел превышен,
+		// ничего не записывает и выбрасывает runtime_error
+		void Charge(size_t size);
+		// Возвращает size байт на счёт с номером id
+		static void Release(uint8_t id, size_t size) noexcept;
+
+		uint8_t id_ = 0;
+		size_t peak_ = 0;
+		size_t soft_limit_ = NO_LIMIT;
+		size_t hard_limit_ = NO_LIMIT;
+		bool soft_limit_reached_ = false;
+		SoftLimitHandler soft_limit_handler_;
+	};
+
+	/*
+	 * Тип T имеет собственный тег, если в нём объявлена константа TYPE, отличная от Other.
+	 * Такие типы не должны иметь наследников с другим тегом: ObjectHolder::TryAs сравнивает
+	 * только теги
+	 */
+	template <typename T, typename = void>
+	struct HasObjectType : std::false_type {
+	};
+
+	template <typename T>
+	struct HasObjectType<T, std::void_t<decltype(T::TYPE)>>
+		: std::bool_constant<T::TYPE != ObjectType::Other> {
 	};
 
 	// Специальный класс-обёртка, предназначенный для хранения объекта в Mython-программе
@@ -34,13 +415,35 @@ namespace runtime {
 
 		// Возвращает ObjectHolder, владеющий объектом типа T
 		// Тип T - конкретный класс-наследник Object.
-		// object копируется или перемещается в кучу
+		// object копируется или перемещается в кучу.
+		// Объекты не больше ObjectPool::MAX_BLOCK_SIZE размещаются в пуле текущего потока
 		template <typename T>
 		[[nodiscard]] static ObjectHolder Own(T&& object) {
-			return ObjectHolder(std::make_shared<T>(std::forward<T>(object)));
+			using Type = std::remove_cv_t<std::remove_reference_t<T>>;
+			if constexpr (sizeof(Type) <= ObjectPool::MAX_BLOCK_SIZE && alignof(Type) <= ObjectPool::SIZE_STEP) {
+				ObjectPool& pool = ObjectPool::ForThread();
+				if (pool.IsEnabled()) {
+					void* block = pool.Allocate(sizeof(Type));
+					Type* copy;
+					try {
+						copy = new (block) Type(std::forward<T>(object));
+					}
+					catch (...) {
+						ObjectPool::Deallocate(block, sizeof(Type));
+						throw;
+					}
+					return Adopt(copy, Storage::Shared, sizeof(Type));
+				}
+			}
+			return Adopt(new Type(std::forward<T>(object)), Storage::Heap, sizeof(Type));
 		}
 
-		// Создаёт ObjectHolder, не владеющий объектом (аналог слабой ссылки)
+		// Возвращает ObjectHolder, владеющий только что созданным объектом object, память которого
+		// выделена способом storage блоком размером size
+		[[nodiscard]] static ObjectHolder Adopt(Object* object, Storage storage, size_t size);
+
+		// Создаёт ObjectHolder, ссылающийся на объект. ObjectHolder владеет объектом наравне
+		// с остальными, если объект принадлежит ObjectHolder, иначе - не владеет (аналог слабой ссылки)
 		[[nodiscard]] static ObjectHolder Share(Object& object);
 		// Создаёт пустой ObjectHolder, соответствующий значению None
 		[[nodiscard]] static ObjectHolder None();
@@ -54,28 +457,93 @@ namespace runtime {
 		[[nodiscard]] Object* Get() const;
 
 		// Возвращает указатель на объект типа T либо nullptr, если внутри ObjectHolder не хранится
-		// объект данного типа
+		// объект данного типа. Для типов с собственным тегом проверяется тег, иначе - dynamic_cast
 		template <typename T>
 		[[nodiscard]] T* TryAs() const {
-			return dynamic_cast<T*>(this->Get());
+			if constexpr (HasObjectType<T>::value) {
+				return GetType() == T::TYPE ? static_cast<T*>(this->Get()) : nullptr;
+			}
+			else {
+				return dynamic_cast<T*>(this->Get());
+			}
+		}
+
+		// Возвращает тип хранимого объекта либо ObjectType::None, если ObjectHolder пуст
+		[[nodiscard]] ObjectType GetType() const {
+			return data_ ? data_->GetType() : ObjectType::None;
 		}
 
 		// Возвращает true, если ObjectHolder не пуст
 		explicit operator bool() const;
 
+		ObjectHolder(const ObjectHolder& other) noexcept
+			: data_(other.data_) {
+			if (data_) {
+				data_->AddRef();
+			}
+		}
+
+		ObjectHolder(ObjectHolder&& other) noexcept
+			: data_(std::exchange(other.data_, nullptr)) {
+		}
+
+		ObjectHolder& operator=(const ObjectHolder& rhs) noexcept {
+			if (rhs.data_) {
+				rhs.data_->AddRef();
+			}
+			Reset(rhs.data_);
+			return *this;
+		}
+
+		ObjectHolder& operator=(ObjectHolder&& rhs) noexcept {
+			if (this != &rhs) {
+				Reset(std::exchange(rhs.data_, nullptr));
+			}
+			return *this;
+		}
+
+		~ObjectHolder() {
+			if (data_) {
+				data_->Release();
+			}
+		}
+
 	private:
-		explicit ObjectHolder(std::shared_ptr<Object> data);
+		// Увеличивает счётчик ссылок object
+		explicit ObjectHolder(Object* data) noexcept;
 		void AssertIsValid() const;
 
-		std::shared_ptr<Object> data_;
+		// Заменяет объект на data, ссылка на который уже учтена, и освобождает прежний
+		void Reset(Object* data) noexcept {
+			// Прежний объект освобождается последним: его деструктор может обратиться к этому ObjectHolder
+			Object* old = std::exchange(data_, data);
+			if (old) {
+				old->Release();
+			}
+		}
+
+		Object* data_ = nullptr;
 	};
 
+	// Тег объекта-значения, хранящего значение типа T
+	template <typename T>
+	inline constexpr ObjectType VALUE_OBJECT_TYPE = ObjectType::Other;
+	template <>
+	inline constexpr ObjectType VALUE_OBJECT_TYPE<int> = ObjectType::Number;
+	template <>
+	inline constexpr ObjectType VALUE_OBJECT_TYPE<std::string> = ObjectType::String;
+	template <>
+	inline constexpr ObjectType VALUE_OBJECT_TYPE<bool> = ObjectType::Bool;
+
 	// Объект-значение, хранящий значение типа T
 	template <typename T>
 	class ValueObject : public Object {
 	public:
+		static constexpr ObjectType TYPE = VALUE_OBJECT_TYPE<T>;
+
 		ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
-			: value_(v) {
+			: Object(TYPE)
+			, value_(v) {
 		}
 
 		void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
@@ -86,15 +554,234 @@ namespace runtime {
 			return value_;
 		}
 
+		// Заменяет значение. Допустимо только для объекта, на который заведомо нет других ссылок,
+		// поскольку значения Mython неизменяемы (см. ast::ForRange)
+		void SetValue(T v) {
+			value_ = std::move(v);
+			UpdateMemoryCharge();
+		}
+
+	protected:
+		[[nodiscard]] size_t GetPayloadSize() const override {
+			if constexpr (std::is_same_v<T, std::string>) {
+				// Короткая строка хранится внутри объекта
+				const auto data = reinterpret_cast<uintptr_t>(value_.data());
+				const auto self = reinterpret_cast<uintptr_t>(this);
+				return data >= self && data < self + sizeof(*this) ? 0u : value_.capacity() + 1u;
+			}
+			else {
+				return 0u;
+			}
+		}
+
 	private:
 		T value_;
 	};
 
-	// Таблица символов, связывающая имя объекта с его значением
-	using Closure = std::unordered_map<std::string, ObjectHolder>;
+	/*
+	Аргументы вызова метода или встроенной функции: непрерывная последовательность значений,
+	которыми вызываемый код не владеет. Вызывающий код вычисляет аргументы в собственный буфер
+	(обычно массив на стеке), так что передача аргументов не выделяет память
+	*/
+	class Arguments {
+	public:
+		Arguments(const ObjectHolder* data, size_t size)
+			: data_(data)
+			, size_(size) {
+		}
+
+		Arguments(const std::vector<ObjectHolder>& args)  // NOLINT
+			: Arguments(args.data(), args.size()) {
+		}
+
+		// Список значений живёт до конца полного выражения, поэтому подходит только для аргументов вызова
+		Arguments(std::initializer_list<ObjectHolder> args)  // NOLINT
+			: Arguments(args.begin(), args.size()) {
+		}
+
+		[[nodiscard]] size_t size() const {
+			return size_;
+		}
+
+		[[nodiscard]] bool empty() const {
+			return size_ == 0u;
+		}
+
+		[[nodiscard]] const ObjectHolder& operator[](size_t index) const {
+			return data_[index];
+		}
+
+		[[nodiscard]] const ObjectHolder& front() const {
+			return data_[0];
+		}
+
+		[[nodiscard]] const ObjectHolder* begin() const {
+			return data_;
+		}
+
+		[[nodiscard]] const ObjectHolder* end() const {
+			return data_ + size_;
+		}
+
+	private:
+		const ObjectHolder* data_;
+		size_t size_;
+	};
+
+	// Наибольшее число аргументов, которые вызовы методов и встроенных функций вычисляют в массив
+	// на стеке. Аргументы вызовов с большим числом параметров размещаются в куче
+	inline constexpr size_t INLINE_ARGUMENT_COUNT = 8u;
+
+	/*
+	Таблица символов, связывающая имя объекта с его значением. Интерфейс повторяет используемую
+	интерпретатором часть std::unordered_map<std::string, ObjectHolder>.
+
+	Переменные хранятся в порядке добавления и не перемещаются, поэтому ссылки на значения
+	остаются действительными, пока существует таблица. Удалённая переменная только помечается
+	свободной, а повторное присваивание переменной с тем же именем не выделяет память. Поэтому
+	кадр вызова, который контекст переиспользует (см. Context::PushFrame), после первого вызова
+	не выделяет память ни для self и параметров, ни для локальных переменных.
+	Небольшие таблицы просматриваются линейно, для больших строится индекс с открытой адресацией
+	*/
+	class Closure {
+	public:
+		// Переменная: имя first и значение second
+		struct value_type {
+			std::string first;
+			ObjectHolder second;
+		};
+
+		template <typename Owner, typename Value>
+		class BasicIterator {
+		public:
+			BasicIterator(Owner* owner, size_t index)
+				: owner_(owner)
+				, index_(owner->SkipFree(index)) {
+			}
+
+			// Константный итератор создаётся из обычного
+			BasicIterator(const BasicIterator<Closure, value_type>& other)  // NOLINT
+				: owner_(other.owner_)
+				, index_(other.index_) {
+			}
+
+			Value& operator*() const {
+				return owner_->entries_[index_].item;
+			}
+
+			Value* operator->() const {
+				return &**this;
+			}
+
+			BasicIterator& operator++() {
+				index_ = owner_->SkipFree(index_ + 1u);
+				return *this;
+			}
+
+			bool operator==(const BasicIterator& rhs) const {
+				return index_ == rhs.index_;
+			}
+
+			bool operator!=(const BasicIterator& rhs) const {
+				return index_ != rhs.index_;
+			}
+
+		private:
+			friend class Closure;
+			template <typename, typename>
+			friend class BasicIterator;
+
+			Owner* owner_;
+			size_t index_;
+		};
+
+		using iterator = BasicIterator<Closure, value_type>;
+		using const_iterator = BasicIterator<const Closure, const value_type>;
+
+		Closure() = default;
+		Closure(std::initializer_list<std::pair<std::string, ObjectHolder>> items);
+
+		[[nodiscard]] iterator begin() {
+			return { this, 0u };
+		}
+		[[nodiscard]] iterator end() {
+			return { this, entries_.size() };
+		}
+		[[nodiscard]] const_iterator begin() const {
+			return { this, 0u };
+		}
+		[[nodiscard]] const_iterator end() const {
+			return { this, entries_.size() };
+		}
+
+		[[nodiscard]] iterator find(const std::string& name);
+		[[nodiscard]] const_iterator find(const std::string& name) const;
+
+		[[nodiscard]] size_t count(const std::string& name) const {
+			return find(name) != end() ? 1u : 0u;
+		}
+
+		// Возвращает значение переменной. Если переменной нет, выбрасывает out_of_range
+		ObjectHolder& at(const std::string& name);
+		const ObjectHolder& at(const std::string& name) const;
+
+		// Возвращает значение переменной name, добавляя переменную со значением None, если её нет
+		ObjectHolder& operator[](const std::string& name);
+
+		// Добавляет переменную, если её нет. Возвращает итератор на переменную и true, если она добавлена
+		std::pair<iterator, bool> insert(std::pair<std::string, ObjectHolder> item);
+
+		// Удаляет переменную и возвращает итератор на следующую
+		iterator erase(iterator it);
+		size_t erase(const std::string& name);
+
+		// Удаляет все переменные, освобождая их значения
+		void clear();
+
+		[[nodiscard]] size_t size() const {
+			return size_;
+		}
+
+		[[nodiscard]] bool empty() const {
+			return size_ == 0u;
+		}
+
+		// Возвращает номер переменной name, добавляя её при необходимости. Переменная не
+		// становится присвоенной, номер не меняется, пока существует таблица
+		[[nodiscard]] size_t Declare(const std::string& name);
+
+		// Присваивает значение переменной с номером index (см. Declare)
+		void Bind(size_t index, ObjectHolder value);
+
+	private:
+		struct Entry {
+			value_type item;
+			bool bound = false;
+		};
+
+		static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+		static constexpr uint32_t EMPTY_SLOT = static_cast<uint32_t>(-1);
+		// Наибольшее число переменных, которые ищутся без индекса
+		static constexpr size_t LINEAR_LIMIT = 16u;
+
+		// Возвращает номер записи с именем name (присвоенной или свободной) либо NOT_FOUND
+		[[nodiscard]] size_t Find(const std::string& name) const;
+		// Добавляет свободную запись с именем name и возвращает её номер
+		size_t Insert(const std::string& name);
+		void AddToIndex(size_t index);
+		// Возвращает номер первой присвоенной записи, начиная с index, либо entries_.size()
+		[[nodiscard]] size_t SkipFree(size_t index) const;
+
+		// deque не перемещает элементы при добавлении в конец
+		std::deque<Entry> entries_;
+		// Номера записей в ячейках индекса; пуст, пока записей не больше LINEAR_LIMIT
+		std::vector<uint32_t> index_;
+		size_t size_ = 0;
+	};
 
 	// Проверяет, содержится ли в object значение, приводимое к True
-	// Для отличных от нуля чисел, True и непустых строк возвращается true. В остальных случаях - false.
+	// Для отличных от нуля чисел, True, непустых строк, списков и словарей возвращается true.
+	// В остальных случаях - false.
 	bool IsTrue(const ObjectHolder& object);
 
 	// Интерфейс для выполнения действий над объектами Mython
@@ -104,6 +791,13 @@ namespace runtime {
 		// Выполняет действие над объектами внутри closure, используя context
 		// Возвращает результирующее значение либо None
 		virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
+
+		// Вычисляет значение в логическом контексте, то же, что IsTrue(Execute(closure, context)).
+		// Узлы, результат которых сразу известен как bool, переопределяют метод, чтобы не создавать
+		// промежуточный объект Bool
+		virtual bool EvaluateCondition(Closure& closure, Context& context) {
+			return IsTrue(Execute(closure, context));
+		}
 	};
 
 	// Строковое значение
@@ -112,13 +806,35 @@ namespace runtime {
 	using Number = ValueObject<int>;
 
 	// Логическое значение
-	class Bool : public ValueObject<bool> {
+	class Bool final : public ValueObject<bool> {
 	public:
 		using ValueObject<bool>::ValueObject;
 
 		void Print(std::ostream& os, Context& context) override;
 	};
 
+	// Представление, в котором выполняется метод
+	enum class Tier : uint8_t {
+		Interpreter,  // обход дерева; узлы специализируются сами (см. ast::OperandProfile)
+		Native,       // машинный код (см. jit::Jit)
+	};
+
+	/*
+	Счётчики выполнения метода. Число вызовов увеличивает ClassInstance::Call, остальные
+	счётчики ведёт компилятор методов. Счётчики - обычные целые без синхронизации, поэтому
+	их можно не отключать
+	*/
+	struct MethodProfile {
+		// Число вызовов метода
+		uint64_t calls = 0;
+		// Число вызовов, выполненных машинным кодом
+		uint64_t native_calls = 0;
+		// Число возвратов из машинного кода в интерпретатор из-за нарушенных предположений
+		uint64_t deoptimizations = 0;
+		// Текущее представление метода
+		Tier tier = Tier::Interpreter;
+	};
+
 	// Метод класса
 	struct Method {
 		// Имя метода
@@ -127,34 +843,694 @@ namespace runtime {
 		std::vector<std::string> formal_params;
 		// Тело метода
 		std::unique_ptr<Executable> body;
+		// Счётчики выполнения. Изменяются и у константного метода
+		mutable MethodProfile profile{};
+	};
+
+	// Политика выбора представления метода по его счётчикам
+	class TieringPolicy {
+	public:
+		virtual ~TieringPolicy() = default;
+
+		// Возвращает представление, в котором метод должен выполняться. Если оно ниже текущего,
+		// метод возвращается в интерпретатор
+		[[nodiscard]] virtual Tier SelectTier(const MethodProfile& profile) const = 0;
+	};
+
+	// Переводит метод в машинный код после native_threshold вызовов и навсегда возвращает
+	// в интерпретатор после max_deoptimizations возвратов из машинного кода
+	class ThresholdTieringPolicy : public TieringPolicy {
+	public:
+		static constexpr uint64_t DEFAULT_NATIVE_THRESHOLD = 50u;
+		static constexpr uint64_t DEFAULT_MAX_DEOPTIMIZATIONS = 16u;
+
+		explicit ThresholdTieringPolicy(uint64_t native_threshold = DEFAULT_NATIVE_THRESHOLD,
+			uint64_t max_deoptimizations = DEFAULT_MAX_DEOPTIMIZATIONS)
+			: native_threshold_(native_threshold)
+			, max_deoptimizations_(max_deoptimizations) {
+		}
+
+		[[nodiscard]] Tier SelectTier(const MethodProfile& profile) const override {
+			if (profile.deoptimizations >= max_deoptimizations_ || profile.calls < native_threshold_) {
+				return Tier::Interpreter;
+			}
+			return Tier::Native;
+		}
+
+	private:
+		uint64_t native_threshold_;
+		uint64_t max_deoptimizations_;
+	};
+
+	// Хвостовой вызов object.method(args), отложенный инструкцией return до выхода из тела метода
+	struct TailCall {
+		ObjectHolder object;
+		const Method* method = nullptr;
+		std::vector<ObjectHolder> args;
+	};
+
+	/*
+	Компилятор методов в машинный код (см. jit::Jit). Если он задан в контексте,
+	ClassInstance::Call перед выполнением метода интерпретатором предлагает вызов ему
+	*/
+	class MethodCompiler {
+	public:
+		virtual ~MethodCompiler() = default;
+
+		// Выполняет вызов self.method(args) скомпилированным кодом. Возвращает nullopt,
+		// если вызов должен выполнить интерпретатор
+		virtual std::optional<ObjectHolder> TryCall(ClassInstance& self, const Method& method,
+			Arguments args, Context& context) = 0;
+	};
+
+	/*
+	Кэш результатов вызовов методов (см. memo::Memoizer). Если он задан в контексте,
+	ClassInstance::Call предлагает вызов ему до компилятора методов и интерпретатора
+	*/
+	class CallCache {
+	public:
+		virtual ~CallCache() = default;
+
+		// Возвращает результат вызова self.method(args), найденный в кэше либо вычисленный
+		// через ClassInstance::Invoke и сохранённый. Возвращает nullopt, если результат вызова
+		// кэшировать нельзя
+		virtual std::optional<ObjectHolder> TryCall(ClassInstance& self, const Method& method,
+			Arguments args, Context& context) = 0;
+	};
+
+	/*
+	Учёт объектов, которые могут образовывать циклы ссылок (см. gc::Collector). Если он задан
+	в контексте, экземпляры классов, списки и словари, создаваемые программой в куче и пулах,
+	передаются ему сразу после создания
+	*/
+	class ObjectTracker {
+	public:
+		virtual ~ObjectTracker() = default;
+
+		// Начинает отслеживать только что созданный объект object
+		virtual void Track(Container& object) = 0;
+	};
+
+	/*
+	Память кадра вызова для объектов, которые не покидают метод (см. ast::FrameAllocation).
+	Объекты размещаются подряд в страницах размером PAGE_SIZE, выровненных по своему размеру,
+	так что страница блока находится по его адресу. Каждая страница считает свои живые блоки:
+	страница, блоки которой освобождены, сразу возвращается арене и используется снова. Объекты
+	кадра освобождаются вместе с его переменными при снятии кадра со стека (см. Context::PopFrame),
+	поэтому после первого вызова на той же глубине такие объекты не выделяют память в куче.
+	Блоки больше MAX_BLOCK_SIZE выделяются оператором new.
+	Блок может пережить арену: страница с живыми блоками уничтожается вместе с последним из них.
+	Арена контекста служит так же областью промежуточных значений инструкций верхнего уровня
+	программы (см. Context::GetFrameArena)
+	*/
+	class FrameArena {
+	public:
+		static constexpr size_t PAGE_SIZE = 4096u;
+		static constexpr size_t MAX_BLOCK_SIZE = 512u;
+
+		FrameArena() = default;
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+		~FrameArena();
+
+		// Выделяет блок размером size байт, выровненный как max_align_t
+		[[nodiscard]] void* Allocate(size_t size);
+		// Возвращает блок, выделенный Allocate с тем же size. Не обращается к арене, если
+		// она уже уничтожена
+		static void Deallocate(void* block, size_t size) noexcept;
+
+		// Создаёт в арене объект типа T из args
+		template <typename T, typename... Args>
+		[[nodiscard]] ObjectHolder Create(Args&&... args) {
+			void* block = Allocate(sizeof(T));
+			T* object;
+			try {
+				object = new (block) T(std::forward<Args>(args)...);
+			}
+			catch (...) {
+				Deallocate(block, sizeof(T));
+				throw;
+			}
+			return ObjectHolder::Adopt(object, Storage::Frame, sizeof(T));
+		}
+
+		// Возвращает число выданных и ещё не возвращённых блоков
+		[[nodiscard]] size_t GetLiveCount() const {
+			return live_count_;
+		}
+
+		// Возвращает число страниц арены, включая свободные
+		[[nodiscard]] size_t GetPageCount() const {
+			return page_count_;
+		}
+
+	private:
+		struct Page {
+			// nullptr, если арена уничтожена раньше блоков страницы
+			FrameArena* owner;
+			// Соседи в списке занятых страниц либо следующая свободная страница в next
+			Page* prev;
+			Page* next;
+			size_t live;
+			size_t used;
+		};
+
+		static constexpr size_t HEADER_SIZE
+			= (sizeof(Page) + alignof(std::max_align_t) - 1u) / alignof(std::max_align_t) * alignof(std::max_align_t);
+		static_assert(HEADER_SIZE + MAX_BLOCK_SIZE <= PAGE_SIZE);
+
+		// Делает текущей страницу из списка свободных либо новую
+		void NextPage();
+		// Возвращает опустевшую страницу в список свободных
+		void Recycle(Page* page) noexcept;
+
+		// Страница, из которой выделяются блоки; входит в список занятых
+		Page* current_ = nullptr;
+		Page* used_pages_ = nullptr;
+		Page* free_pages_ = nullptr;
+		size_t live_count_ = 0;
+		size_t page_count_ = 0;
+	};
+
+	// Кадр вызова метода: self, параметры и локальные переменные
+	struct Frame {
+		// Объявлена первой, чтобы уничтожаться после переменных
+		FrameArena arena;
+		Closure locals;
+		// Метод, для которого в slots записаны номера переменных self и параметров в locals.
+		// Параметры связываются с аргументами по позиции, без поиска по имени
+		const Method* method = nullptr;
+		std::vector<size_t> slots;
+	};
+
+	// Максимальная глубина вызовов методов по умолчанию
+	inline constexpr size_t DEFAULT_MAX_CALL_DEPTH = 1000u;
+
+	// Контекст исполнения инструкций Mython
+	class Context {
+	public:
+		// Возвращает поток вывода для команд print
+		virtual std::ostream& GetOutputStream() = 0;
+
+		// Запоминает результат инструкции return. Пока результат не забран методом TakeReturnValue,
+		// составные инструкции не выполняют оставшиеся в них инструкции
+		void SetReturnValue(ObjectHolder value) {
+			return_value_ = std::move(value);
+			returning_ = true;
+		}
+
+		// Возвращает true, если была выполнена инструкция return, результат которой ещё не забран
+		[[nodiscard]] bool IsReturning() const {
+			return returning_;
+		}
+
+		// Забирает результат инструкции return
+		ObjectHolder TakeReturnValue() {
+			returning_ = false;
+			return std::move(return_value_);
+		}
+
+		// Откладывает хвостовой вызов до выхода из тела текущего метода.
+		// Вызов выполняется в кадре текущего метода (см. ClassInstance::Call)
+		void SetTailCall(ObjectHolder object, const Method& method, Arguments args) {
+			tail_call_.object = std::move(object);
+			tail_call_.method = &method;
+			// Вектор аргументов переиспользуется: память выделяется, только пока он растёт
+			tail_call_.args.assign(args.begin(), args.end());
+		}
+
+		// Возвращает указатель на отложенный хвостовой вызов либо nullptr
+		[[nodiscard]] TailCall* GetTailCall() {
+			return tail_call_.method ? &tail_call_ : nullptr;
+		}
+
+		// Отмечает отложенный хвостовой вызов выполненным
+		void ClearTailCall() {
+			tail_call_.object = ObjectHolder::None();
+			tail_call_.method = nullptr;
+			tail_call_.args.clear();
+		}
+
+		// Возвращает количество выполняющихся в данный момент вызовов методов
+		[[nodiscard]] size_t GetCallDepth() const {
+			return call_depth_;
+		}
+
+		// Возвращает и задаёт максимальную глубину вызовов методов
+		[[nodiscard]] size_t GetMaxCallDepth() const {
+			return max_call_depth_;
+		}
+		void SetMaxCallDepth(size_t max_call_depth) {
+			max_call_depth_ = max_call_depth;
+		}
+
+		// Возвращает и задаёт компилятор методов. По умолчанию методы только интерпретируются
+		[[nodiscard]] MethodCompiler* GetMethodCompiler() const {
+			return method_compiler_;
+		}
+		void SetMethodCompiler(MethodCompiler* method_compiler) {
+			method_compiler_ = method_compiler;
+		}
+
+		// Возвращает и задаёт кэш результатов вызовов. По умолчанию результаты не кэшируются
+		[[nodiscard]] CallCache* GetCallCache() const {
+			return call_cache_;
+		}
+		void SetCallCache(CallCache* call_cache) {
+			call_cache_ = call_cache;
+		}
+
+		// Возвращает память текущего кадра для объектов, не покидающих метод, а вне вызова метода -
+		// память промежуточных значений инструкций верхнего уровня. Если размещение объектов в кадре
+		// выключено, возвращает nullptr
+		[[nodiscard]] FrameArena* GetFrameArena() {
+			if (!frame_allocation_) {
+				return nullptr;
+			}
+			return call_depth_ > 0u ? &frames_[call_depth_ - 1u]->arena : &statement_arena_;
+		}
+
+		// Включает или выключает размещение объектов в памяти кадров. По умолчанию включено
+		void SetFrameAllocation(bool enabled) {
+			frame_allocation_ = enabled;
+		}
+
+		// Возвращает и задаёт учёт объектов, которые могут образовывать циклы. По умолчанию объекты
+		// освобождаются только подсчётом ссылок, и циклы не освобождаются
+		[[nodiscard]] ObjectTracker* GetObjectTracker() const {
+			return object_tracker_;
+		}
+		void SetObjectTracker(ObjectTracker* object_tracker) {
+			object_tracker_ = object_tracker;
+		}
+
+		// Кладёт на стек кадров кадр для нового вызова метода и возвращает его. Кадры хранятся
+		// в куче и переиспользуются: переменные кадра, оставшиеся от прошлого вызова на той же
+		// глубине, удалены, но сохраняют память. Если глубина вызовов превысит максимальную,
+		// выбрасывает runtime_error
+		Frame& PushFrame();
+		// Снимает со стека кадр завершившегося вызова, удаляя его переменные
+		void PopFrame();
+
+	protected:
+		~Context() = default;
+
+	private:
+		// Объявлена первой, чтобы уничтожаться после всех значений контекста
+		FrameArena statement_arena_;
+		ObjectHolder return_value_;
+		bool returning_ = false;
+		TailCall tail_call_;
+		std::vector<std::unique_ptr<Frame>> frames_;
+		size_t call_depth_ = 0;
+		size_t max_call_depth_ = DEFAULT_MAX_CALL_DEPTH;
+		MethodCompiler* method_compiler_ = nullptr;
+		CallCache* call_cache_ = nullptr;
+		ObjectTracker* object_tracker_ = nullptr;
+		bool frame_allocation_ = true;
+	};
+
+	/*
+	 * Форма (скрытый класс) экземпляра: сопоставляет именам полей их смещения в хранилище
+	 * экземпляра. Экземпляры, поля которых добавлялись в одном и том же порядке, разделяют
+	 * одну форму. Формы образуют дерево с корнем в классе, переходы по добавлению поля кэшируются
+	 */
+	class Shape {
+	public:
+		// Смещение, возвращаемое для отсутствующего поля
+		static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+		// Создаёт корневую (пустую) форму
+		Shape();
+
+		Shape(const Shape&) = delete;
+		Shape& operator=(const Shape&) = delete;
+
+		// Возвращает смещение поля name либо NO_SLOT, если такого поля в форме нет
+		[[nodiscard]] size_t FindSlot(const std::string& name) const;
+
+		// Возвращает форму, полученную добавлением поля name. Поля name в форме быть не должно
+		[[nodiscard]] const Shape* AddField(const std::string& name) const;
+
+		// Возвращает количество полей формы
+		[[nodiscard]] size_t GetFieldCount() const {
+			return field_names_.size();
+		}
+
+		// Возвращает имя поля, хранящегося по смещению slot
+		[[nodiscard]] const std::string& GetFieldName(size_t slot) const {
+			return field_names_[slot];
+		}
+
+		// Возвращает наибольшее количество полей среди форм дерева.
+		// Используется для резервирования хранилища новых экземпляров
+		[[nodiscard]] size_t GetExpectedFieldCount() const {
+			return root_->max_field_count_;
+		}
+
+	private:
+		Shape(const Shape& parent, const std::string& name);
+
+		const Shape* root_;
+		std::vector<std::string> field_names_;
+		std::unordered_map<std::string, size_t> slots_;
+		mutable std::unordered_map<std::string, std::unique_ptr<Shape>> transitions_;
+		mutable size_t max_field_count_ = 0;
+	};
+
+	// Поля экземпляра класса: форма и компактный массив значений, упорядоченный по смещениям формы
+	class InstanceFields {
+	public:
+		// Итератор по парам (имя поля, значение)
+		template <typename Fields, typename Value>
+		class BasicIterator {
+		public:
+			using value_type = std::pair<const std::string&, Value&>;
+
+			BasicIterator(Fields* fields, size_t slot)
+				: fields_(fields)
+				, slot_(slot) {
+			}
+
+			value_type operator*() const {
+				return { fields_->shape_->GetFieldName(slot_), fields_->values_[slot_] };
+			}
+
+			// Прокси, позволяющий обращаться к it->first и it->second
+			struct Arrow {
+				value_type pair;
+				const value_type* operator->() const {
+					return &pair;
+				}
+			};
+
+			Arrow operator->() const {
+				return { **this };
+			}
+
+			BasicIterator& operator++() {
+				++slot_;
+				return *this;
+			}
+
+			bool operator==(const BasicIterator& rhs) const {
+				return fields_ == rhs.fields_ && slot_ == rhs.slot_;
+			}
+
+			bool operator!=(const BasicIterator& rhs) const {
+				return !(*this == rhs);
+			}
+
+		private:
+			Fields* fields_;
+			size_t slot_;
+		};
+
+		using iterator = BasicIterator<InstanceFields, ObjectHolder>;
+		using const_iterator = BasicIterator<const InstanceFields, const ObjectHolder>;
+
+		// Создаёт пустой набор полей с корневой формой root
+		explicit InstanceFields(const Shape& root);
+
+		// Возвращает значение поля name, добавляя поле со значением None при его отсутствии
+		ObjectHolder& operator[](const std::string& name);
+
+		// Возвращает значение поля name либо выбрасывает out_of_range при его отсутствии
+		ObjectHolder& at(const std::string& name);
+		const ObjectHolder& at(const std::string& name) const;
+
+		[[nodiscard]] iterator find(const std::string& name);
+		[[nodiscard]] const_iterator find(const std::string& name) const;
+
+		[[nodiscard]] size_t count(const std::string& name) const {
+			return shape_->FindSlot(name) != Shape::NO_SLOT ? 1u : 0u;
+		}
+
+		[[nodiscard]] size_t size() const {
+			return values_.size();
+		}
+
+		// Возвращает число полей, для которых выделена память
+		[[nodiscard]] size_t capacity() const {
+			return values_.capacity();
+		}
+
+		[[nodiscard]] bool empty() const {
+			return values_.empty();
+		}
+
+		[[nodiscard]] iterator begin() {
+			return { this, 0u };
+		}
+
+		[[nodiscard]] iterator end() {
+			return { this, values_.size() };
+		}
+
+		[[nodiscard]] const_iterator begin() const {
+			return { this, 0u };
+		}
+
+		[[nodiscard]] const_iterator end() const {
+			return { this, values_.size() };
+		}
+
+		// Возвращает текущую форму. Используется inline-кэшами доступа к полям
+		[[nodiscard]] const Shape* GetShape() const {
+			return shape_;
+		}
+
+		// Возвращает значение по смещению slot текущей формы
+		[[nodiscard]] ObjectHolder& GetSlot(size_t slot) {
+			return values_[slot];
+		}
+
+		/*
+		 * Переводит поля в форму new_shape, полученную из текущей добавлением одного поля,
+		 * и записывает value в новое поле. Возвращает ссылку на записанное значение
+		 */
+		ObjectHolder& AddSlot(const Shape* new_shape, ObjectHolder value);
+
+	private:
+		const Shape* shape_;
+		std::vector<ObjectHolder> values_;
+	};
+
+	// Специальные методы, для которых в таблице методов класса отведены отдельные ячейки
+	enum class SpecialMethod {
+		Init,  // __init__
+		Str,   // __str__
+		Eq,    // __eq__
+		Lt,    // __lt__
+		Add,   // __add__
+		Cmp,   // __cmp__
+	};
+
+	// Количество специальных методов
+	inline constexpr size_t SPECIAL_METHOD_COUNT = 6u;
+
+	/*
+	Пул памяти для экземпляров классов. Запросы разбиты на классы размеров с шагом SIZE_STEP.
+	Освобождённые блоки каждого размера образуют односвязный список и выдаются снова, а новые
+	блоки нарезаются из страниц, размер которых удваивается от MIN_PAGE_SIZE до MAX_PAGE_SIZE.
+	Блоки больше MAX_BLOCK_SIZE выделяются оператором new.
+	Экземпляр может пережить свой класс, поэтому владелец пула не уничтожает его, а отказывается
+	от него вызовом Release: пул вместе со страницами уничтожается, когда владелец отказался от
+	него и все блоки возвращены. Пул, как и интерпретатор, не потокобезопасен
+	*/
+	class InstancePool {
+	public:
+		static constexpr size_t SIZE_STEP = 16u;
+		static constexpr size_t MAX_BLOCK_SIZE = 512u;
+		static constexpr size_t MIN_PAGE_SIZE = 1024u;
+		static constexpr size_t MAX_PAGE_SIZE = 64u * 1024u;
+
+		// Создаёт пул, владелец которого должен вызвать Release
+		[[nodiscard]] static InstancePool* Create() {
+			return new InstancePool();
+		}
+
+		InstancePool(const InstancePool&) = delete;
+		InstancePool& operator=(const InstancePool&) = delete;
+
+		// Отказ владельца от пула. Пул уничтожается сразу или после возврата последнего блока
+		void Release() noexcept;
+
+		// Выделяет блок размером size байт, выровненный как max_align_t
+		[[nodiscard]] void* Allocate(size_t size);
+		// Возвращает блок, выделенный Allocate с тем же size
+		void Deallocate(void* block, size_t size) noexcept;
+
+		// Возвращает число выданных и ещё не возвращённых блоков
+		[[nodiscard]] size_t GetLiveCount() const {
+			return live_count_;
+		}
+
+		// Возвращает суммарный размер страниц пула в байтах
+		[[nodiscard]] size_t GetReservedBytes() const {
+			return reserved_bytes_;
+		}
+
+	private:
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		InstancePool() = default;
+		~InstancePool() = default;
+
+		// Нарезает новую страницу на блоки класса размеров size_class
+		void Refill(size_t size_class);
+
+		std::array<FreeBlock*, MAX_BLOCK_SIZE / SIZE_STEP> free_lists_ = {};
+		std::vector<std::unique_ptr<std::byte[]>> pages_;
+		size_t next_page_size_ = MIN_PAGE_SIZE;
+		size_t live_count_ = 0;
+		size_t reserved_bytes_ = 0;
+		bool released_ = false;
+	};
+
+	// Удалитель для unique_ptr, отказывающийся от пула (см. InstancePool::Release)
+	struct InstancePoolReleaser {
+		void operator()(InstancePool* pool) const noexcept {
+			pool->Release();
+		}
+	};
+
+	// Состояние объекта в сборщике циклов
+	enum class TrackingState : uint8_t {
+		Untracked,   // объект не отслеживается
+		Tracked,     // объект находится в списке поколения
+		Collecting,  // поколение объекта собирается, достижимость ещё не установлена
+		Reachable,   // поколение объекта собирается, объект достижим
+	};
+
+	/*
+	Узел кольцевого двусвязного списка объектов, отслеживаемых сборщиком циклов. Объект удаляет
+	себя из списка сам, поэтому для этого не нужен владелец списка. Копия узла не входит в список
+	*/
+	struct TrackingNode {
+		TrackingNode() = default;
+		TrackingNode(const TrackingNode& /*other*/) noexcept {
+		}
+		TrackingNode& operator=(const TrackingNode& /*other*/) noexcept {
+			return *this;
+		}
+
+		// Возвращает true, если узел входит в список
+		[[nodiscard]] bool IsLinked() const {
+			return next != nullptr;
+		}
+
+		// Вставляет узел в список перед узлом position
+		void LinkBefore(TrackingNode& position) noexcept {
+			prev = position.prev;
+			next = &position;
+			prev->next = this;
+			position.prev = this;
+		}
+
+		// Удаляет узел из списка, если он в него входит
+		void Unlink() noexcept {
+			if (next) {
+				prev->next = next;
+				next->prev = prev;
+				prev = next = nullptr;
+			}
+		}
+
+		TrackingNode* prev = nullptr;
+		TrackingNode* next = nullptr;
+		// Число ссылок на объект, не объяснённых ссылками из собираемого поколения
+		uint32_t gc_refs = 0;
+		TrackingState state = TrackingState::Untracked;
+	};
+
+	/*
+	Объект, хранящий ссылки на другие объекты и потому способный входить в цикл ссылок:
+	экземпляр класса, список или словарь. Подсчёт ссылок не освобождает циклы, их находит
+	сборщик циклов (см. gc::Collector), если он задан в контексте
+	*/
+	class Container : public Object, public TrackingNode {
+	public:
+		~Container() override {
+			Unlink();
+		}
+
+	protected:
+		using Object::Object;
 	};
 
 	// Класс
-	class Class : public Object {
+	class Class final : public Object {
 	public:
+		static constexpr ObjectType TYPE = ObjectType::Class;
+
 		// Создаёт класс с именем name и набором методов methods, унаследованный от класса parent
-		// Если parent равен nullptr, то создаётся базовый класс
+		// Если parent равен nullptr, то создаётся базовый класс.
+		// Таблица методов, включающая унаследованные методы, строится при создании класса
 		explicit Class(std::string name, std::vector<Method> methods, const Class* parent);
 
+		// Таблица методов ссылается на элементы methods_, поэтому класс можно только перемещать
+		Class(const Class&) = delete;
+		Class(Class&&) = default;
+
 		// Возвращает указатель на метод name или nullptr, если метод с таким именем отсутствует
 		[[nodiscard]] const Method* GetMethod(const std::string& name) const;
 
+		// Возвращает указатель на специальный метод или nullptr, если он отсутствует
+		[[nodiscard]] const Method* GetMethod(SpecialMethod method) const {
+			return special_methods_[static_cast<size_t>(method)];
+		}
+
 		// Возвращает имя класса
 		[[nodiscard]] inline const std::string& GetName() const {
 			return name_;
 		}
 
+		// Возвращает собственные (не унаследованные) методы класса
+		[[nodiscard]] const std::vector<Method>& GetOwnMethods() const {
+			return methods_;
+		}
+
+		// Возвращает родительский класс либо nullptr
+		[[nodiscard]] const Class* GetParent() const {
+			return parent_;
+		}
+
+		// Возвращает корневую форму экземпляров класса
+		[[nodiscard]] const Shape& GetRootShape() const {
+			return *root_shape_;
+		}
+
+		// Создаёт экземпляр класса без вызова конструктора. Память берётся из пула экземпляров класса
+		[[nodiscard]] ObjectHolder CreateInstance() const;
+		// Создаёт экземпляр класса без вызова конструктора в памяти кадра arena
+		[[nodiscard]] ObjectHolder CreateInstance(FrameArena& arena) const;
+
+		// Возвращает пул, из которого выделяются экземпляры класса
+		[[nodiscard]] const InstancePool& GetInstancePool() const {
+			return *instance_pool_;
+		}
+
 		// Выводит в os строку "Class <имя класса>", например "Class cat"
 		void Print(std::ostream& os, Context& context) override;
 	private:
 		std::string name_;
 		std::vector<Method> methods_;
 		const Class* parent_;
+		std::unique_ptr<Shape> root_shape_;
+		std::unique_ptr<InstancePool, InstancePoolReleaser> instance_pool_{ InstancePool::Create() };
+		// Собственные и унаследованные методы класса
+		std::unordered_map<std::string, const Method*> method_table_;
+		const Method* special_methods_[SPECIAL_METHOD_COUNT] = {};
 	};
 
 	// Экземпляр класса
-	class ClassInstance : public Object {
+	class ClassInstance final : public Container {
 	public:
+		static constexpr ObjectType TYPE = ObjectType::ClassInstance;
+
 		explicit ClassInstance(const Class& cls);
 
 		/*
@@ -169,23 +1545,267 @@ namespace runtime {
 		 * Если ни сам класс, ни его родители не содержат метод method, метод выбрасывает исключение
 		 * runtime_error
 		 */
-		ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& actual_args,
+		ObjectHolder Call(const std::string& method, Arguments actual_args,
+			Context& context);
+
+		// Вызывает у объекта метод method, найденный в таблице методов его класса.
+		// Количество actual_args должно совпадать с количеством параметров метода
+		ObjectHolder Call(const Method& method, Arguments actual_args,
+			Context& context);
+
+		// Выполняет вызов так же, как Call, но минуя кэш результатов (см. CallCache):
+		// предлагает вызов компилятору методов, а если тот отказался, интерпретирует тело метода
+		ObjectHolder Invoke(const Method& method, Arguments actual_args,
 			Context& context);
 
 		// Возвращает true, если объект имеет метод method, принимающий argument_count параметров
 		[[nodiscard]] bool HasMethod(const std::string& method, size_t argument_count) const;
 
-		// Возвращает ссылку на Closure, содержащий поля объекта
-		[[nodiscard]] Closure& Fields();
-		// Возвращает константную ссылку на Closure, содержащую поля объекта
-		[[nodiscard]] const Closure& Fields() const;
+		// Возвращает указатель на метод method, принимающий argument_count параметров, либо nullptr
+		[[nodiscard]] const Method* FindMethod(const std::string& method, size_t argument_count) const;
+
+		// Возвращает указатель на специальный метод method, принимающий argument_count параметров,
+		// либо nullptr
+		[[nodiscard]] const Method* FindMethod(SpecialMethod method, size_t argument_count) const;
+
+		// Возвращает класс объекта
+		[[nodiscard]] const Class& GetClass() const {
+			return cls_;
+		}
+
+		// Возвращает ссылку на поля объекта
+		[[nodiscard]] InstanceFields& Fields();
+		// Возвращает константную ссылку на поля объекта
+		[[nodiscard]] const InstanceFields& Fields() const;
+
+	protected:
+		[[nodiscard]] size_t GetPayloadSize() const override {
+			return fields_.capacity() * sizeof(ObjectHolder);
+		}
+
 	private:
+		friend class Class;
+		friend class Object;
+
 		const Class& cls_;
-		Closure fields_;
+		InstanceFields fields_;
+		// Пул, из которого выделена память экземпляра (см. Class::CreateInstance), либо nullptr
+		InstancePool* pool_ = nullptr;
+	};
+
+	/*
+	 * Список - изменяемая последовательность значений. Элементы хранятся в непрерывном массиве
+	 * ObjectHolder, поэтому обращение по индексу занимает O(1), а перебор идёт по соседним адресам
+	 */
+	class List final : public Container {
+	public:
+		static constexpr ObjectType TYPE = ObjectType::List;
+
+		List()
+			: Container(TYPE) {
+		}
+
+		explicit List(std::vector<ObjectHolder> items)
+			: Container(TYPE)
+			, items_(std::move(items)) {
+		}
+
+		// Выводит элементы через запятую в квадратных скобках, строки - в одинарных кавычках,
+		// например [1, 'a', None]. Список, содержащий сам себя, выводится как [...]
+		void Print(std::ostream& os, Context& context) override;
+
+		// Возвращает количество элементов
+		[[nodiscard]] size_t Size() const {
+			return items_.size();
+		}
+
+		// Возвращает элемент с индексом index. Отрицательный индекс отсчитывается от конца списка.
+		// Если элемента с таким индексом нет, выбрасывает runtime_error
+		[[nodiscard]] ObjectHolder& At(int index);
+		[[nodiscard]] const ObjectHolder& At(int index) const;
+
+		// Добавляет элемент в конец списка
+		void Append(ObjectHolder item) {
+			items_.push_back(std::move(item));
+			UpdateMemoryCharge();
+		}
+
+		// Удаляет все элементы
+		void Clear();
+
+		[[nodiscard]] const std::vector<ObjectHolder>& GetItems() const {
+			return items_;
+		}
+
+		// Возвращает true, если у списка есть встроенный метод method, принимающий argument_count
+		// параметров. Сейчас это только append(item)
+		[[nodiscard]] static bool HasMethod(const std::string& method, size_t argument_count);
+
+		// Вызывает встроенный метод списка. Если метода нет, выбрасывает runtime_error
+		ObjectHolder Call(const std::string& method, Arguments actual_args);
+
+	protected:
+		[[nodiscard]] size_t GetPayloadSize() const override {
+			return items_.capacity() * sizeof(ObjectHolder);
+		}
+
+	private:
+		std::vector<ObjectHolder> items_;
+		// Выставлен, пока список выводится: защищает от бесконечной рекурсии
+		bool printing_ = false;
+	};
+
+	/*
+	 * Словарь с ключами-числами, строками и значениями Bool. Элементы хранятся в массиве в порядке
+	 * добавления, а поиск идёт по хэш-таблице с открытой адресацией: ячейки разбиты на группы по
+	 * GROUP_SIZE, и для каждой ячейки хранится управляющий байт - EMPTY либо 7 младших бит хэша
+	 * ключа. Группа проверяется по управляющим байтам целиком, а ключи сравниваются только в ячейках
+	 * с совпавшим байтом. Хэш ключа хранится в элементе, поэтому при росте таблицы ключи не
+	 * хэшируются заново, а строки сравниваются, только если совпали хэши. Элементы не удаляются
+	 */
+	class Dict final : public Container {
+	public:
+		static constexpr ObjectType TYPE = ObjectType::Dict;
+
+		struct Entry {
+			ObjectHolder key;
+			ObjectHolder value;
+			size_t hash = 0;
+		};
+
+		Dict()
+			: Container(TYPE) {
+		}
+
+		// Выводит пары ключ: значение через запятую в фигурных скобках, строки - в одинарных
+		// кавычках, например {'a': 1, 2: None}. Словарь, содержащий сам себя, выводится как {...}
+		void Print(std::ostream& os, Context& context) override;
+
+		// Возвращает количество элементов
+		[[nodiscard]] size_t Size() const {
+			return entries_.size();
+		}
+
+		// Возвращает значение по ключу key либо nullptr, если ключа нет.
+		// Если key - не число, не строка и не Bool, выбрасывает runtime_error
+		[[nodiscard]] ObjectHolder* Find(const ObjectHolder& key);
+		[[nodiscard]] const ObjectHolder* Find(const ObjectHolder& key) const;
+
+		// Присваивает значение по ключу key, добавляя ключ в конец порядка обхода, если его не было
+		ObjectHolder& Set(const ObjectHolder& key, ObjectHolder value);
+
+		// Резервирует место для count элементов
+		void Reserve(size_t count);
+
+		// Удаляет все элементы
+		void Clear();
+
+		// Возвращает элементы в порядке добавления
+		[[nodiscard]] const std::vector<Entry>& GetEntries() const {
+			return entries_;
+		}
+
+		// Возвращает true, если у словаря есть встроенный метод method, принимающий argument_count
+		// параметров: get(key) возвращает значение или None, contains(key) - True, если ключ есть
+		[[nodiscard]] static bool HasMethod(const std::string& method, size_t argument_count);
+
+		// Вызывает встроенный метод словаря. Если метода нет, выбрасывает runtime_error
+		ObjectHolder Call(const std::string& method, Arguments actual_args);
+
+	protected:
+		[[nodiscard]] size_t GetPayloadSize() const override {
+			return entries_.capacity() * sizeof(Entry) + control_.capacity() + slots_.capacity() * sizeof(uint32_t);
+		}
+
+	private:
+		static constexpr size_t GROUP_SIZE = 8u;
+		static constexpr uint8_t EMPTY = 0x80u;
+		static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+		// Ищет ключ с хэшем hash. Возвращает номер элемента в entries_ либо NOT_FOUND; во втором
+		// случае в free_slot записывается свободная ячейка, в которую можно добавить ключ
+		size_t Probe(const ObjectHolder& key, size_t hash, size_t& free_slot) const;
+		// Строит таблицу с capacity ячейками заново по сохранённым хэшам
+		void Rehash(size_t capacity);
+
+		std::vector<Entry> entries_;
+		std::vector<uint8_t> control_;
+		// Номер элемента entries_ для каждой занятой ячейки
+		std::vector<uint32_t> slots_;
+		bool printing_ = false;
+	};
+
+	// Возвращает true, если у объекта есть встроенный метод method с argument_count параметрами
+	// (см. List::HasMethod, Dict::HasMethod)
+	[[nodiscard]] bool HasBuiltinMethod(const ObjectHolder& object, const std::string& method, size_t argument_count);
+
+	// Вызывает встроенный метод списка или словаря. Если метода нет, выбрасывает runtime_error
+	ObjectHolder CallBuiltinMethod(const ObjectHolder& object, const std::string& method,
+		Arguments actual_args);
+
+	// Возвращает object[index]: элемент списка (индекс - число, отрицательный отсчитывается от конца),
+	// строку из одного символа строки или значение словаря. Если элемента нет, выбрасывает runtime_error
+	ObjectHolder GetItem(const ObjectHolder& object, const ObjectHolder& index);
+
+	// Выполняет object[index] = value для списка или словаря. Элемент списка должен существовать
+	void SetItem(const ObjectHolder& object, const ObjectHolder& index, ObjectHolder value);
+
+	// Возвращает количество элементов списка или словаря либо длину строки
+	int GetLength(const ObjectHolder& object);
+
+	// Количество элементов, которые перебирает цикл for по объекту: элементы списка или ключи
+	// словаря. Для других объектов выбрасывает runtime_error. Список и словарь могут расти во
+	// время обхода, поэтому количество проверяется перед каждой итерацией
+	size_t GetIterationSize(const ObjectHolder& iterable);
+
+	// Возвращает элемент с номером index, который перебирает цикл for
+	const ObjectHolder& GetIterationItem(const ObjectHolder& iterable, size_t index);
+
+	// Встроенная функция, реализованная на C++
+	struct BuiltinFunction {
+		using Callable = std::function<ObjectHolder(Arguments args, Context& context)>;
+
+		std::string name;
+		// Число параметров; парсер проверяет его в каждом месте вызова
+		size_t arity = 0;
+		Callable callable;
 	};
 
+	/*
+	Таблица встроенных функций, которые программа на Mython вызывает как f(args). Парсер
+	разрешает такие вызовы во время разбора: место вызова хранит ссылку на функцию, поэтому
+	при выполнении нет поиска ни в Closure, ни в таблице методов. Ссылки на функции остаются
+	действительными, пока существует таблица.
+	Вызов конструктора объявленного класса, str() и len() имеют приоритет над функциями таблицы
+	*/
+	class BuiltinRegistry {
+	public:
+		// Регистрирует функцию. Если имя уже занято, выбрасывает invalid_argument
+		const BuiltinFunction& Register(std::string name, size_t arity, BuiltinFunction::Callable callable);
+
+		// Возвращает функцию с именем name либо nullptr
+		[[nodiscard]] const BuiltinFunction* Find(const std::string& name) const;
+
+	private:
+		// Элементы unordered_map не перемещаются при росте таблицы
+		std::unordered_map<std::string, BuiltinFunction> functions_;
+	};
+
+	/*
+	Регистрирует стандартные функции:
+	  abs(x) - модуль числа;
+	  min(a, b), max(a, b) - меньшее и большее из значений, сравниваемых как операцией <;
+	  int(x) - число из десятичной записи в строке, из числа или из значения Bool
+	*/
+	void RegisterStandardBuiltins(BuiltinRegistry& registry);
+
+	// Таблица стандартных функций, которую парсер использует по умолчанию
+	[[nodiscard]] const BuiltinRegistry& StandardBuiltins();
+
 	/*
 	 * Возвращает true, если lhs и rhs содержат одинаковые числа, строки или значения типа Bool.
+	 * Списки равны, если равны их длины и попарно равны элементы. Словари равны, если содержат
+	 * одинаковые ключи с равными значениями.
 	 * Если lhs - объект с методом __eq__, функция возвращает результат вызова lhs.__eq__(rhs),
 	 * приведённый к типу Bool. Если lhs и rhs имеют значение None, функция возвращает true.
 	 * В остальных случаях функция выбрасывает исключение runtime_error.
@@ -205,13 +1825,85 @@ namespace runtime {
 	bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
 	// Возвращает значение, противоположное Equal(lhs, rhs, context)
 	bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-	// Возвращает значение lhs>rhs, используя функции Equal и Less
+	// Возвращает значение lhs>rhs (см. Compare)
 	bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-	// Возвращает значение lhs<=rhs, используя функции Equal и Less
+	// Возвращает значение lhs<=rhs (см. Compare)
 	bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
 	// Возвращает значение, противоположное Less(lhs, rhs, context)
 	bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
 
+	// Операция сравнения
+	enum class CompareOp : uint8_t {
+		Equal,
+		NotEqual,
+		Less,
+		Greater,
+		LessOrEqual,
+		GreaterOrEqual,
+	};
+
+	// Применяет операцию сравнения op к значениям, упорядоченным операторами == и <
+	template <typename T>
+	bool CompareValues(CompareOp op, const T& lhs, const T& rhs) {
+		switch (op) {
+		case CompareOp::Equal:
+			return lhs == rhs;
+		case CompareOp::NotEqual:
+			return !(lhs == rhs);
+		case CompareOp::Less:
+			return lhs < rhs;
+		case CompareOp::Greater:
+			return rhs < lhs;
+		case CompareOp::LessOrEqual:
+			return !(rhs < lhs);
+		case CompareOp::GreaterOrEqual:
+			return !(lhs < rhs);
+		}
+		return false;
+	}
+
+	/*
+	 * Вычисляет lhs <op> rhs. Числа, строки и значения bool сравниваются со значениями своего типа,
+	 * None равно None, списки и словари сравниваются только на равенство. Если lhs - объект
+	 * класса с методом __cmp__(rhs), любая операция вычисляется одним вызовом этого метода: он должен вернуть отрицательное число, ноль или положительное
+	 * число. Иначе используются методы __eq__ и __lt__: ==, != и <, >= требуют одного вызова;
+	 * для > и <= при сравнении объектов одного класса вызывается rhs.__lt__(lhs), в остальных
+	 * случаях значение выражается через __lt__ и __eq__ объекта lhs.
+	 * Если сравнение невозможно, выбрасывается исключение runtime_error
+	 */
+	bool Compare(CompareOp op, const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+	/*
+	 * Таблица ядер бинарной операции, индексируемая типами левого и правого операндов.
+	 * Kernel<L, R>::Call - ядро операции для пары типов (L, R). Таблица строится во время
+	 * компиляции, поэтому выбор ядра сводится к одному обращению к массиву
+	 */
+	template <template <ObjectType, ObjectType> class Kernel>
+	class BinaryDispatch {
+	public:
+		using Fn = decltype(&Kernel<ObjectType::None, ObjectType::None>::Call);
+
+		[[nodiscard]] static Fn Get(ObjectType lhs, ObjectType rhs) {
+			return TABLE[static_cast<size_t>(lhs)][static_cast<size_t>(rhs)];
+		}
+
+	private:
+		using Row = std::array<Fn, OBJECT_TYPE_COUNT>;
+
+		template <size_t L, size_t... R>
+		static constexpr Row MakeRow(std::index_sequence<R...>) {
+			return { &Kernel<static_cast<ObjectType>(L), static_cast<ObjectType>(R)>::Call... };
+		}
+
+		template <size_t... L>
+		static constexpr std::array<Row, OBJECT_TYPE_COUNT> MakeTable(std::index_sequence<L...>) {
+			return { MakeRow<L>(std::make_index_sequence<OBJECT_TYPE_COUNT>{})... };
+		}
+
+		static constexpr std::array<Row, OBJECT_TYPE_COUNT> TABLE
+			= MakeTable(std::make_index_sequence<OBJECT_TYPE_COUNT>{});
+	};
+
 	// Контекст-заглушка, применяется в тестах.
 	// В этом контексте весь вывод перенаправляется в строковый поток вывода output
 	struct DummyContext : Context {
@@ -0,0 +1,412 @@
+#include "gc.h"
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace {
+	// Число выделений памяти оператором new с начала работы программы
+	size_t allocation_count = 0;
+}  // namespace
+
+void* operator new(size_t size) {
+	++allocation_count;
+	if (void* ptr = malloc(size == 0u ? 1u : size)) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/) noexcept {
+	free(ptr);
+}
+
+void* operator new(size_t size, align_val_t alignment) {
+	++allocation_count;
+	const size_t align = static_cast<size_t>(alignment);
+	if (void* ptr = aligned_alloc(align, (size + align - 1u) / align * align)) {
+		return ptr;
+	}
+	throw bad_alloc();
+}
+
+void operator delete(void* ptr, align_val_t /*alignment*/) noexcept {
+	free(ptr);
+}
+
+void operator delete(void* ptr, size_t /*size*/, align_val_t /*alignment*/) noexcept {
+	free(ptr);
+}
+
+namespace {
+
+	using runtime::ObjectHolder;
+
+	// Приёмник результатов, не позволяющий компилятору выбросить измеряемый код
+	volatile size_t sink = 0;
+
+	// Выполняет fn один раз и выводит среднее время и среднее число выделений памяти для одной
+	// из operations операций, выполненных fn
+	void MeasureOnce(const string& name, size_t operations, const function<void()>& fn) {
+		const size_t allocations_before = allocation_count;
+		const auto start = chrono::steady_clock::now();
+		fn();
+		const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+		const size_t allocations = allocation_count - allocations_before;
+		cout << left << setw(40) << name << right << setw(10) << fixed << setprecision(2)
+			<< elapsed.count() / static_cast<double>(operations) << " ns/op"s
+			<< setw(10) << static_cast<double>(allocations) / static_cast<double>(operations) << " allocs/op"s << endl;
+	}
+
+	// Выполняет fn iterations раз после разогрева и выводит среднее время одной операции и
+	// среднее число выделений памяти в ней
+	void Measure(const string& name, size_t iterations, const function<void()>& fn) {
+		for (size_t i = 0u; i < iterations / 10u; ++i) {
+			fn();
+		}
+		MeasureOnce(name, iterations, [&] {
+			for (size_t i = 0u; i < iterations; ++i) {
+				fn();
+			}
+		});
+	}
+
+	// Наибольшее число полей экземпляра в сравнении словарей: каждое новое поле создаёт форму
+	// с копией таблицы полей, поэтому время и память растут квадратично
+	constexpr size_t MAX_FIELDS = 1'000u;
+
+	/*
+	Добавление и поиск size строковых ключей в runtime::Dict, в таблице символов Closure и в полях
+	экземпляра класса, которыми до появления словарей моделировались данные ключ-значение
+	*/
+	void BenchDictionaries(size_t max_size) {
+		const ObjectHolder value = ObjectHolder::Own(runtime::Number(1));
+		for (size_t size = 1'000u; size <= max_size; size *= 10u) {
+			vector<ObjectHolder> keys;
+			keys.reserve(size);
+			for (size_t i = 0u; i < size; ++i) {
+				keys.push_back(ObjectHolder::Own(runtime::String("k"s + to_string(i))));
+			}
+			auto key_string = [&keys](size_t i) -> const string& {
+				return keys[i].TryAs<runtime::String>()->GetValue();
+			};
+			const string suffix = " x "s + to_string(size);
+
+			{
+				runtime::Dict dict;
+				MeasureOnce("Dict insert"s + suffix, size, [&] {
+					for (const ObjectHolder& key : keys) {
+						dict.Set(key, value);
+					}
+				});
+				MeasureOnce("Dict lookup"s + suffix, size, [&] {
+					for (const ObjectHolder& key : keys) {
+						sink = sink + (dict.Find(key) != nullptr);
+					}
+				});
+			}
+			{
+				runtime::Closure closure;
+				MeasureOnce("Closure insert"s + suffix, size, [&] {
+					for (size_t i = 0u; i < size; ++i) {
+						closure[key_string(i)] = value;
+					}
+				});
+				MeasureOnce("Closure lookup"s + suffix, size, [&] {
+					for (size_t i = 0u; i < size; ++i) {
+						sink = sink + (closure.find(key_string(i)) != closure.end());
+					}
+				});
+			}
+			if (size <= MAX_FIELDS) {
+				runtime::Class cls{ "Fields"s, {}, nullptr };
+				runtime::ClassInstance instance{ cls };
+				MeasureOnce("Fields insert"s + suffix, size, [&] {
+					for (size_t i = 0u; i < size; ++i) {
+						instance.Fields()[key_string(i)] = value;
+					}
+				});
+				MeasureOnce("Fields lookup"s + suffix, size, [&] {
+					for (size_t i = 0u; i < size; ++i) {
+						sink = sink + (instance.Fields().find(key_string(i)) != instance.Fields().end());
+					}
+				});
+			}
+		}
+	}
+
+	// Стоимость операций runtime::Equal, runtime::Less и ast::Add для разных пар типов
+	void BenchBinaryOperations(size_t iterations) {
+		runtime::DummyContext context;
+
+		const ObjectHolder num1 = ObjectHolder::Own(runtime::Number(1));
+		const ObjectHolder num2 = ObjectHolder::Own(runtime::Number(2));
+		const ObjectHolder str1 = ObjectHolder::Own(runtime::String("hello"s));
+		const ObjectHolder str2 = ObjectHolder::Own(runtime::String("world"s));
+		const ObjectHolder bool1 = ObjectHolder::Own(runtime::Bool(false));
+		const ObjectHolder bool2 = ObjectHolder::Own(runtime::Bool(true));
+
+		const pair<string, pair<ObjectHolder, ObjectHolder>> operands[] = {
+			{ "number, number"s, { num1, num2 } },
+			{ "string, string"s, { str1, str2 } },
+			{ "bool, bool"s, { bool1, bool2 } },
+			{ "None, None"s, { ObjectHolder::None(), ObjectHolder::None() } },
+		};
+
+		for (const auto& [types, args] : operands) {
+			const auto& [lhs, rhs] = args;
+			Measure("Equal("s + types + ")"s, iterations, [&] {
+				sink = sink + runtime::Equal(lhs, rhs, context);
+			});
+		}
+		for (const auto& [types, args] : operands) {
+			const auto& [lhs, rhs] = args;
+			if (!lhs) {
+				continue;
+			}
+			Measure("Less("s + types + ")"s, iterations, [&] {
+				sink = sink + runtime::Less(lhs, rhs, context);
+			});
+		}
+
+		runtime::Closure closure;
+		ast::Add add_numbers(make_unique<ast::NumericConst>(1), make_unique<ast::NumericConst>(2));
+		Measure("Add(number, number)"s, iterations, [&] {
+			sink = sink + (add_numbers.Execute(closure, context).Get() != nullptr);
+		});
+		ast::Add add_strings(make_unique<ast::StringConst>("hello"s), make_unique<ast::StringConst>("world"s));
+		Measure("Add(string, string)"s, iterations, [&] {
+			sink = sink + (add_strings.Execute(closure, context).Get() != nullptr);
+		});
+	}
+
+	const string CALLS_PROGRAM = R"(
+class Calls:
+  def none():
+    return None
+
+  def one(a):
+    return a
+
+  def eight(a, b, c, d, e, f, g, h):
+    x = h
+    return x
+
+  def nine(a, b, c, d, e, f, g, h, i):
+    return i
+
+  def count(n):
+    if n > 0:
+      return self.count(n - 1)
+    return n
+
+calls = Calls()
+v = 1
+)"s;
+
+	// Стоимость вызова метода Mython в зависимости от числа аргументов
+	void BenchMethodCalls(size_t iterations) {
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		auto parse_program = [](const string& program) {
+			istringstream input(program);
+			parse::Lexer lexer(input);
+			return ParseProgram(lexer);
+		};
+		// Объекты, созданные программой, принадлежат узлам её дерева
+		const auto program = parse_program(CALLS_PROGRAM);
+		program->Execute(closure, context);
+
+		const pair<string, string> calls[] = {
+			{ "call, 0 args"s, "calls.none()"s },
+			{ "call, 1 arg"s, "calls.one(v)"s },
+			{ "call, 8 args + local"s, "calls.eight(v, v, v, v, v, v, v, v)"s },
+			{ "call, 9 args"s, "calls.nine(v, v, v, v, v, v, v, v, v)"s },
+			{ "tail call"s, "calls.count(0)"s },
+		};
+		for (const auto& [name, call] : calls) {
+			const auto statement = parse_program(call + "\n"s);
+			Measure(name, iterations, [&] {
+				statement->Execute(closure, context);
+			});
+		}
+	}
+
+	// Создание короткоживущих экземпляров: каждый экземпляр освобождается при создании следующего
+	void BenchInstances(size_t iterations) {
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		istringstream input("class Point:\n  def __init__(x, y):\n    self.x = x\n    self.y = y\n\nv = 1\np = Point(v, v)\n"s);
+		parse::Lexer lexer(input);
+		const auto program = ParseProgram(lexer);
+		program->Execute(closure, context);
+		const auto& point = *closure.at("Point"s).TryAs<runtime::Class>();
+
+		ObjectHolder instance;
+		Measure("new instance, pool"s, iterations, [&] {
+			instance = point.CreateInstance();
+		});
+		Measure("new instance, heap"s, iterations, [&] {
+			instance = ObjectHolder::Own(runtime::ClassInstance(point));
+		});
+		instance = ObjectHolder::None();
+
+		ast::Statement& statement = *static_cast<ast::Compound&>(*program).GetStatements().back();
+		Measure("p = Point(v, v)"s, iterations, [&] {
+			statement.Execute(closure, context);
+		});
+	}
+
+	const string GEOMETRY_PROGRAM = R"(
+class Vector:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+class Geometry:
+  def classify(x, y):
+    v = Vector(x, y)
+    d = v.x * v.x + v.y * v.y
+    s = str(d)
+    if d > 100 and len(s) > 2:
+      return 1
+    return 0
+
+g = Geometry()
+v = 3
+)"s;
+
+	// Метод с временными объектами, не покидающими кадр: в памяти кадра и в куче
+	void BenchFrameAllocation(size_t iterations) {
+		runtime::DummyContext context;
+		runtime::Closure closure;
+		istringstream input(GEOMETRY_PROGRAM + "g.classify(v, v)\n"s);
+		parse::Lexer lexer(input);
+		const auto program = ParseProgram(lexer);
+		program->Execute(closure, context);
+
+		ast::Statement& statement = *static_cast<ast::Compound&>(*program).GetStatements().back();
+		for (const bool enabled : { true, false }) {
+			context.SetFrameAllocation(enabled);
+			Measure(enabled ? "temporaries, frame"s : "temporaries, heap"s, iterations, [&] {
+				statement.Execute(closure, context);
+			});
+		}
+
+		// Промежуточные значения инструкции верхнего уровня: все, кроме результата
+		istringstream top_level_input("r = v * v + v * v - v * 2\n"s);
+		parse::Lexer top_level_lexer(top_level_input);
+		const auto top_level = ParseProgram(top_level_lexer);
+		for (const bool enabled : { true, false }) {
+			context.SetFrameAllocation(enabled);
+			Measure(enabled ? "statement temporaries, region"s : "statement temporaries, heap"s, iterations, [&] {
+				top_level->Execute(closure, context);
+			});
+		}
+	}
+
+	const string CYCLES_PROGRAM = R"(
+class Pair:
+  def __init__():
+    self.other = None
+
+class Maker:
+  def make():
+    a = Pair()
+    b = Pair()
+    a.other = b
+    b.other = a
+    return a
+
+m = Maker()
+m.make()
+)"s;
+
+	// Создание циклов из двух экземпляров: только подсчёт ссылок (циклы не освобождаются)
+	// и сборщик циклов. После замера выводятся число живых экземпляров и паузы сборщика
+	void BenchCycles(size_t iterations) {
+		for (const bool tracing : { false, true }) {
+			runtime::DummyContext context;
+			gc::Collector collector;
+			if (tracing) {
+				context.SetObjectTracker(&collector);
+			}
+			runtime::Closure closure;
+			istringstream input(CYCLES_PROGRAM);
+			parse::Lexer lexer(input);
+			const auto program = ParseProgram(lexer);
+			program->Execute(closure, context);
+			const auto& pair = *closure.at("Pair"s).TryAs<runtime::Class>();
+
+			ast::Statement& statement = *static_cast<ast::Compound&>(*program).GetStatements().back();
+			Measure(tracing ? "pair cycle, tracing"s : "pair cycle, refcount"s, iterations, [&] {
+				statement.Execute(closure, context);
+			});
+			const gc::Collector::Stats& stats = collector.GetStats();
+			cout << "  live instances "s << pair.GetInstancePool().GetLiveCount() << ", pool "s
+				<< pair.GetInstancePool().GetReservedBytes() / 1024u << " KiB, max pause "s
+				<< chrono::duration<double, micro>(stats.max_pause).count() << " us"s << endl;
+		}
+	}
+
+	// Создание значений ObjectHolder::Own: в пуле объектов потока и в куче. Пакетом
+	// создаются BATCH значений, которые затем освобождаются вместе
+	void BenchObjectPool(size_t iterations) {
+		constexpr size_t BATCH = 1'000u;
+		runtime::ObjectPool& pool = runtime::ObjectPool::ForThread();
+		vector<ObjectHolder> batch;
+		batch.reserve(BATCH);
+		for (const bool enabled : { true, false }) {
+			pool.SetEnabled(enabled);
+			const string suffix = enabled ? ", pool"s : ", heap"s;
+			Measure("Own(Number)"s + suffix, iterations, [] {
+				sink = sink + ObjectHolder::Own(runtime::Number(1)).TryAs<runtime::Number>()->GetValue();
+			});
+			Measure("Own(String)"s + suffix, iterations, [] {
+				sink = sink + ObjectHolder::Own(runtime::String("text"s)).TryAs<runtime::String>()->GetValue().size();
+			});
+			MeasureOnce("batch of Own(Number)"s + suffix, iterations, [&] {
+				for (size_t i = 0u; i < iterations; i += BATCH) {
+					for (size_t j = 0u; j < BATCH; ++j) {
+						batch.push_back(ObjectHolder::Own(runtime::Number(static_cast<int>(j))));
+					}
+					batch.clear();
+				}
+			});
+		}
+		pool.SetEnabled(true);
+		pool.Dump(cout);
+	}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+	const size_t iterations = argc > 1 ? stoul(argv[1]) : 10'000'000u;
+	const size_t max_dict_size = argc > 2 ? stoul(argv[2]) : 10'000'000u;
+	BenchBinaryOperations(iterations);
+	BenchMethodCalls(iterations);
+	BenchInstances(iterations);
+	BenchFrameAllocation(iterations);
+	BenchObjectPool(iterations);
+	// Без сборщика циклы не освобождаются, поэтому число повторений меньше
+	BenchCycles(iterations / 10u);
+	BenchDictionaries(max_dict_size);
+	return 0;
+}
@@ -1,7 +1,9 @@
 #include "runtime.h"
 #include "test_runner_p.h"
 
+#include <algorithm>
 #include <functional>
+#include <thread>
 
 using namespace std;
 
@@ -242,12 +244,205 @@ namespace runtime {
 			}
 		}
 
+		void TestRefCounting() {
+			static_assert(sizeof(ObjectHolder) == sizeof(Object*));
+			{
+				ObjectHolder one = ObjectHolder::Own(Logger(5));
+				Object& object = *one;
+				ASSERT(object.GetStorage() == Storage::Shared);
+				ASSERT_EQUAL(object.GetRefCount(), 1u);
+
+				ObjectHolder two = one;
+				ASSERT_EQUAL(object.GetRefCount(), 2u);
+				// Share объекта, принадлежащего ObjectHolder, владеет им
+				ObjectHolder shared = ObjectHolder::Share(object);
+				ASSERT_EQUAL(object.GetRefCount(), 3u);
+				one = ObjectHolder::None();
+				two = std::move(shared);
+				ASSERT_EQUAL(object.GetRefCount(), 1u);
+				ASSERT_EQUAL(Logger::instance_count, 1);
+
+				// Присваивание себе не освобождает объект
+				ObjectHolder& alias = two;
+				two = alias;
+				ASSERT_EQUAL(object.GetRefCount(), 1u);
+
+				object.SetRefCountPolicy(RefCountPolicy::Atomic);
+				one = two;
+				ASSERT_EQUAL(object.GetRefCount(), 2u);
+				one = ObjectHolder::None();
+				two = ObjectHolder::None();
+				ASSERT_EQUAL(Logger::instance_count, 0);
+			}
+			{
+				Logger logger(7);
+				ASSERT(logger.GetStorage() == Storage::Unmanaged);
+				ObjectHolder holder = ObjectHolder::Share(logger);
+				holder = ObjectHolder::None();
+				ASSERT_EQUAL(logger.GetRefCount(), Object::UNMANAGED_REF_COUNT);
+
+				// Копия получает собственный счётчик
+				ObjectHolder copy = ObjectHolder::Own(Logger(logger));
+				ASSERT_EQUAL(copy->GetRefCount(), 1u);
+				ASSERT_EQUAL(Logger::instance_count, 2);
+			}
+			ASSERT_EQUAL(Logger::instance_count, 0);
+		}
+
+		size_t GetAllocations(const ObjectPool& pool, size_t block_size) {
+			for (const ObjectPool::SizeClassStats& stats : pool.GetStats()) {
+				if (stats.block_size == block_size) {
+					return stats.allocations;
+				}
+			}
+			return 0u;
+		}
+
+		void TestObjectPool() {
+			ObjectPool& pool = ObjectPool::ForThread();
+			ASSERT(pool.IsEnabled());
+			constexpr size_t NUMBER_BLOCK = (sizeof(Number) + ObjectPool::SIZE_STEP - 1u) / ObjectPool::SIZE_STEP * ObjectPool::SIZE_STEP;
+			const size_t allocations = GetAllocations(pool, NUMBER_BLOCK);
+			{
+				ObjectHolder number = ObjectHolder::Own(Number{ 1 });
+				ASSERT(number->GetStorage() == Storage::Shared);
+				const Object* block = number.Get();
+				number = ObjectHolder::None();
+				// Освобождённый блок выдаётся первым
+				number = ObjectHolder::Own(Number{ 2 });
+				ASSERT(number.Get() == block);
+				ASSERT_EQUAL(number.TryAs<Number>()->GetValue(), 2);
+			}
+			ASSERT_EQUAL(GetAllocations(pool, NUMBER_BLOCK), allocations + 2u);
+
+			// Объект, освобождённый другим потоком, возвращается в пул создавшего его потока
+			ObjectHolder text = ObjectHolder::Own(String{ "shared"s });
+			const Object* block = text.Get();
+			std::thread([moved = std::move(text)]() mutable {
+				moved = ObjectHolder::None();
+			}).join();
+			ASSERT_EQUAL(pool.CollectRemoteFrees(), 1u);
+			ObjectHolder reused = ObjectHolder::Own(String{ "again"s });
+			ASSERT(reused.Get() == block);
+
+			// Выключенный пул не используется
+			pool.SetEnabled(false);
+			ObjectHolder heap = ObjectHolder::Own(Bool{ true });
+			pool.SetEnabled(true);
+			ASSERT(heap->GetStorage() == Storage::Heap);
+
+			std::ostringstream out;
+			pool.Dump(out);
+			ASSERT(out.str().find("Object pool:\n"s) != std::string::npos);
+		}
+
+		void TestObjectPoolSlabs() {
+			ObjectPool pool;
+			pool.SetHugePages(true);
+			std::vector<void*> blocks;
+			const size_t per_slab = ObjectPool::SLAB_SIZE / 32u;
+			for (size_t i = 0u; i < per_slab; ++i) {
+				blocks.push_back(pool.Allocate(32u));
+			}
+			// Вторая страница нарезана из того же участка памяти
+			ASSERT_EQUAL(pool.GetReservedBytes(), ObjectPool::HUGE_PAGE_SIZE);
+			for (void* block : blocks) {
+				ObjectPool::Deallocate(block, 32u);
+			}
+			ASSERT_EQUAL(pool.CollectRemoteFrees(), per_slab);
+
+			const std::vector<ObjectPool::SizeClassStats> stats = pool.GetStats();
+			ASSERT_EQUAL(stats.size(), 1u);
+			ASSERT_EQUAL(stats[0].block_size, 32u);
+			ASSERT_EQUAL(stats[0].allocations, per_slab);
+			ASSERT_EQUAL(stats[0].live, 0u);
+			ASSERT_EQUAL(stats[0].remote_frees, per_slab);
+			ASSERT(stats[0].capacity > per_slab);
+			void* block = pool.Allocate(32u);
+			ASSERT(std::find(blocks.begin(), blocks.end(), block) != blocks.end());
+			ASSERT_EQUAL(pool.GetStats()[0].reused, 1u);
+			ObjectPool::Deallocate(block, 32u);
+		}
+
+		void TestMemoryAccount() {
+			ASSERT(MemoryAccount::GetActive() == nullptr);
+			const std::string long_text(1000u, 'a');
+			MemoryAccount account;
+			size_t soft_limit_calls = 0u;
+			{
+				MemoryAccount::Scope scope(account);
+				ASSERT(MemoryAccount::GetActive() == &account);
+				ObjectHolder number = ObjectHolder::Own(Number{ 1 });
+				ASSERT_EQUAL(account.GetUsage(), sizeof(Number));
+				// Буфер длинной строки записывается на счёт вместе с объектом
+				ObjectHolder text = ObjectHolder::Own(String{ long_text });
+				ASSERT(account.GetUsage() > sizeof(Number) + sizeof(String) + long_text.size());
+
+				// Рост списка записывается на счёт списка
+				ObjectHolder list = ObjectHolder::Own(List{});
+				const size_t before_append = account.GetUsage();
+				for (int i = 0; i < 100; ++i) {
+					list.TryAs<List>()->Append(number);
+				}
+				ASSERT(account.GetUsage() >= before_append + 100u * sizeof(ObjectHolder));
+
+				account.SetSoftLimit(account.GetUsage() + 100u, [&](const MemoryAccount& reached) {
+					ASSERT(&reached == &account);
+					++soft_limit_calls;
+				});
+				ObjectHolder first = ObjectHolder::Own(String{ long_text });
+				ObjectHolder second = ObjectHolder::Own(String{ long_text });
+				ASSERT_EQUAL(soft_limit_calls, 1u);
+
+				// Объект сверх жёсткого предела не создаётся и не остаётся на счёте
+				account.SetHardLimit(account.GetUsage() + 500u);
+				const size_t usage = account.GetUsage();
+				ASSERT_THROWS((void)ObjectHolder::Own(String{ long_text }), std::runtime_error);
+				ASSERT_EQUAL(account.GetUsage(), usage);
+				ASSERT(account.GetPeak() <= account.GetHardLimit());
+				account.SetHardLimit(MemoryAccount::NO_LIMIT);
+			}
+			ASSERT(MemoryAccount::GetActive() == nullptr);
+			ASSERT_EQUAL(account.GetUsage(), 0u);
+			ASSERT(account.GetPeak() > 3u * long_text.size());
+
+			// Объект, переживший свой счёт, возвращает память на уничтоженный счёт
+			ObjectHolder survivor;
+			{
+				MemoryAccount temporary;
+				MemoryAccount::Scope scope(temporary);
+				survivor = ObjectHolder::Own(Number{ 2 });
+				ASSERT_EQUAL(temporary.GetUsage(), sizeof(Number));
+			}
+			survivor = ObjectHolder::None();
+		}
+
 		void TestNullptr() {
 			ObjectHolder oh;
 			ASSERT(!oh);
 			ASSERT(!oh.Get());
 		}
 
+		void TestTypeTags() {
+			ASSERT(ObjectHolder::None().GetType() == ObjectType::None);
+			ASSERT(ObjectHolder::Own(Number{ 1 }).GetType() == ObjectType::Number);
+			ASSERT(ObjectHolder::Own(String{ "1"s }).GetType() == ObjectType::String);
+			ASSERT(ObjectHolder::Own(Bool{ true }).GetType() == ObjectType::Bool);
+
+			Class cls{ "Test"s, {}, nullptr };
+			ASSERT(ObjectHolder::Share(cls).GetType() == ObjectType::Class);
+			ASSERT(ObjectHolder::Own(ClassInstance{ cls }).GetType() == ObjectType::ClassInstance);
+
+			// Объекты без собственного тега проверяются через dynamic_cast
+			Logger logger(1);
+			const auto oh = ObjectHolder::Share(logger);
+			ASSERT(oh.GetType() == ObjectType::Other);
+			ASSERT(oh.TryAs<Logger>() == &logger);
+			ASSERT(oh.TryAs<Number>() == nullptr);
+			ASSERT(ObjectHolder::Own(Number{ 1 }).TryAs<Logger>() == nullptr);
+			ASSERT(ObjectHolder::Own(Bool{ true }).TryAs<ValueObject<bool>>() != nullptr);
+		}
+
 		void TestIsTrue() {
 			{
 				ASSERT(!IsTrue(ObjectHolder::Own(Bool{ false })));
@@ -474,6 +669,62 @@ namespace runtime {
 			}
 		}
 
+		void TestThreeWayComparison() {
+			DummyContext ctx;
+
+			// __cmp__ отвечает на любую операцию сравнения одним вызовом
+			int cmp_calls = 0;
+			int cmp_result = 0;
+			auto cmp_body = [&cmp_calls, &cmp_result](Closure& /*closure*/, Context& /*ctx*/) {
+				++cmp_calls;
+				return ObjectHolder::Own(Number{ cmp_result });
+			};
+			vector<Method> cmp_methods;
+			cmp_methods.push_back({ "__cmp__"s, {"rhs"s}, make_unique<TestMethodBody>(cmp_body) });
+			Class cmp_cls{ "Cmp"s, std::move(cmp_methods), nullptr };
+			ClassInstance cmp_inst{ cmp_cls };
+			const auto lhs = ObjectHolder::Share(cmp_inst);
+			const auto rhs = ObjectHolder::Own(Number{ 0 });
+
+			const pair<int, vector<bool>> expected[] = {
+				// ==, !=, <, >, <=, >=
+				{ -1, { false, true, true, false, true, false } },
+				{ 0, { true, false, false, false, true, true } },
+				{ 5, { false, true, false, true, false, true } },
+			};
+			const CompareOp ops[] = { CompareOp::Equal, CompareOp::NotEqual, CompareOp::Less,
+				CompareOp::Greater, CompareOp::LessOrEqual, CompareOp::GreaterOrEqual };
+			for (const auto& [result, values] : expected) {
+				cmp_result = result;
+				for (size_t i = 0; i < values.size(); ++i) {
+					cmp_calls = 0;
+					ASSERT_EQUAL(Compare(ops[i], lhs, rhs, ctx), values[i]);
+					ASSERT_EQUAL(cmp_calls, 1);
+				}
+			}
+
+			// Для объектов одного класса > и <= вычисляются одним вызовом rhs.__lt__(lhs)
+			int lt_calls = 0;
+			Closure lt_closure;
+			auto lt_body = [&lt_calls, &lt_closure](Closure& closure, Context& /*ctx*/) {
+				++lt_calls;
+				lt_closure = closure;
+				return ObjectHolder::Own(Bool{ true });
+			};
+			vector<Method> lt_methods;
+			lt_methods.push_back({ "__lt__"s, {"rhs"s}, make_unique<TestMethodBody>(lt_body) });
+			Class lt_cls{ "Lt"s, std::move(lt_methods), nullptr };
+			ClassInstance first{ lt_cls };
+			ClassInstance second{ lt_cls };
+
+			ASSERT(Greater(ObjectHolder::Share(first), ObjectHolder::Share(second), ctx));
+			ASSERT_EQUAL(lt_calls, 1);
+			ASSERT(lt_closure.at("self"s).Get() == &second);
+			ASSERT(lt_closure.at("rhs"s).Get() == &first);
+			ASSERT(!LessOrEqual(ObjectHolder::Share(first), ObjectHolder::Share(second), ctx));
+			ASSERT_EQUAL(lt_calls, 2);
+		}
+
 		void TestClass() {
 			vector<Method> methods;
 			Closure* passed_closure = nullptr;
@@ -529,6 +780,307 @@ namespace runtime {
 			ASSERT_THROWS(instance.Call("missing_method"s, {}, ctx), runtime_error);
 		}
 
+		void TestInstanceShapes() {
+			Class cls{ "Point"s, {}, nullptr };
+			ClassInstance first{ cls };
+			ClassInstance second{ cls };
+			ASSERT_EQUAL(first.Fields().GetShape(), &cls.GetRootShape());
+
+			first.Fields()["x"s] = ObjectHolder::Own(Number{ 1 });
+			first.Fields()["y"s] = ObjectHolder::Own(Number{ 2 });
+			second.Fields()["x"s] = ObjectHolder::Own(Number{ 3 });
+			ASSERT(first.Fields().GetShape() != second.Fields().GetShape());
+			second.Fields()["y"s] = ObjectHolder::Own(Number{ 4 });
+			ASSERT_EQUAL(first.Fields().GetShape(), second.Fields().GetShape());
+			ASSERT_EQUAL(cls.GetRootShape().GetExpectedFieldCount(), 2U);
+
+			// Повторная запись в существующее поле не меняет форму
+			const Shape* shape = first.Fields().GetShape();
+			first.Fields()["x"s] = ObjectHolder::Own(Number{ 5 });
+			ASSERT_EQUAL(first.Fields().GetShape(), shape);
+			ASSERT_EQUAL(first.Fields().size(), 2U);
+			ASSERT_EQUAL(first.Fields().at("x"s).TryAs<Number>()->GetValue(), 5);
+			ASSERT_THROWS(first.Fields().at("z"s), out_of_range);
+
+			// Другой порядок добавления полей даёт другую форму
+			ClassInstance third{ cls };
+			third.Fields()["y"s] = ObjectHolder::Own(Number{ 6 });
+			third.Fields()["x"s] = ObjectHolder::Own(Number{ 7 });
+			ASSERT(third.Fields().GetShape() != first.Fields().GetShape());
+
+			vector<string> names;
+			for (const auto& [name, value] : third.Fields()) {
+				ASSERT(value);
+				names.push_back(name);
+			}
+			ASSERT_EQUAL(names, (vector<string>{ "y"s, "x"s }));
+		}
+
+		void TestMethodTable() {
+			vector<Method> base_methods;
+			base_methods.push_back({ "__str__"s, {}, make_unique<TestMethodBody>(nullptr) });
+			base_methods.push_back({ "__eq__"s, {"rhs"s}, make_unique<TestMethodBody>(nullptr) });
+			base_methods.push_back({ "value"s, {}, make_unique<TestMethodBody>(nullptr) });
+			Class base{ "Base"s, std::move(base_methods), nullptr };
+
+			vector<Method> child_methods;
+			child_methods.push_back({ "__eq__"s, {"rhs"s}, make_unique<TestMethodBody>(nullptr) });
+			child_methods.push_back({ "__init__"s, {"x"s}, make_unique<TestMethodBody>(nullptr) });
+			Class child{ "Child"s, std::move(child_methods), &base };
+
+			ASSERT_EQUAL(child.GetMethod(SpecialMethod::Str), base.GetMethod(SpecialMethod::Str));
+			ASSERT_EQUAL(child.GetMethod(SpecialMethod::Str), child.GetMethod("__str__"s));
+			ASSERT(child.GetMethod(SpecialMethod::Eq) != base.GetMethod(SpecialMethod::Eq));
+			ASSERT_EQUAL(child.GetMethod(SpecialMethod::Eq), child.GetMethod("__eq__"s));
+			ASSERT_EQUAL(child.GetMethod(SpecialMethod::Init)->formal_params.size(), 1U);
+			ASSERT_EQUAL(base.GetMethod(SpecialMethod::Init), nullptr);
+			ASSERT_EQUAL(child.GetMethod(SpecialMethod::Lt), nullptr);
+			ASSERT_EQUAL(child.GetMethod("value"s), base.GetMethod("value"s));
+
+			ClassInstance instance{ child };
+			ASSERT(instance.FindMethod(SpecialMethod::Init, 1u) != nullptr);
+			ASSERT_EQUAL(instance.FindMethod(SpecialMethod::Init, 0u), nullptr);
+		}
+
+		void TestList() {
+			DummyContext context;
+			ObjectHolder list = ObjectHolder::Own(List{});
+			ASSERT(list.GetType() == ObjectType::List);
+			ASSERT(!IsTrue(list));
+
+			auto* items = list.TryAs<List>();
+			ASSERT(items != nullptr);
+			ASSERT(List::HasMethod("append"s, 1u));
+			ASSERT(!List::HasMethod("append"s, 2u));
+			items->Append(ObjectHolder::Own(Number{ 1 }));
+			items->Call("append"s, { ObjectHolder::Own(String{ "a"s }) });
+			items->Append(ObjectHolder::None());
+			ASSERT(IsTrue(list));
+			ASSERT_EQUAL(items->Size(), 3u);
+			ASSERT_EQUAL(items->At(-3).TryAs<Number>()->GetValue(), 1);
+			ASSERT_THROWS(static_cast<void>(items->At(3)), runtime_error);
+			ASSERT_THROWS(static_cast<void>(items->At(-4)), runtime_error);
+			ASSERT_THROWS(items->Call("pop"s, {}), runtime_error);
+
+			ostringstream out;
+			list->Print(out, context);
+			ASSERT_EQUAL(out.str(), "[1, 'a', None]"s);
+
+			// Список, содержащий сам себя
+			items->Append(list);
+			out.str({});
+			list->Print(out, context);
+			ASSERT_EQUAL(out.str(), "[1, 'a', None, [...]]"s);
+
+			const ObjectHolder same = ObjectHolder::Own(List{ { ObjectHolder::Own(Number{ 1 }), ObjectHolder::Own(String{ "a"s }) } });
+			const ObjectHolder other = ObjectHolder::Own(List{ { ObjectHolder::Own(Number{ 1 }), ObjectHolder::Own(String{ "b"s }) } });
+			ObjectHolder copy = ObjectHolder::Own(List{ same.TryAs<List>()->GetItems() });
+			ASSERT(Equal(same, copy, context));
+			ASSERT(NotEqual(same, other, context));
+			ASSERT(Equal(list, list, context));
+			ASSERT(NotEqual(same, list, context));
+			ASSERT_THROWS(Less(same, copy, context), runtime_error);
+			ASSERT_THROWS(Equal(same, ObjectHolder::Own(Number{ 1 }), context), runtime_error);
+		}
+
+		void TestDict() {
+			DummyContext context;
+			ObjectHolder holder = ObjectHolder::Own(Dict{});
+			ASSERT(holder.GetType() == ObjectType::Dict);
+			ASSERT(!IsTrue(holder));
+			auto& dict = *holder.TryAs<Dict>();
+
+			const ObjectHolder one = ObjectHolder::Own(Number{ 1 });
+			const ObjectHolder yes = ObjectHolder::Own(Bool{ true });
+			const ObjectHolder name = ObjectHolder::Own(String{ "name"s });
+			ASSERT(dict.Find(one) == nullptr);
+			dict.Set(name, ObjectHolder::Own(String{ "Ann"s }));
+			dict.Set(one, ObjectHolder::None());
+			dict.Set(yes, one);
+			ASSERT(IsTrue(holder));
+			ASSERT_EQUAL(dict.Size(), 3u);
+			// 1 и True - разные ключи, равные строки - один ключ
+			ASSERT(dict.Find(one) != nullptr && !*dict.Find(one));
+			ASSERT_EQUAL(dict.Find(yes)->TryAs<Number>()->GetValue(), 1);
+			dict.Set(ObjectHolder::Own(String{ "name"s }), ObjectHolder::Own(String{ "Bob"s }));
+			ASSERT_EQUAL(dict.Size(), 3u);
+			ASSERT_THROWS(static_cast<void>(dict.Find(ObjectHolder::None())), runtime_error);
+			ASSERT_THROWS(dict.Set(holder, one), runtime_error);
+
+			ostringstream out;
+			holder->Print(out, context);
+			ASSERT_EQUAL(out.str(), "{'name': 'Bob', 1: None, True: 1}"s);
+			dict.Set(ObjectHolder::Own(Number{ 2 }), holder);
+			out.str({});
+			holder->Print(out, context);
+			ASSERT_EQUAL(out.str(), "{'name': 'Bob', 1: None, True: 1, 2: {...}}"s);
+
+			ASSERT(HasBuiltinMethod(holder, "get"s, 1u));
+			ASSERT(!HasBuiltinMethod(holder, "append"s, 1u));
+			ASSERT(!CallBuiltinMethod(holder, "get"s, { ObjectHolder::Own(Number{ 3 }) }));
+			ASSERT(CallBuiltinMethod(holder, "contains"s, { one }).TryAs<Bool>()->GetValue());
+			ASSERT_THROWS(GetItem(holder, ObjectHolder::Own(Number{ 3 })), runtime_error);
+			ASSERT_EQUAL(GetLength(holder), 4);
+
+			// Рост таблицы сохраняет ключи и порядок добавления
+			Dict numbers;
+			Dict copy;
+			for (int i = 0; i < 1000; ++i) {
+				numbers.Set(ObjectHolder::Own(Number{ i * 7 }), ObjectHolder::Own(Number{ i }));
+			}
+			for (int i = 999; i >= 0; --i) {
+				copy.Set(ObjectHolder::Own(Number{ i * 7 }), ObjectHolder::Own(Number{ i }));
+			}
+			ASSERT_EQUAL(numbers.Size(), 1000u);
+			for (int i = 0; i < 1000; ++i) {
+				ASSERT_EQUAL(numbers.GetEntries()[i].key.TryAs<Number>()->GetValue(), i * 7);
+				ASSERT_EQUAL(numbers.Find(ObjectHolder::Own(Number{ i * 7 }))->TryAs<Number>()->GetValue(), i);
+				ASSERT(numbers.Find(ObjectHolder::Own(Number{ i * 7 + 1 })) == nullptr);
+			}
+			const ObjectHolder numbers_holder = ObjectHolder::Share(numbers);
+			const ObjectHolder copy_holder = ObjectHolder::Share(copy);
+			ASSERT(Equal(numbers_holder, copy_holder, context));
+			copy.Set(ObjectHolder::Own(Number{ 0 }), ObjectHolder::Own(Number{ -1 }));
+			ASSERT(NotEqual(numbers_holder, copy_holder, context));
+			ASSERT_THROWS(Less(numbers_holder, copy_holder, context), runtime_error);
+		}
+
+		void TestInstancePool() {
+			ObjectHolder survivor;
+			{
+				Class cls{ "Point"s, {}, nullptr };
+				const InstancePool& pool = cls.GetInstancePool();
+				ObjectHolder first = cls.CreateInstance();
+				ObjectHolder second = cls.CreateInstance();
+				ASSERT(first.TryAs<ClassInstance>() != nullptr);
+				ASSERT(first.Get() != second.Get());
+				ASSERT_EQUAL(&first.TryAs<ClassInstance>()->GetClass(), &cls);
+				ASSERT_EQUAL(pool.GetLiveCount(), 2u);
+
+				// Освобождённый блок выдаётся снова
+				Object* const freed = first.Get();
+				first = ObjectHolder::None();
+				ASSERT_EQUAL(pool.GetLiveCount(), 1u);
+				ASSERT_EQUAL(cls.CreateInstance().Get(), freed);
+				ASSERT_EQUAL(pool.GetLiveCount(), 1u);
+				ASSERT(pool.GetReservedBytes() >= InstancePool::MIN_PAGE_SIZE);
+
+				// Share владеет экземпляром, если им владеет другой ObjectHolder
+				ObjectHolder shared = ObjectHolder::Share(*second.TryAs<ClassInstance>());
+				second = ObjectHolder::None();
+				ASSERT_EQUAL(pool.GetLiveCount(), 1u);
+				survivor = std::move(shared);
+			}
+			// Пул класса живёт, пока не освобождён последний экземпляр
+			survivor = ObjectHolder::None();
+		}
+
+		void TestFrameArena() {
+			ObjectHolder survivor;
+			{
+				FrameArena arena;
+				survivor = arena.Create<Number>(1);
+				ASSERT_EQUAL(arena.GetLiveCount(), 1u);
+
+				vector<ObjectHolder> numbers;
+				for (int i = 0; i < 1000; ++i) {
+					numbers.push_back(arena.Create<Number>(i));
+				}
+				ASSERT_EQUAL(arena.GetLiveCount(), 1001u);
+				ASSERT_EQUAL(numbers.back().TryAs<Number>()->GetValue(), 999);
+				ASSERT(arena.GetPageCount() > 1u);
+
+				// Опустевшие страницы используются снова. Страница с живым объектом остаётся занятой
+				size_t pages = 0;
+				for (int round = 0; round < 3; ++round) {
+					numbers.clear();
+					ASSERT_EQUAL(arena.GetLiveCount(), 1u);
+					for (int i = 0; i < 1000; ++i) {
+						numbers.push_back(arena.Create<Number>(i));
+					}
+					if (round == 0) {
+						pages = arena.GetPageCount();
+					}
+				}
+				ASSERT_EQUAL(arena.GetPageCount(), pages);
+
+				// Большие блоки берутся из кучи
+				void* block = arena.Allocate(2u * FrameArena::MAX_BLOCK_SIZE);
+				ASSERT_EQUAL(arena.GetLiveCount(), 1001u);
+				FrameArena::Deallocate(block, 2u * FrameArena::MAX_BLOCK_SIZE);
+			}
+			// Страница с живым объектом переживает арену
+			ASSERT_EQUAL(survivor.TryAs<Number>()->GetValue(), 1);
+			survivor = ObjectHolder::None();
+		}
+
+		void TestClosure() {
+			Closure closure = { { "a"s, ObjectHolder::Own(Number{ 1 }) } };
+			ObjectHolder* a = &closure["a"s];
+			ASSERT_EQUAL(closure.size(), 1u);
+			ASSERT_EQUAL(closure.erase("a"s), 1u);
+			ASSERT(closure.empty());
+			ASSERT(closure.find("a"s) == closure.end());
+			ASSERT_THROWS(closure.at("a"s), out_of_range);
+			// Удалённая переменная переиспользуется при повторном присваивании
+			ASSERT_EQUAL(&closure["a"s], a);
+			ASSERT(!closure.at("a"s));
+			ASSERT(!closure.insert({ "a"s, ObjectHolder::Own(Number{ 2 }) }).second);
+
+			// Больше LINEAR_LIMIT переменных ищутся по индексу, обход идёт в порядке добавления
+			for (int i = 0; i < 100; ++i) {
+				closure["v"s + to_string(i)] = ObjectHolder::Own(Number{ i });
+			}
+			for (int i = 0; i < 100; i += 2) {
+				closure.erase("v"s + to_string(i));
+			}
+			ASSERT_EQUAL(closure.size(), 51u);
+			ASSERT_EQUAL(closure.count("v99"s), 1u);
+			ASSERT_EQUAL(closure.count("v98"s), 0u);
+			int expected = 1;
+			for (const auto& [name, value] : closure) {
+				if (name != "a"s) {
+					ASSERT_EQUAL(name, "v"s + to_string(expected));
+					ASSERT_EQUAL(value.TryAs<Number>()->GetValue(), expected);
+					expected += 2;
+				}
+			}
+			ASSERT_EQUAL(expected, 101);
+
+			const size_t slot = closure.Declare("v98"s);
+			ASSERT_EQUAL(closure.count("v98"s), 0u);
+			closure.Bind(slot, ObjectHolder::Own(Number{ 7 }));
+			ASSERT_EQUAL(closure.at("v98"s).TryAs<Number>()->GetValue(), 7);
+			closure.clear();
+			ASSERT(closure.empty());
+			ASSERT(closure.begin() == closure.end());
+		}
+
+		void TestBuiltinRegistry() {
+			DummyContext context;
+			const BuiltinRegistry& builtins = StandardBuiltins();
+			ASSERT(builtins.Find("str"s) == nullptr);
+			const BuiltinFunction* max = builtins.Find("max"s);
+			ASSERT(max != nullptr);
+			ASSERT_EQUAL(max->arity, 2u);
+			ASSERT_EQUAL(builtins.Find("abs"s)->arity, 1u);
+
+			const vector<ObjectHolder> words = { ObjectHolder::Own(String{ "pear"s }), ObjectHolder::Own(String{ "apple"s }) };
+			ASSERT_EQUAL(max->callable(words, context).TryAs<String>()->GetValue(), "pear"s);
+			ASSERT_EQUAL(builtins.Find("min"s)->callable(words, context).Get(), words[1].Get());
+			const ObjectHolder text = ObjectHolder::Own(String{ "17"s });
+			ASSERT_EQUAL(builtins.Find("int"s)->callable(Arguments(&text, 1u), context).TryAs<Number>()->GetValue(), 17);
+
+			BuiltinRegistry registry;
+			const BuiltinFunction& answer = registry.Register("answer"s, 0u, [](Arguments /*args*/, Context& /*context*/) {
+				return ObjectHolder::Own(Number{ 42 });
+			});
+			ASSERT_EQUAL(registry.Find("answer"s), &answer);
+			ASSERT(registry.Find("max"s) == nullptr);
+			ASSERT_THROWS(registry.Register("answer"s, 1u, answer.callable), invalid_argument);
+			ASSERT_EQUAL(answer.callable(Arguments(nullptr, 0u), context).TryAs<Number>()->GetValue(), 42);
+		}
+
 	}  // namespace
 
 	void RunObjectsTests(TestRunner& tr) {
@@ -536,16 +1088,30 @@ namespace runtime {
 		RUN_TEST(tr, runtime::TestString);
 		RUN_TEST(tr, runtime::TestBool);
 		RUN_TEST(tr, runtime::TestMethodInvocation);
+		RUN_TEST(tr, runtime::TestTypeTags);
 		RUN_TEST(tr, runtime::TestIsTrue);
 		RUN_TEST(tr, runtime::TestComparison);
+		RUN_TEST(tr, runtime::TestThreeWayComparison);
 		RUN_TEST(tr, runtime::TestClass);
 		RUN_TEST(tr, runtime::TestClassInstance);
+		RUN_TEST(tr, runtime::TestInstanceShapes);
+		RUN_TEST(tr, runtime::TestMethodTable);
+		RUN_TEST(tr, runtime::TestList);
+		RUN_TEST(tr, runtime::TestDict);
+		RUN_TEST(tr, runtime::TestInstancePool);
+		RUN_TEST(tr, runtime::TestFrameArena);
+		RUN_TEST(tr, runtime::TestClosure);
+		RUN_TEST(tr, runtime::TestBuiltinRegistry);
 	}
 
 	void RunObjectHolderTests(TestRunner& tr) {
 		RUN_TEST(tr, runtime::TestNonowning);
 		RUN_TEST(tr, runtime::TestOwning);
 		RUN_TEST(tr, runtime::TestMove);
+		RUN_TEST(tr, runtime::TestRefCounting);
+		RUN_TEST(tr, runtime::TestObjectPool);
+		RUN_TEST(tr, runtime::TestObjectPoolSlabs);
+		RUN_TEST(tr, runtime::TestMemoryAccount);
 		RUN_TEST(tr, runtime::TestNullptr);
 	}
 
@@ -1,6 +1,9 @@
 #include "statement.h"
 
+#include <algorithm>
+#include <array>
 #include <iostream>
+#include <map>
 #include <sstream>
 
 using namespace std;
@@ -12,8 +15,99 @@ namespace ast {
 	using runtime::ObjectHolder;
 
 	namespace {
-		const string ADD_METHOD = "__add__"s;
-		const string INIT_METHOD = "__init__"s;
+		// Возвращает указатель на значение поля name либо nullptr, если поля нет.
+		// Смещение поля берётся из cache, если форма объекта не изменилась
+		ObjectHolder* FindField(runtime::InstanceFields& fields, const string& name, FieldCache& cache) {
+			const runtime::Shape* shape = fields.GetShape();
+			if (cache.shape != shape) {
+				const size_t slot = shape->FindSlot(name);
+				if (slot == runtime::Shape::NO_SLOT) {
+					return nullptr;
+				}
+				cache = { shape, nullptr, slot };
+			}
+			return &fields.GetSlot(cache.slot);
+		}
+
+		// Передаёт только что созданный экземпляр класса, список или словарь учёту объектов контекста
+		ObjectHolder Track(ObjectHolder object, Context& context) {
+			if (runtime::ObjectTracker* tracker = context.GetObjectTracker()) {
+				tracker->Track(*static_cast<runtime::Container*>(object.Get()));
+			}
+			return object;
+		}
+
+		// Возвращает значение объекта-значения, тип которого уже проверен по тегу
+		template <typename T>
+		const auto& ValueOf(const ObjectHolder& object) {
+			return static_cast<const T*>(object.Get())->GetValue();
+		}
+
+		// Возвращает true, если оба операнда имеют тип type
+		bool IsPair(const ObjectHolder& lhs, const ObjectHolder& rhs, runtime::ObjectType type) {
+			return lhs.GetType() == type && rhs.GetType() == type;
+		}
+
+		// Ядра операции +: сложение чисел, конкатенация строк и вызов __add__ у экземпляров классов
+		template <runtime::ObjectType L, runtime::ObjectType R>
+		struct AddKernel {
+			static ObjectHolder Call(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& /*context*/) {
+				if constexpr (L == R && L == runtime::ObjectType::Number) {
+					return ObjectHolder::Own(runtime::Number(
+						static_cast<runtime::Number*>(lhs.Get())->GetValue() + static_cast<runtime::Number*>(rhs.Get())->GetValue()));
+				}
+				else if constexpr (L == R && L == runtime::ObjectType::String) {
+					return ObjectHolder::Own(runtime::String(
+						static_cast<runtime::String*>(lhs.Get())->GetValue() + static_cast<runtime::String*>(rhs.Get())->GetValue()));
+				}
+				else {
+					throw std::runtime_error("Cannot add arguments"s);
+				}
+			}
+		};
+
+		template <runtime::ObjectType R>
+		struct AddKernel<runtime::ObjectType::ClassInstance, R> {
+			static ObjectHolder Call(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+				auto* cls_instance_ptr = static_cast<runtime::ClassInstance*>(lhs.Get());
+				if (const runtime::Method* method = cls_instance_ptr->FindMethod(runtime::SpecialMethod::Add, 1u)) {
+					return cls_instance_ptr->Call(*method, runtime::Arguments(&rhs, 1u), context);
+				}
+				throw std::runtime_error("Cannot add arguments"s);
+			}
+		};
+
+		// Значения аргументов вызова. Не больше runtime::INLINE_ARGUMENT_COUNT аргументов
+		// вычисляются в массив на стеке, поэтому вызов не выделяет память для аргументов
+		class ArgumentBuffer {
+		public:
+			ArgumentBuffer(const vector<unique_ptr<Statement>>& args, Closure& closure, Context& context)
+				: size_(args.size()) {
+				if (size_ > inline_.size()) {
+					heap_.resize(size_);
+				}
+				ObjectHolder* data = GetData();
+				for (size_t i = 0u; i < size_; ++i) {
+					data[i] = args[i]->Execute(closure, context);
+				}
+			}
+
+			ArgumentBuffer(const ArgumentBuffer&) = delete;
+			ArgumentBuffer& operator=(const ArgumentBuffer&) = delete;
+
+			operator runtime::Arguments() {  // NOLINT
+				return { GetData(), size_ };
+			}
+
+		private:
+			ObjectHolder* GetData() {
+				return size_ > inline_.size() ? heap_.data() : inline_.data();
+			}
+
+			std::array<ObjectHolder, runtime::INLINE_ARGUMENT_COUNT> inline_;
+			std::vector<ObjectHolder> heap_;
+			size_t size_;
+		};
 	}  // namespace
 
 	ObjectHolder Assignment::Execute(Closure& closure, Context& context) {
@@ -30,21 +124,27 @@ namespace ast {
 	}
 
 	VariableValue::VariableValue(std::vector<std::string> dotted_ids)
-		: dotted_ids_(std::move(dotted_ids)) {
+		: dotted_ids_(std::move(dotted_ids))
+		, field_caches_(dotted_ids_.size() - 1u) {
 	}
 
 	ObjectHolder VariableValue::Execute(Closure& closure, Context& /*context*/) {
-		Closure* closure_ptr = &closure;
-		for (size_t i = 0u; i + 1u < dotted_ids_.size(); ++i) {
-			if (!closure_ptr->count(dotted_ids_[i])) {
+		const auto var_it = closure.find(dotted_ids_.front());
+		if (var_it == closure.end()) {
+			throw std::runtime_error("Variable "s + dotted_ids_.front() + " not found"s);
+		}
+		const ObjectHolder* value = &var_it->second;
+		for (size_t i = 1u; i < dotted_ids_.size(); ++i) {
+			runtime::ClassInstance* cls_instance_ptr = value->TryAs<runtime::ClassInstance>();
+			if (!cls_instance_ptr) {
+				throw std::runtime_error("Variable "s + dotted_ids_[i - 1u] + " is not a class instance"s);
+			}
+			value = FindField(cls_instance_ptr->Fields(), dotted_ids_[i], field_caches_[i - 1u]);
+			if (!value) {
 				throw std::runtime_error("Variable "s + dotted_ids_[i] + " not found"s);
 			}
-			closure_ptr = &(*closure_ptr)[dotted_ids_[i]].TryAs<runtime::ClassInstance>()->Fields();
-		}
-		if (!closure_ptr->count(dotted_ids_.back())) {
-			throw std::runtime_error("Variable "s + dotted_ids_.back() + " not found"s);
 		}
-		return (*closure_ptr)[dotted_ids_.back()];
+		return *value;
 	}
 
 	unique_ptr<Print> Print::Variable(const std::string& name) {
@@ -87,18 +187,36 @@ namespace ast {
 		, args_(std::move(args)) {
 	}
 
+	std::pair<ObjectHolder, const runtime::Method*> MethodCall::ResolveMethod(Closure& closure, Context& context) {
+		++executions_;
+		ObjectHolder object = object_->Execute(closure, context);
+		runtime::ClassInstance* cls_instance_ptr = object.TryAs<runtime::ClassInstance>();
+		if (const runtime::Method* method = cls_instance_ptr ? cls_instance_ptr->FindMethod(method_, args_.size()) : nullptr) {
+			return { std::move(object), method };
+		}
+		if (runtime::HasBuiltinMethod(object, method_, args_.size())) {
+			return { std::move(object), nullptr };
+		}
+		throw std::runtime_error("Object is not a class instance"s);
+	}
+
 	ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
-		runtime::ClassInstance* cls_instance_ptr = object_->Execute(closure, context).TryAs<runtime::ClassInstance>();
-		if (cls_instance_ptr && cls_instance_ptr->HasMethod(method_, args_.size())) {
-			std::vector<ObjectHolder> actual_args(args_.size());
-			for (size_t i = 0u; i < args_.size(); ++i) {
-				actual_args[i] = args_[i]->Execute(closure, context);
-			}
-			return cls_instance_ptr->Call(method_, actual_args, context);
+		const auto [object, method] = ResolveMethod(closure, context);
+		ArgumentBuffer actual_args(args_, closure, context);
+		if (!method) {
+			return runtime::CallBuiltinMethod(object, method_, actual_args);
 		}
-		else {
-			throw std::runtime_error("Object is not a class instance"s);
+		return object.TryAs<runtime::ClassInstance>()->Call(*method, actual_args, context);
+	}
+
+	ObjectHolder MethodCall::ExecuteAsTailCall(Closure& closure, Context& context) {
+		auto [object, method] = ResolveMethod(closure, context);
+		ArgumentBuffer actual_args(args_, closure, context);
+		if (!method) {
+			return runtime::CallBuiltinMethod(object, method_, actual_args);
 		}
+		context.SetTailCall(std::move(object), *method, actual_args);
+		return ObjectHolder::None();
 	}
 
 	ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
@@ -110,36 +228,141 @@ namespace ast {
 		else {
 			ss << "None"s;
 		}
-		return ObjectHolder::Own(runtime::String(ss.str()));
+		return Make<runtime::String>(context, ss.str());
+	}
+
+	ObjectHolder Length::Execute(Closure& closure, Context& context) {
+		return Make<runtime::Number>(context, runtime::GetLength(arg_->Execute(closure, context)));
+	}
+
+	BuiltinCall::BuiltinCall(const runtime::BuiltinFunction& function, std::vector<std::unique_ptr<Statement>> args)
+		: function_(function)
+		, args_(std::move(args)) {
+	}
+
+	ObjectHolder BuiltinCall::Execute(Closure& closure, Context& context) {
+		ArgumentBuffer args(args_, closure, context);
+		return function_.callable(args, context);
+	}
+
+	ListLiteral::ListLiteral(std::vector<std::unique_ptr<Statement>> items)
+		: items_(std::move(items)) {
+	}
+
+	ObjectHolder ListLiteral::Execute(Closure& closure, Context& context) {
+		std::vector<ObjectHolder> items(items_.size());
+		for (size_t i = 0u; i < items_.size(); ++i) {
+			items[i] = items_[i]->Execute(closure, context);
+		}
+		return Track(ObjectHolder::Own(runtime::List(std::move(items))), context);
+	}
+
+	DictLiteral::DictLiteral(std::vector<std::pair<std::unique_ptr<Statement>, std::unique_ptr<Statement>>> items)
+		: items_(std::move(items)) {
+	}
+
+	ObjectHolder DictLiteral::Execute(Closure& closure, Context& context) {
+		runtime::Dict dict;
+		dict.Reserve(items_.size());
+		for (const auto& [key, value] : items_) {
+			const ObjectHolder key_value = key->Execute(closure, context);
+			dict.Set(key_value, value->Execute(closure, context));
+		}
+		return Track(ObjectHolder::Own(std::move(dict)), context);
+	}
+
+	Index::Index(std::unique_ptr<Statement> object, std::unique_ptr<Statement> index)
+		: object_(std::move(object))
+		, index_(std::move(index)) {
+	}
+
+	ObjectHolder Index::Execute(Closure& closure, Context& context) {
+		const ObjectHolder object = object_->Execute(closure, context);
+		return runtime::GetItem(object, index_->Execute(closure, context));
+	}
+
+	IndexAssignment::IndexAssignment(std::unique_ptr<Statement> object, std::unique_ptr<Statement> index,
+		std::unique_ptr<Statement> rv)
+		: object_(std::move(object))
+		, index_(std::move(index))
+		, rv_(std::move(rv)) {
+	}
+
+	ObjectHolder IndexAssignment::Execute(Closure& closure, Context& context) {
+		const ObjectHolder object = object_->Execute(closure, context);
+		const ObjectHolder index = index_->Execute(closure, context);
+		ObjectHolder value = rv_->Execute(closure, context);
+		runtime::SetItem(object, index, value);
+		return value;
+	}
+
+	void OperandProfile::Observe(runtime::ObjectType lhs, runtime::ObjectType rhs) {
+		if (observed_ > 0u && (lhs != lhs_ || rhs != rhs_)) {
+			state_ = State::Generic;
+			return;
+		}
+		lhs_ = lhs;
+		rhs_ = rhs;
+		if (++observed_ < WARMUP_EXECUTIONS) {
+			return;
+		}
+		if (lhs == runtime::ObjectType::Number && rhs == runtime::ObjectType::Number) {
+			state_ = State::Numbers;
+		}
+		else if (lhs == runtime::ObjectType::String && rhs == runtime::ObjectType::String) {
+			state_ = State::Strings;
+		}
+		else {
+			state_ = State::Generic;
+		}
 	}
 
 	ObjectHolder Add::Execute(Closure& closure, Context& context) {
 		ObjectHolder lhs_obj_holder = lhs_->Execute(closure, context);
 		ObjectHolder rhs_obj_holder = rhs_->Execute(closure, context);
-		runtime::Number* lhs_num_ptr = lhs_obj_holder.TryAs<runtime::Number>();
-		runtime::Number* rhs_num_ptr = rhs_obj_holder.TryAs<runtime::Number>();
-		if (lhs_num_ptr && rhs_num_ptr) {
-			return ObjectHolder::Own(runtime::Number(lhs_num_ptr->GetValue() + rhs_num_ptr->GetValue()));
-		}
-		runtime::String* lhs_str_ptr = lhs_obj_holder.TryAs<runtime::String>();
-		runtime::String* rhs_str_ptr = rhs_obj_holder.TryAs<runtime::String>();
-		if (lhs_str_ptr && rhs_str_ptr) {
-			return ObjectHolder::Own(runtime::String(lhs_str_ptr->GetValue() + rhs_str_ptr->GetValue()));
-		}
-		runtime::ClassInstance* lhs_cls_instance_ptr = lhs_obj_holder.TryAs<runtime::ClassInstance>();
-		if (lhs_cls_instance_ptr && lhs_cls_instance_ptr->HasMethod(ADD_METHOD, 1u)) {
-			return lhs_cls_instance_ptr->Call(ADD_METHOD, { rhs_obj_holder }, context);
+		switch (profile_.GetState()) {
+		case OperandProfile::State::Numbers:
+			if (IsPair(lhs_obj_holder, rhs_obj_holder, runtime::ObjectType::Number)) {
+				return Make<runtime::Number>(context, ValueOf<runtime::Number>(lhs_obj_holder) + ValueOf<runtime::Number>(rhs_obj_holder));
+			}
+			profile_.Deoptimize();
+			break;
+		case OperandProfile::State::Strings:
+			if (IsPair(lhs_obj_holder, rhs_obj_holder, runtime::ObjectType::String)) {
+				return Make<runtime::String>(context, ValueOf<runtime::String>(lhs_obj_holder) + ValueOf<runtime::String>(rhs_obj_holder));
+			}
+			profile_.Deoptimize();
+			break;
+		case OperandProfile::State::Observing:
+			profile_.Observe(lhs_obj_holder.GetType(), rhs_obj_holder.GetType());
+			break;
+		case OperandProfile::State::Generic:
+			break;
 		}
-		throw std::runtime_error("Cannot add arguments"s);
+		return runtime::BinaryDispatch<AddKernel>::Get(lhs_obj_holder.GetType(), rhs_obj_holder.GetType())(
+			lhs_obj_holder, rhs_obj_holder, context);
 	}
 
 	ObjectHolder Sub::Execute(Closure& closure, Context& context) {
 		ObjectHolder lhs_obj_holder = lhs_->Execute(closure, context);
 		ObjectHolder rhs_obj_holder = rhs_->Execute(closure, context);
+		switch (profile_.GetState()) {
+		case OperandProfile::State::Numbers:
+			if (IsPair(lhs_obj_holder, rhs_obj_holder, runtime::ObjectType::Number)) {
+				return Make<runtime::Number>(context, ValueOf<runtime::Number>(lhs_obj_holder) - ValueOf<runtime::Number>(rhs_obj_holder));
+			}
+			profile_.Deoptimize();
+			break;
+		case OperandProfile::State::Observing:
+			profile_.Observe(lhs_obj_holder.GetType(), rhs_obj_holder.GetType());
+			break;
+		default:
+			break;
+		}
 		runtime::Number* lhs_num_ptr = lhs_obj_holder.TryAs<runtime::Number>();
 		runtime::Number* rhs_num_ptr = rhs_obj_holder.TryAs<runtime::Number>();
 		if (lhs_num_ptr && rhs_num_ptr) {
-			return ObjectHolder::Own(runtime::Number(lhs_num_ptr->GetValue() - rhs_num_ptr->GetValue()));
+			return Make<runtime::Number>(context, lhs_num_ptr->GetValue() - rhs_num_ptr->GetValue());
 		}
 		throw std::runtime_error("Cannot subtract arguments"s);
 	}
@@ -150,7 +373,7 @@ namespace ast {
 		runtime::Number* lhs_num_ptr = lhs_obj_holder.TryAs<runtime::Number>();
 		runtime::Number* rhs_num_ptr = rhs_obj_holder.TryAs<runtime::Number>();
 		if (lhs_num_ptr && rhs_num_ptr) {
-			return ObjectHolder::Own(runtime::Number(lhs_num_ptr->GetValue() * rhs_num_ptr->GetValue()));
+			return Make<runtime::Number>(context, lhs_num_ptr->GetValue() * rhs_num_ptr->GetValue());
 		}
 		throw std::runtime_error("Cannot multiply arguments"s);
 	}
@@ -164,7 +387,7 @@ namespace ast {
 			if (rhs_num_ptr->GetValue() == 0) {
 				throw std::runtime_error("Zero division"s);
 			}
-			return ObjectHolder::Own(runtime::Number(lhs_num_ptr->GetValue() / rhs_num_ptr->GetValue()));
+			return Make<runtime::Number>(context, lhs_num_ptr->GetValue() / rhs_num_ptr->GetValue());
 		}
 		throw std::runtime_error("Cannot divide arguments"s);
 	}
@@ -172,12 +395,21 @@ namespace ast {
 	ObjectHolder Compound::Execute(Closure& closure, Context& context) {
 		for (const auto& statement : statements_) {
 			statement->Execute(closure, context);
+			if (context.IsReturning()) {
+				break;
+			}
 		}
 		return ObjectHolder::None();
 	}
 
 	ObjectHolder Return::Execute(Closure& closure, Context& context) {
-		throw statement_->Execute(closure, context);
+		if (tail_call_ && context.GetCallDepth() > 0u) {
+			context.SetReturnValue(tail_call_->ExecuteAsTailCall(closure, context));
+		}
+		else {
+			context.SetReturnValue(statement_->Execute(closure, context));
+		}
+		return ObjectHolder::None();
 	}
 
 	ClassDefinition::ClassDefinition(ObjectHolder cls)
@@ -198,11 +430,28 @@ namespace ast {
 	}
 
 	ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
-		runtime::ClassInstance* cls_instance_ptr = object_.Execute(closure, context).TryAs<runtime::ClassInstance>();
-		if (cls_instance_ptr) {
-			return cls_instance_ptr->Fields()[field_name_] = rv_->Execute(closure, context);
+		const ObjectHolder object = object_.Execute(closure, context);
+		runtime::ClassInstance* cls_instance_ptr = object.TryAs<runtime::ClassInstance>();
+		if (!cls_instance_ptr) {
+			return ObjectHolder::None();
 		}
-		return ObjectHolder::None();
+		ObjectHolder value = rv_->Execute(closure, context);
+		runtime::InstanceFields& fields = cls_instance_ptr->Fields();
+		const runtime::Shape* shape = fields.GetShape();
+		if (cache_.shape != shape) {
+			if (const size_t slot = shape->FindSlot(field_name_); slot != runtime::Shape::NO_SLOT) {
+				cache_ = { shape, nullptr, slot };
+			}
+			else {
+				cache_ = { shape, shape->AddField(field_name_), shape->GetFieldCount() };
+			}
+		}
+		if (cache_.transition) {
+			ObjectHolder& result = fields.AddSlot(cache_.transition, std::move(value));
+			cls_instance_ptr->UpdateMemoryCharge();
+			return result;
+		}
+		return fields.GetSlot(cache_.slot) = std::move(value);
 	}
 
 	IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
@@ -213,7 +462,7 @@ namespace ast {
 	}
 
 	ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
-		if (runtime::IsTrue(condition_->Execute(closure, context))) {
+		if (condition_->EvaluateCondition(closure, context)) {
 			return if_body_->Execute(closure, context);
 		}
 		else if (else_body_) {
@@ -222,63 +471,598 @@ namespace ast {
 		return ObjectHolder::None();
 	}
 
-	ObjectHolder Or::Execute(Closure& closure, Context& context) {
-		if (!runtime::IsTrue(lhs_->Execute(closure, context))) {
-			return ObjectHolder::Own(runtime::Bool(runtime::IsTrue(rhs_->Execute(closure, context))));
+	While::While(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> body)
+		: condition_(std::move(condition))
+		, body_(std::move(body)) {
+	}
+
+	ObjectHolder While::Execute(Closure& closure, Context& context) {
+		while (condition_->EvaluateCondition(closure, context)) {
+			body_->Execute(closure, context);
+			if (context.IsReturning()) {
+				break;
+			}
 		}
-		return ObjectHolder::Own(runtime::Bool(true));
+		return ObjectHolder::None();
 	}
 
-	ObjectHolder And::Execute(Closure& closure, Context& context) {
-		if (runtime::IsTrue(lhs_->Execute(closure, context))) {
-			return ObjectHolder::Own(runtime::Bool(runtime::IsTrue(rhs_->Execute(closure, context))));
+	namespace {
+
+		bool IsVariable(const Statement& statement, const string& variable) {
+			const auto* value = dynamic_cast<const VariableValue*>(&statement);
+			return value && value->GetDottedIds().size() == 1u && value->GetDottedIds().front() == variable;
+		}
+
+		// Возвращает true, если значение переменной variable может сохраниться после вычисления statement
+		bool Escapes(const Statement& statement, const string& variable);
+
+		// То же для операнда, значение которого только читается: переменная-операнд не сохраняется
+		bool EscapesAsOperand(const Statement& operand, const string& variable) {
+			return !IsVariable(operand, variable) && Escapes(operand, variable);
+		}
+
+		// Возвращает true, если выражение - число либо ошибка, так что операция с ним
+		// не вызовет метод Mython у другого операнда
+		bool IsNumeric(const Statement& statement, const string& variable) {
+			return dynamic_cast<const NumericConst*>(&statement) || IsVariable(statement, variable)
+				|| dynamic_cast<const Sub*>(&statement) || dynamic_cast<const Mult*>(&statement)
+				|| dynamic_cast<const Div*>(&statement);
+		}
+
+		bool AnyEscapes(const vector<unique_ptr<Statement>>& statements, const string& variable) {
+			return any_of(statements.begin(), statements.end(), [&variable](const auto& statement) {
+				return Escapes(*statement, variable);
+			});
 		}
-		return ObjectHolder::Own(runtime::Bool(false));
+
+		bool Escapes(const Statement& statement, const string& variable) {
+			if (const auto* value = dynamic_cast<const VariableValue*>(&statement)) {
+				return value->GetDottedIds().front() == variable;
+			}
+			if (dynamic_cast<const NumericConst*>(&statement) || dynamic_cast<const StringConst*>(&statement)
+				|| dynamic_cast<const BoolConst*>(&statement) || dynamic_cast<const None*>(&statement)
+				|| dynamic_cast<const ClassDefinition*>(&statement)) {
+				return false;
+			}
+			if (dynamic_cast<const Add*>(&statement) || dynamic_cast<const Comparison*>(&statement)) {
+				// Правый операнд передаётся методу __add__, __eq__ или __lt__ левого
+				const auto& binary = static_cast<const BinaryOperation&>(statement);
+				return EscapesAsOperand(binary.GetLhs(), variable)
+					|| (IsNumeric(binary.GetLhs(), variable) ? EscapesAsOperand(binary.GetRhs(), variable)
+						: Escapes(binary.GetRhs(), variable));
+			}
+			if (const auto* binary = dynamic_cast<const BinaryOperation*>(&statement)) {
+				return EscapesAsOperand(binary->GetLhs(), variable) || EscapesAsOperand(binary->GetRhs(), variable);
+			}
+			if (const auto* unary = dynamic_cast<const UnaryOperation*>(&statement)) {
+				return EscapesAsOperand(unary->GetArgument(), variable);
+			}
+			if (const auto* print = dynamic_cast<const Print*>(&statement)) {
+				return any_of(print->GetArgs().begin(), print->GetArgs().end(), [&variable](const auto& arg) {
+					return EscapesAsOperand(*arg, variable);
+				});
+			}
+			if (const auto* compound = dynamic_cast<const Compound*>(&statement)) {
+				return AnyEscapes(compound->GetStatements(), variable);
+			}
+			if (const auto* if_else = dynamic_cast<const IfElse*>(&statement)) {
+				return EscapesAsOperand(if_else->GetCondition(), variable) || Escapes(if_else->GetIfBody(), variable)
+					|| (if_else->GetElseBody() && Escapes(*if_else->GetElseBody(), variable));
+			}
+			if (const auto* loop = dynamic_cast<const While*>(&statement)) {
+				return EscapesAsOperand(loop->GetCondition(), variable) || Escapes(loop->GetBody(), variable);
+			}
+			if (const auto* loop = dynamic_cast<const ForRange*>(&statement)) {
+				return EscapesAsOperand(loop->GetBegin(), variable) || EscapesAsOperand(loop->GetEnd(), variable)
+					|| Escapes(loop->GetBody(), variable);
+			}
+			if (const auto* loop = dynamic_cast<const ForEach*>(&statement)) {
+				return EscapesAsOperand(loop->GetIterable(), variable) || Escapes(loop->GetBody(), variable);
+			}
+			if (const auto* index = dynamic_cast<const Index*>(&statement)) {
+				return EscapesAsOperand(index->GetObject(), variable) || EscapesAsOperand(index->GetIndex(), variable);
+			}
+			if (const auto* assignment = dynamic_cast<const IndexAssignment*>(&statement)) {
+				// Ключ словаря сохраняется вместе со значением
+				return EscapesAsOperand(assignment->GetObject(), variable)
+					|| Escapes(assignment->GetIndex(), variable) || Escapes(assignment->GetValue(), variable);
+			}
+			if (const auto* list = dynamic_cast<const ListLiteral*>(&statement)) {
+				return AnyEscapes(list->GetItems(), variable);
+			}
+			if (const auto* dict = dynamic_cast<const DictLiteral*>(&statement)) {
+				return any_of(dict->GetItems().begin(), dict->GetItems().end(), [&variable](const auto& item) {
+					return Escapes(*item.first, variable) || Escapes(*item.second, variable);
+				});
+			}
+			if (const auto* assignment = dynamic_cast<const Assignment*>(&statement)) {
+				return Escapes(assignment->GetValue(), variable);
+			}
+			if (const auto* field_assignment = dynamic_cast<const FieldAssignment*>(&statement)) {
+				return Escapes(field_assignment->GetValue(), variable);
+			}
+			if (const auto* call = dynamic_cast<const MethodCall*>(&statement)) {
+				return Escapes(call->GetObject(), variable) || AnyEscapes(call->GetArgs(), variable);
+			}
+			if (const auto* new_instance = dynamic_cast<const NewInstance*>(&statement)) {
+				return AnyEscapes(new_instance->GetArgs(), variable);
+			}
+			if (const auto* builtin = dynamic_cast<const BuiltinCall*>(&statement)) {
+				// Встроенная функция может сохранить аргументы
+				return AnyEscapes(builtin->GetArgs(), variable);
+			}
+			if (const auto* return_statement = dynamic_cast<const Return*>(&statement)) {
+				return Escapes(return_statement->GetStatement(), variable);
+			}
+			return true;
+		}
+
+		int EvaluateBound(Statement& bound, Closure& closure, Context& context) {
+			const ObjectHolder value = bound.Execute(closure, context);
+			if (value.GetType() != runtime::ObjectType::Number) {
+				throw std::runtime_error("range() bounds must be numbers"s);
+			}
+			return ValueOf<runtime::Number>(value);
+		}
+
+	}  // namespace
+
+	ForRange::ForRange(std::string variable, std::unique_ptr<Statement> begin, std::unique_ptr<Statement> end,
+		std::unique_ptr<Statement> body)
+		: variable_(std::move(variable))
+		, begin_(std::move(begin))
+		, end_(std::move(end))
+		, body_(std::move(body))
+		, escapes_(Escapes(*body_, variable_)) {
+	}
+
+	ObjectHolder ForRange::Execute(Closure& closure, Context& context) {
+		const int begin = EvaluateBound(*begin_, closure, context);
+		const int end = EvaluateBound(*end_, closure, context);
+		if (begin >= end) {
+			return ObjectHolder::None();
+		}
+		// Тело не удаляет переменные из closure, а переменные Closure не перемещаются при
+		// добавлении новых, поэтому ссылка на значение остаётся действительной
+		ObjectHolder& slot = closure[variable_];
+		if (escapes_) {
+			for (int i = begin; i < end; ++i) {
+				slot = ObjectHolder::Own(runtime::Number(i));
+				body_->Execute(closure, context);
+				if (context.IsReturning()) {
+					break;
+				}
+			}
+			return ObjectHolder::None();
+		}
+
+		// Один объект на всё выполнение цикла: рекурсивный вызов метода с этим же циклом
+		// получит свой объект
+		const ObjectHolder counter = ObjectHolder::Own(runtime::Number(begin));
+		auto* value = static_cast<runtime::Number*>(counter.Get());
+		for (int i = begin; i < end; ++i) {
+			value->SetValue(i);
+			// Тело могло присвоить переменной другое значение
+			if (slot.Get() != value) {
+				slot = counter;
+			}
+			body_->Execute(closure, context);
+			if (context.IsReturning()) {
+				break;
+			}
+		}
+		return ObjectHolder::None();
+	}
+
+	ForEach::ForEach(std::string variable, std::unique_ptr<Statement> iterable, std::unique_ptr<Statement> body)
+		: variable_(std::move(variable))
+		, iterable_(std::move(iterable))
+		, body_(std::move(body)) {
+	}
+
+	ObjectHolder ForEach::Execute(Closure& closure, Context& context) {
+		const ObjectHolder iterable = iterable_->Execute(closure, context);
+		// Для пустого контейнера переменная цикла не создаётся
+		if (runtime::GetIterationSize(iterable) == 0u) {
+			return ObjectHolder::None();
+		}
+		// Тело не удаляет переменные из closure (см. ForRange)
+		ObjectHolder& slot = closure[variable_];
+		for (size_t i = 0u; i < runtime::GetIterationSize(iterable); ++i) {
+			slot = runtime::GetIterationItem(iterable, i);
+			body_->Execute(closure, context);
+			if (context.IsReturning()) {
+				break;
+			}
+		}
+		return ObjectHolder::None();
+	}
+
+	ObjectHolder Or::Execute(Closure& closure, Context& context) {
+		return Make<runtime::Bool>(context, EvaluateCondition(closure, context));
+	}
+
+	bool Or::EvaluateCondition(Closure& closure, Context& context) {
+		return lhs_->EvaluateCondition(closure, context) || rhs_->EvaluateCondition(closure, context);
+	}
+
+	ObjectHolder And::Execute(Closure& closure, Context& context) {
+		return Make<runtime::Bool>(context, EvaluateCondition(closure, context));
+	}
+
+	bool And::EvaluateCondition(Closure& closure, Context& context) {
+		return lhs_->EvaluateCondition(closure, context) && rhs_->EvaluateCondition(closure, context);
 	}
 
 	ObjectHolder Not::Execute(Closure& closure, Context& context) {
-		return ObjectHolder::Own(runtime::Bool(!runtime::IsTrue(arg_->Execute(closure, context))));
+		return Make<runtime::Bool>(context, EvaluateCondition(closure, context));
+	}
+
+	bool Not::EvaluateCondition(Closure& closure, Context& context) {
+		return !arg_->EvaluateCondition(closure, context);
 	}
 
-	Comparison::Comparison(Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs)
+	Comparison::Comparison(runtime::CompareOp op, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs)
 		: BinaryOperation(std::move(lhs), std::move(rhs))
-		, cmp_(std::move(cmp)) {
+		, op_(op) {
 	}
 
 	ObjectHolder Comparison::Execute(Closure& closure, Context& context) {
-		return ObjectHolder::Own(runtime::Bool(cmp_(lhs_->Execute(closure, context), rhs_->Execute(closure, context), context)));
+		return Make<runtime::Bool>(context, EvaluateCondition(closure, context));
+	}
+
+	bool Comparison::EvaluateCondition(Closure& closure, Context& context) {
+		ObjectHolder lhs_obj_holder = lhs_->Execute(closure, context);
+		ObjectHolder rhs_obj_holder = rhs_->Execute(closure, context);
+		switch (profile_.GetState()) {
+		case OperandProfile::State::Numbers:
+			if (IsPair(lhs_obj_holder, rhs_obj_holder, runtime::ObjectType::Number)) {
+				return runtime::CompareValues(op_, ValueOf<runtime::Number>(lhs_obj_holder), ValueOf<runtime::Number>(rhs_obj_holder));
+			}
+			profile_.Deoptimize();
+			break;
+		case OperandProfile::State::Strings:
+			if (IsPair(lhs_obj_holder, rhs_obj_holder, runtime::ObjectType::String)) {
+				return runtime::CompareValues(op_, ValueOf<runtime::String>(lhs_obj_holder), ValueOf<runtime::String>(rhs_obj_holder));
+			}
+			profile_.Deoptimize();
+			break;
+		case OperandProfile::State::Observing:
+			profile_.Observe(lhs_obj_holder.GetType(), rhs_obj_holder.GetType());
+			break;
+		case OperandProfile::State::Generic:
+			break;
+		}
+		return runtime::Compare(op_, lhs_obj_holder, rhs_obj_holder, context);
 	}
 
+	namespace {
+
+		const runtime::Method* FindConstructor(const runtime::Class& cls, size_t argument_count) {
+			const runtime::Method* init = cls.GetMethod(runtime::SpecialMethod::Init);
+			return init && init->formal_params.size() == argument_count ? init : nullptr;
+		}
+
+	}  // namespace
+
 	NewInstance::NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args)
-		: cls_instance_(class_)
+		: class_(class_)
+		, init_(FindConstructor(class_, args.size()))
 		, args_(std::move(args)) {
 	}
 
 	NewInstance::NewInstance(const runtime::Class& class_)
-		: cls_instance_(class_) {
+		: class_(class_)
+		, init_(FindConstructor(class_, 0u)) {
 	}
 
 	ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
-		if (cls_instance_.HasMethod(INIT_METHOD, args_.size())) {
-			std::vector<ObjectHolder> actual_args(args_.size());
-			for (size_t i = 0u; i < args_.size(); ++i) {
-				actual_args[i] = args_[i]->Execute(closure, context);
-			}
-			cls_instance_.Call(INIT_METHOD, std::move(actual_args), context);
+		if (!init_) {
+			return Construct({}, context);
 		}
-		return ObjectHolder::Share(cls_instance_);
+		ArgumentBuffer actual_args(args_, closure, context);
+		return Construct(actual_args, context);
 	}
 
+	bool NewInstance::HasConstructor() const {
+		return init_ != nullptr;
+	}
+
+	ObjectHolder NewInstance::Construct(runtime::Arguments args, Context& context) const {
+		runtime::FrameArena* arena = IsFrameLocal() ? context.GetFrameArena() : nullptr;
+		// Объекты кадра не входят в циклы: ссылка на такой объект не покидает метод
+		ObjectHolder instance = arena ? class_.CreateInstance(*arena) : Track(class_.CreateInstance(), context);
+		if (init_) {
+			static_cast<runtime::ClassInstance*>(instance.Get())->Call(*init_, args, context);
+		}
+		return instance;
+	}
+
+	namespace {
+
+		// Как используется значение выражения
+		struct Use {
+			enum class Kind : uint8_t {
+				// Значение только читается: условие, операнд арифметики, индекс при чтении
+				Consumed,
+				// Значение читается, но у экземпляра класса вызывается метод: print, str, левый операнд + и сравнений
+				Operand,
+				// Объект вызова метода name с argument_count аргументами
+				Receiver,
+				// Значение присваивается локальной переменной name
+				Variable,
+				// Значение сохраняется, возвращается или передаётся вызываемому коду
+				Escaping,
+			};
+
+			Kind kind = Kind::Escaping;
+			const string* name = nullptr;
+			size_t argument_count = 0;
+		};
+
+		constexpr Use CONSUMED{ Use::Kind::Consumed };
+		constexpr Use OPERAND{ Use::Kind::Operand };
+		constexpr Use ESCAPING{ Use::Kind::Escaping };
+
+		// Возвращает true, если выражение вычисляет число, строку или Bool либо выбрасывает исключение,
+		// так что операция с ним не вызывает методы другого операнда
+		bool IsPlainValue(const Statement& statement) {
+			return dynamic_cast<const NumericConst*>(&statement) || dynamic_cast<const StringConst*>(&statement)
+				|| dynamic_cast<const BoolConst*>(&statement) || dynamic_cast<const Sub*>(&statement)
+				|| dynamic_cast<const Mult*>(&statement) || dynamic_cast<const Div*>(&statement)
+				|| dynamic_cast<const Stringify*>(&statement) || dynamic_cast<const Length*>(&statement)
+				|| dynamic_cast<const Comparison*>(&statement) || dynamic_cast<const Or*>(&statement)
+				|| dynamic_cast<const And*>(&statement) || dynamic_cast<const Not*>(&statement);
+		}
+
+		// Вызывает visit(child, use) для каждого подвыражения statement. Для неизвестных узлов возвращает false
+		template <typename Visitor>
+		bool VisitChildren(const Statement& statement, Visitor&& visit) {
+			auto visit_all = [&visit](const vector<unique_ptr<Statement>>& statements, Use use) {
+				for (const auto& child : statements) {
+					visit(*child, use);
+				}
+			};
+			if (dynamic_cast<const VariableValue*>(&statement) || dynamic_cast<const NumericConst*>(&statement)
+				|| dynamic_cast<const StringConst*>(&statement) || dynamic_cast<const BoolConst*>(&statement)
+				|| dynamic_cast<const None*>(&statement) || dynamic_cast<const ClassDefinition*>(&statement)) {
+				return true;
+			}
+			if (dynamic_cast<const Add*>(&statement) || dynamic_cast<const Comparison*>(&statement)) {
+				// Правый операнд передаётся методу __add__, __eq__ или __lt__ левого
+				const auto& binary = static_cast<const BinaryOperation&>(statement);
+				visit(binary.GetLhs(), OPERAND);
+				visit(binary.GetRhs(), IsPlainValue(binary.GetLhs()) ? CONSUMED : ESCAPING);
+				return true;
+			}
+			if (const auto* binary = dynamic_cast<const BinaryOperation*>(&statement)) {
+				visit(binary->GetLhs(), CONSUMED);
+				visit(binary->GetRhs(), CONSUMED);
+				return true;
+			}
+			if (const auto* stringify = dynamic_cast<const Stringify*>(&statement)) {
+				visit(stringify->GetArgument(), OPERAND);
+				return true;
+			}
+			if (const auto* unary = dynamic_cast<const UnaryOperation*>(&statement)) {
+				visit(unary->GetArgument(), CONSUMED);
+				return true;
+			}
+			if (const auto* print = dynamic_cast<const Print*>(&statement)) {
+				visit_all(print->GetArgs(), OPERAND);
+				return true;
+			}
+			if (const auto* compound = dynamic_cast<const Compound*>(&statement)) {
+				visit_all(compound->GetStatements(), CONSUMED);
+				return true;
+			}
+			if (const auto* if_else = dynamic_cast<const IfElse*>(&statement)) {
+				visit(if_else->GetCondition(), CONSUMED);
+				visit(if_else->GetIfBody(), CONSUMED);
+				if (if_else->GetElseBody()) {
+					visit(*if_else->GetElseBody(), CONSUMED);
+				}
+				return true;
+			}
+			if (const auto* loop = dynamic_cast<const While*>(&statement)) {
+				visit(loop->GetCondition(), CONSUMED);
+				visit(loop->GetBody(), CONSUMED);
+				return true;
+			}
+			if (const auto* loop = dynamic_cast<const ForRange*>(&statement)) {
+				visit(loop->GetBegin(), CONSUMED);
+				visit(loop->GetEnd(), CONSUMED);
+				visit(loop->GetBody(), CONSUMED);
+				return true;
+			}
+			if (const auto* loop = dynamic_cast<const ForEach*>(&statement)) {
+				visit(loop->GetIterable(), CONSUMED);
+				visit(loop->GetBody(), CONSUMED);
+				return true;
+			}
+			if (const auto* index = dynamic_cast<const Index*>(&statement)) {
+				visit(index->GetObject(), CONSUMED);
+				visit(index->GetIndex(), CONSUMED);
+				return true;
+			}
+			if (const auto* assignment = dynamic_cast<const IndexAssignment*>(&statement)) {
+				// Ключ словаря сохраняется вместе со значением
+				visit(assignment->GetObject(), CONSUMED);
+				visit(assignment->GetIndex(), ESCAPING);
+				visit(assignment->GetValue(), ESCAPING);
+				return true;
+			}
+			if (const auto* list = dynamic_cast<const ListLiteral*>(&statement)) {
+				visit_all(list->GetItems(), ESCAPING);
+				return true;
+			}
+			if (const auto* dict = dynamic_cast<const DictLiteral*>(&statement)) {
+				for (const auto& [key, value] : dict->GetItems()) {
+					visit(*key, ESCAPING);
+					visit(*value, ESCAPING);
+				}
+				return true;
+			}
+			if (const auto* assignment = dynamic_cast<const Assignment*>(&statement)) {
+				visit(assignment->GetValue(), Use{ Use::Kind::Variable, &assignment->GetVariableName() });
+				return true;
+			}
+			if (const auto* field_assignment = dynamic_cast<const FieldAssignment*>(&statement)) {
+				visit(field_assignment->GetObject(), CONSUMED);
+				visit(field_assignment->GetValue(), ESCAPING);
+				return true;
+			}
+			if (const auto* call = dynamic_cast<const MethodCall*>(&statement)) {
+				visit(call->GetObject(), Use{ Use::Kind::Receiver, &call->GetMethodName(), call->GetArgs().size() });
+				visit_all(call->GetArgs(), ESCAPING);
+				return true;
+			}
+			if (const auto* new_instance = dynamic_cast<const NewInstance*>(&statement)) {
+				visit_all(new_instance->GetArgs(), ESCAPING);
+				return true;
+			}
+			if (const auto* builtin = dynamic_cast<const BuiltinCall*>(&statement)) {
+				// Встроенная функция может сохранить или вернуть аргументы
+				visit_all(builtin->GetArgs(), ESCAPING);
+				return true;
+			}
+			if (const auto* return_statement = dynamic_cast<const Return*>(&statement)) {
+				visit(return_statement->GetStatement(), ESCAPING);
+				return true;
+			}
+			if (const auto* method_body = dynamic_cast<const MethodBody*>(&statement)) {
+				visit(method_body->GetBody(), CONSUMED);
+				return true;
+			}
+			return false;
+		}
+
+		/*
+		Анализ побега для тела метода. Значение узла, создающего объект, покидает кадр, если
+		оно используется как ESCAPING либо присваивается переменной, значение которой где-либо
+		в теле используется так (для инструкций верхнего уровня - любой переменной).
+		Присваивание переменной другой переменной тоже считается побегом. Для экземпляра класса
+		побегом считается и вызов его метода, если этот метод (с учётом вызываемых им методов
+		self) выпускает self, а также print, str и операции со специальными методами
+		*/
+		class FrameLocalAnalysis {
+		public:
+			// Если variables_escape равно true, значение, присвоенное переменной, покидает кадр
+			explicit FrameLocalAnalysis(const Statement& body, bool variables_escape = false)
+				: body_(body)
+				, variables_escape_(variables_escape) {
+			}
+
+			// Возвращает узлы тела, объекты которых не покидают кадр
+			vector<const FrameAllocation*> FindSites() {
+				Walk(body_, CONSUMED);
+				return std::move(sites_);
+			}
+
+		private:
+			void Walk(const Statement& statement, Use use) {
+				if (const auto* site = dynamic_cast<const FrameAllocation*>(&statement)) {
+					const auto* new_instance = dynamic_cast<const NewInstance*>(&statement);
+					const runtime::Class* cls = new_instance ? &new_instance->GetClass() : nullptr;
+					bool escapes = use.kind == Use::Kind::Variable
+						? variables_escape_ || VariableEscapes(body_, *use.name, cls)
+						: UseEscapes(use, cls);
+					if (new_instance && new_instance->HasConstructor()) {
+						escapes = escapes || SelfEscapes(*cls, *cls->GetMethod(runtime::SpecialMethod::Init));
+					}
+					if (!escapes) {
+						sites_.push_back(site);
+					}
+				}
+				VisitChildren(statement, [this](const Statement& child, Use child_use) {
+					Walk(child, child_use);
+				});
+			}
+
+			// Возвращает true, если значение покидает кадр при использовании use. cls - класс
+			// экземпляра либо nullptr для числа, строки и Bool
+			bool UseEscapes(Use use, const runtime::Class* cls) {
+				switch (use.kind) {
+				case Use::Kind::Consumed:
+					return false;
+				case Use::Kind::Operand:
+					return cls != nullptr;
+				case Use::Kind::Receiver: {
+					if (!cls) {
+						return true;
+					}
+					const runtime::Method* method = cls->GetMethod(*use.name);
+					return !method || method->formal_params.size() != use.argument_count || SelfEscapes(*cls, *method);
+				}
+				default:
+					return true;
+				}
+			}
+
+			// Возвращает true, если значение переменной variable может покинуть кадр при выполнении statement
+			bool VariableEscapes(const Statement& statement, const string& variable, const runtime::Class* cls) {
+				bool escapes = false;
+				const bool known = VisitChildren(statement, [&](const Statement& child, Use use) {
+					if (escapes) {
+						return;
+					}
+					const auto* value = dynamic_cast<const VariableValue*>(&child);
+					if (value && value->GetDottedIds().size() == 1u && value->GetDottedIds().front() == variable) {
+						escapes = UseEscapes(use, cls);
+					}
+					else {
+						escapes = VariableEscapes(child, variable, cls);
+					}
+				});
+				return escapes || !known;
+			}
+
+			// Возвращает true, если метод method, вызванный у экземпляра класса cls, может выпустить self.
+			// Пока метод анализируется, рекурсивные вызовы считаются выпускающими self
+			bool SelfEscapes(const runtime::Class& cls, const runtime::Method& method) {
+				const auto key = make_pair(&cls, &method);
+				if (const auto it = self_escapes_.find(key); it != self_escapes_.end()) {
+					return it->second;
+				}
+				self_escapes_[key] = true;
+				const auto* body = dynamic_cast<const MethodBody*>(method.body.get());
+				const bool escapes = !body || VariableEscapes(body->GetBody(), "self"s, &cls);
+				self_escapes_[key] = escapes;
+				return escapes;
+			}
+
+			const Statement& body_;
+			const bool variables_escape_;
+			vector<const FrameAllocation*> sites_;
+			map<pair<const runtime::Class*, const runtime::Method*>, bool> self_escapes_;
+		};
+
+	}  // namespace
+
 	MethodBody::MethodBody(std::unique_ptr<Statement>&& body)
 		: body_(std::move(body)) {
+		// Узлы тела принадлежат ему, поэтому отметки можно ставить через константные ссылки анализа
+		for (const FrameAllocation* site : FrameLocalAnalysis(*body_).FindSites()) {
+			const_cast<FrameAllocation*>(site)->SetFrameLocal(true);
+			++frame_local_count_;
+		}
+	}
+
+	size_t MarkStatementTemporaries(const Statement& program) {
+		const vector<const FrameAllocation*> sites = FrameLocalAnalysis(program, true).FindSites();
+		for (const FrameAllocation* site : sites) {
+			const_cast<FrameAllocation*>(site)->SetFrameLocal(true);
+		}
+		return sites.size();
 	}
 
 	ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
-		try {
-			body_->Execute(closure, context);
+		if (optimized_) {
+			return optimized_->Execute(closure, context);
 		}
-		catch (const ObjectHolder& obj_holder) {
-			return obj_holder;
+		body_->Execute(closure, context);
+		if (context.IsReturning()) {
+			return context.TakeReturnValue();
 		}
 		return ObjectHolder::None();
 	}
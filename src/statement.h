@@ -2,34 +2,88 @@
 
 #include "runtime.h"
 
-#include <functional>
-
 namespace ast {
 
 	using Statement = runtime::Executable;
 
 	// Выражение, возвращающее значение типа T,
-	// используется как основа для создания констант
+	// используется как основа для создания констант.
+	// Значение размещается в куче: переменные программы, которым оно присвоено, могут пережить дерево
 	template <typename T>
 	class ValueStatement : public Statement {
 	public:
 		explicit ValueStatement(T v)
-			: value_(std::move(v)) {
+			: value_(runtime::ObjectHolder::Own(std::move(v))) {
 		}
 
 		runtime::ObjectHolder Execute(runtime::Closure& /*closure*/,
 			runtime::Context& /*context*/) override {
-			return runtime::ObjectHolder::Share(value_);
+			return value_;
+		}
+
+		bool EvaluateCondition(runtime::Closure& /*closure*/, runtime::Context& /*context*/) override {
+			if constexpr (std::is_same_v<T, runtime::String>) {
+				return !GetValue().GetValue().empty();
+			}
+			else {
+				return static_cast<bool>(GetValue().GetValue());
+			}
+		}
+
+		[[nodiscard]] const T& GetValue() const {
+			return *static_cast<const T*>(value_.Get());
 		}
 
 	private:
-		T value_;
+		runtime::ObjectHolder value_;
 	};
 
 	using NumericConst = ValueStatement<runtime::Number>;
 	using StringConst = ValueStatement<runtime::String>;
 	using BoolConst = ValueStatement<runtime::Bool>;
 
+	/*
+	Inline-кэш доступа к полю объекта: запоминает форму, которую имел объект при последнем
+	обращении, и смещение поля в ней. Если поле при записи добавляется, запоминается
+	форма после перехода
+	*/
+	struct FieldCache {
+		const runtime::Shape* shape = nullptr;
+		const runtime::Shape* transition = nullptr;
+		size_t slot = 0;
+	};
+
+	/*
+	Узел, создающий объект. Если анализ тела метода (см. MethodBody) показал, что созданный объект
+	не сохраняется в полях и контейнерах, не возвращается и не передаётся вызываемому коду, узел
+	размещает объект в памяти кадра метода (см. runtime::FrameArena), а не в куче. Узлы инструкций
+	верхнего уровня программы размещают так промежуточные значения (см. MarkStatementTemporaries)
+	*/
+	class FrameAllocation {
+	public:
+		[[nodiscard]] bool IsFrameLocal() const {
+			return frame_local_;
+		}
+		void SetFrameLocal(bool frame_local) {
+			frame_local_ = frame_local;
+		}
+
+	protected:
+		// Создаёт объект типа T из args в памяти текущего кадра, если объект не покидает метод, иначе в куче
+		template <typename T, typename... Args>
+		runtime::ObjectHolder Make(runtime::Context& context, Args&&... args) const {
+			if (frame_local_) {
+				if (runtime::FrameArena* arena = context.GetFrameArena()) {
+					return arena->Create<T>(std::forward<Args>(args)...);
+				}
+			}
+			return runtime::ObjectHolder::Own(T(std::forward<Args>(args)...));
+		}
+
+	private:
+		bool frame_local_ = false;
+	};
+
 	/*
 	Вычисляет значение переменной либо цепочки вызовов полей объектов id1.id2.id3.
 	Например, выражение circle.center.x - цепочка вызовов полей объектов в инструкции:
@@ -41,8 +95,13 @@ namespace ast {
 		explicit VariableValue(std::vector<std::string> dotted_ids);
 
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const std::vector<std::string>& GetDottedIds() const {
+			return dotted_ids_;
+		}
 	private:
 		std::vector<std::string> dotted_ids_;
+		std::vector<FieldCache> field_caches_;
 	};
 
 	// Присваивает переменной, имя которой задано в параметре var, значение выражения rv
@@ -51,6 +110,13 @@ namespace ast {
 		Assignment(std::string var, std::unique_ptr<Statement> rv);
 
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const std::string& GetVariableName() const {
+			return var_;
+		}
+		[[nodiscard]] const Statement& GetValue() const {
+			return *rv_;
+		}
 	private:
 		std::string var_;
 		std::unique_ptr<Statement> rv_;
@@ -62,10 +128,21 @@ namespace ast {
 		FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv);
 
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const VariableValue& GetObject() const {
+			return object_;
+		}
+		[[nodiscard]] const std::string& GetFieldName() const {
+			return field_name_;
+		}
+		[[nodiscard]] const Statement& GetValue() const {
+			return *rv_;
+		}
 	private:
 		VariableValue object_;
 		std::string field_name_;
 		std::unique_ptr<Statement> rv_;
+		FieldCache cache_;
 	};
 
 	// Значение None
@@ -91,25 +168,56 @@ namespace ast {
 		// Во время выполнения команды print вывод должен осуществляться в поток, возвращаемый из
 		// context.GetOutputStream()
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const {
+			return args_;
+		}
 	private:
 		std::vector<std::unique_ptr<Statement>> args_;
 	};
 
-	// Вызывает метод object.method со списком параметров args
+	// Вызывает метод object.method со списком параметров args. Объект - экземпляр класса либо
+	// объект со встроенным методом (см. runtime::HasBuiltinMethod)
 	class MethodCall : public Statement {
 	public:
 		MethodCall(std::unique_ptr<Statement> object, std::string method,
 			std::vector<std::unique_ptr<Statement>> args);
 
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		// Вычисляет объект и аргументы вызова и откладывает вызов в context как хвостовой.
+		// Встроенный метод вызывается сразу, и возвращается его результат, иначе - None
+		runtime::ObjectHolder ExecuteAsTailCall(runtime::Closure& closure, runtime::Context& context);
+
+		[[nodiscard]] const Statement& GetObject() const {
+			return *object_;
+		}
+		[[nodiscard]] const std::string& GetMethodName() const {
+			return method_;
+		}
+		[[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const {
+			return args_;
+		}
+		// Сколько раз выполнялся этот вызов, включая хвостовые
+		[[nodiscard]] uint64_t GetExecutionCount() const {
+			return executions_;
+		}
 	private:
+		// Вычисляет объект и находит вызываемый метод. Для встроенного метода возвращает nullptr.
+		// Если метод не найден, выбрасывает runtime_error
+		std::pair<runtime::ObjectHolder, const runtime::Method*> ResolveMethod(runtime::Closure& closure,
+			runtime::Context& context);
+
 		std::unique_ptr<Statement> object_;
 		std::string method_;
 		std::vector<std::unique_ptr<Statement>> args_;
+		uint64_t executions_ = 0;
 	};
 
 	/*
 	Создаёт новый экземпляр класса class_, передавая его конструктору набор параметров args.
+	Каждое выполнение узла создаёт отдельный экземпляр в пуле экземпляров класса (см. Class::CreateInstance)
+	либо, если экземпляр не покидает метод, в памяти кадра (см. FrameAllocation).
 	Если в классе отсутствует метод __init__ с заданным количеством аргументов,
 	то экземпляр класса создаётся без вызова конструктора (поля объекта не будут проинициализированы):
 
@@ -121,14 +229,31 @@ namespace ast {
 	# Поле name будет иметь значение только после вызова метода set_name
 	p.set_name("Ivan")
 	*/
-	class NewInstance : public Statement {
+	class NewInstance : public Statement, public FrameAllocation {
 	public:
 		explicit NewInstance(const runtime::Class& class_);
 		NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args);
 		// Возвращает объект, содержащий значение типа ClassInstance
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const runtime::Class& GetClass() const {
+			return class_;
+		}
+		[[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const {
+			return args_;
+		}
+
+		// Возвращает true, если у класса есть __init__ с числом параметров, равным числу аргументов.
+		// Иначе аргументы не вычисляются и конструктор не вызывается
+		[[nodiscard]] bool HasConstructor() const;
+
+		// Создаёт экземпляр и вызывает его конструктор с уже вычисленными аргументами (если
+		// конструктор есть). Если конструктора нет, args должен быть пустым
+		runtime::ObjectHolder Construct(runtime::Arguments args, runtime::Context& context) const;
 	private:
-		runtime::ClassInstance cls_instance_;
+		const runtime::Class& class_;
+		// Конструктор __init__ с числом параметров, равным числу аргументов, либо nullptr
+		const runtime::Method* init_;
 		std::vector<std::unique_ptr<Statement>> args_;
 	};
 
@@ -138,17 +263,116 @@ namespace ast {
 		explicit UnaryOperation(std::unique_ptr<Statement> argument)
 			: arg_(std::move(argument)) {
 		}
+
+		[[nodiscard]] const Statement& GetArgument() const {
+			return *arg_;
+		}
 	protected:
 		std::unique_ptr<Statement> arg_;
 	};
 
 	// Операция str, возвращающая строковое значение своего аргумента
-	class Stringify : public UnaryOperation {
+	class Stringify : public UnaryOperation, public FrameAllocation {
 	public:
 		using UnaryOperation::UnaryOperation;
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 	};
 
+	// Операция len, возвращающая количество элементов списка или словаря либо длину строки
+	// (см. runtime::GetLength)
+	class Length : public UnaryOperation, public FrameAllocation {
+	public:
+		using UnaryOperation::UnaryOperation;
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+	};
+
+	// Вызов встроенной функции f(args) (см. runtime::BuiltinRegistry). Функция найдена парсером,
+	// число аргументов совпадает с её числом параметров
+	class BuiltinCall : public Statement {
+	public:
+		BuiltinCall(const runtime::BuiltinFunction& function, std::vector<std::unique_ptr<Statement>> args);
+
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const runtime::BuiltinFunction& GetFunction() const {
+			return function_;
+		}
+
+		[[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const {
+			return args_;
+		}
+	private:
+		const runtime::BuiltinFunction& function_;
+		std::vector<std::unique_ptr<Statement>> args_;
+	};
+
+	// Литерал списка [item1, item2, ...]. Каждое выполнение создаёт новый список
+	class ListLiteral : public Statement {
+	public:
+		explicit ListLiteral(std::vector<std::unique_ptr<Statement>> items);
+
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetItems() const {
+			return items_;
+		}
+	private:
+		std::vector<std::unique_ptr<Statement>> items_;
+	};
+
+	// Литерал словаря {key1: value1, ...}. Каждое выполнение создаёт новый словарь
+	class DictLiteral : public Statement {
+	public:
+		explicit DictLiteral(std::vector<std::pair<std::unique_ptr<Statement>, std::unique_ptr<Statement>>> items);
+
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const std::vector<std::pair<std::unique_ptr<Statement>, std::unique_ptr<Statement>>>& GetItems() const {
+			return items_;
+		}
+	private:
+		std::vector<std::pair<std::unique_ptr<Statement>, std::unique_ptr<Statement>>> items_;
+	};
+
+	// Обращение по индексу object[index] к элементу списка, символу строки или значению словаря
+	// (см. runtime::GetItem)
+	class Index : public Statement {
+	public:
+		Index(std::unique_ptr<Statement> object, std::unique_ptr<Statement> index);
+
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const Statement& GetObject() const {
+			return *object_;
+		}
+		[[nodiscard]] const Statement& GetIndex() const {
+			return *index_;
+		}
+	private:
+		std::unique_ptr<Statement> object_, index_;
+	};
+
+	// Присваивает элементу списка или словаря object[index] значение выражения rv (см. runtime::SetItem)
+	class IndexAssignment : public Statement {
+	public:
+		IndexAssignment(std::unique_ptr<Statement> object, std::unique_ptr<Statement> index,
+			std::unique_ptr<Statement> rv);
+
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const Statement& GetObject() const {
+			return *object_;
+		}
+		[[nodiscard]] const Statement& GetIndex() const {
+			return *index_;
+		}
+		[[nodiscard]] const Statement& GetValue() const {
+			return *rv_;
+		}
+	private:
+		std::unique_ptr<Statement> object_, index_, rv_;
+	};
+
 	// Родительский класс Бинарная операция с аргументами lhs и rhs
 	class BinaryOperation : public Statement {
 	public:
@@ -156,12 +380,55 @@ namespace ast {
 			: lhs_(std::move(lhs))
 			, rhs_(std::move(rhs)) {
 		}
+
+		[[nodiscard]] const Statement& GetLhs() const {
+			return *lhs_;
+		}
+		[[nodiscard]] const Statement& GetRhs() const {
+			return *rhs_;
+		}
 	protected:
 		std::unique_ptr<Statement> lhs_, rhs_;
 	};
 
+	/*
+	Профиль типов операндов бинарной операции. Первые WARMUP_EXECUTIONS выполнений узел
+	наблюдает типы операндов; если все они были парами чисел либо парами строк, узел
+	переключается на специализированный вариант. Специализированный вариант проверяет типы
+	операндов (guard) и при несовпадении навсегда возвращает узел к обобщённому варианту
+	*/
+	class OperandProfile {
+	public:
+		enum class State : uint8_t {
+			Observing,
+			Numbers,
+			Strings,
+			Generic,
+		};
+
+		static constexpr uint8_t WARMUP_EXECUTIONS = 2u;
+
+		[[nodiscard]] State GetState() const {
+			return state_;
+		}
+
+		// Учитывает типы операндов очередного выполнения. Вызывается в состоянии Observing
+		void Observe(runtime::ObjectType lhs, runtime::ObjectType rhs);
+
+		// Возвращает узел к обобщённому варианту после нарушения guard'а
+		void Deoptimize() {
+			state_ = State::Generic;
+		}
+
+	private:
+		State state_ = State::Observing;
+		uint8_t observed_ = 0u;
+		runtime::ObjectType lhs_ = runtime::ObjectType::None;
+		runtime::ObjectType rhs_ = runtime::ObjectType::None;
+	};
+
 	// Возвращает результат операции + над аргументами lhs и rhs
-	class Add : public BinaryOperation {
+	class Add : public BinaryOperation, public FrameAllocation {
 	public:
 		using BinaryOperation::BinaryOperation;
 
@@ -170,22 +437,28 @@ namespace ast {
 		//  строка + строка
 		//  объект1 + объект2, если у объект1 - пользовательский класс с методом _add__(rhs)
 		// В противном случае при вычислении выбрасывается runtime_error
+		// Узел специализируется для пар чисел и пар строк (см. OperandProfile)
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+	private:
+		OperandProfile profile_;
 	};
 
 	// Возвращает результат вычитания аргументов lhs и rhs
-	class Sub : public BinaryOperation {
+	class Sub : public BinaryOperation, public FrameAllocation {
 	public:
 		using BinaryOperation::BinaryOperation;
 
 		// Поддерживается вычитание:
 		//  число - число
 		// Если lhs и rhs - не числа, выбрасывается исключение runtime_error
+		// Узел специализируется для пар чисел (см. OperandProfile)
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+	private:
+		OperandProfile profile_;
 	};
 
 	// Возвращает результат умножения аргументов lhs и rhs
-	class Mult : public BinaryOperation {
+	class Mult : public BinaryOperation, public FrameAllocation {
 	public:
 		using BinaryOperation::BinaryOperation;
 
@@ -196,7 +469,7 @@ namespace ast {
 	};
 
 	// Возвращает результат деления lhs и rhs
-	class Div : public BinaryOperation {
+	class Div : public BinaryOperation, public FrameAllocation {
 	public:
 		using BinaryOperation::BinaryOperation;
 
@@ -208,28 +481,31 @@ namespace ast {
 	};
 
 	// Возвращает результат вычисления логической операции or над lhs и rhs
-	class Or : public BinaryOperation {
+	class Or : public BinaryOperation, public FrameAllocation {
 	public:
 		using BinaryOperation::BinaryOperation;
 		// Значение аргумента rhs вычисляется, только если значение lhs
 		// после приведения к Bool равно False
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+		bool EvaluateCondition(runtime::Closure& closure, runtime::Context& context) override;
 	};
 
 	// Возвращает результат вычисления логической операции and над lhs и rhs
-	class And : public BinaryOperation {
+	class And : public BinaryOperation, public FrameAllocation {
 	public:
 		using BinaryOperation::BinaryOperation;
 		// Значение аргумента rhs вычисляется, только если значение lhs
 		// после приведения к Bool равно True
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+		bool EvaluateCondition(runtime::Closure& closure, runtime::Context& context) override;
 	};
 
 	// Возвращает результат вычисления логической операции not над единственным аргументом операции
-	class Not : public UnaryOperation {
+	class Not : public UnaryOperation, public FrameAllocation {
 	public:
 		using UnaryOperation::UnaryOperation;
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+		bool EvaluateCondition(runtime::Closure& closure, runtime::Context& context) override;
 	};
 
 	// Составная инструкция (например: тело метода, содержимое ветки if, либо else)
@@ -248,11 +524,23 @@ namespace ast {
 
 		// Последовательно выполняет добавленные инструкции. Возвращает None
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetStatements() const {
+			return statements_;
+		}
 	private:
 		std::vector<std::unique_ptr<Statement>> statements_;
 	};
 
-	// Тело метода. Как правило, содержит составную инструкцию
+	/*
+	Тело метода. Как правило, содержит составную инструкцию.
+	При создании тела анализ побега находит узлы, объекты которых не покидают кадр метода:
+	не присваиваются полям, не попадают в списки и словари, не возвращаются и не передаются
+	аргументами вызовов. Такие объекты только читаются (в условиях, арифметике, print) либо
+	хранятся в локальных переменных, которые используются так же. Экземпляр класса не покидает
+	кадр, если его методы, вызываемые здесь, включая __init__, сами не выпускают self.
+	Эти узлы размещают объекты в памяти кадра (см. FrameAllocation)
+	*/
 	class MethodBody : public Statement {
 	public:
 		explicit MethodBody(std::unique_ptr<Statement>&& body);
@@ -261,22 +549,57 @@ namespace ast {
 		// Если внутри body была выполнена инструкция return, возвращает результат return
 		// В противном случае возвращает None
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const Statement& GetBody() const {
+			return *body_;
+		}
+
+		// Возвращает число узлов тела, создающих объекты в памяти кадра (см. FrameAllocation)
+		[[nodiscard]] size_t GetFrameLocalCount() const {
+			return frame_local_count_;
+		}
+
+		// Задаёт оптимизированное представление тела (см. ir::CompiledMethod). Если оно задано,
+		// Execute выполняет его вместо body: оно должно само вернуть результат return
+		void SetOptimized(std::unique_ptr<Statement> optimized) {
+			optimized_ = std::move(optimized);
+		}
 	private:
 		std::unique_ptr<Statement> body_;
+		std::unique_ptr<Statement> optimized_;
+		size_t frame_local_count_ = 0;
 	};
 
+	/*
+	Анализирует инструкции верхнего уровня программы так же, как MethodBody - тело метода, но
+	считает покидающим инструкцию и значение, присвоенное переменной: переменные программы живут
+	до её конца. Отмеченные узлы размещают промежуточные значения выражений, например произведение
+	в a + b * c, в памяти верхнего уровня контекста (см. runtime::Context::GetFrameArena). Значения
+	умирают к концу своей инструкции, и страницы этой памяти сразу используются снова.
+	Возвращает число отмеченных узлов
+	*/
+	size_t MarkStatementTemporaries(const Statement& program);
+
 	// Выполняет инструкцию return с выражением statement
 	class Return : public Statement {
 	public:
 		explicit Return(std::unique_ptr<Statement> statement)
-			: statement_(std::move(statement)) {
+			: statement_(std::move(statement))
+			, tail_call_(dynamic_cast<MethodCall*>(statement_.get())) {
 		}
 
 		// Останавливает выполнение текущего метода. После выполнения инструкции return метод,
 		// внутри которого она была исполнена, должен вернуть результат вычисления выражения statement.
+		// Инструкция return obj.method(args) внутри метода выполняет вызов как хвостовой:
+		// он откладывается в context и выполняется в кадре текущего метода
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const Statement& GetStatement() const {
+			return *statement_;
+		}
 	private:
 		std::unique_ptr<Statement> statement_;
+		MethodCall* tail_call_;
 	};
 
 	// Объявляет класс
@@ -288,6 +611,10 @@ namespace ast {
 		// Создаёт внутри closure новый объект, совпадающий с именем класса и значением, переданным в
 		// конструктор
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const runtime::Class& GetClass() const {
+			return *cls_.TryAs<runtime::Class>();
+		}
 	private:
 		runtime::ObjectHolder cls_;
 	};
@@ -299,25 +626,130 @@ namespace ast {
 		IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
 			std::unique_ptr<Statement> else_body);
 
+		// Условие вычисляется через EvaluateCondition
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const Statement& GetCondition() const {
+			return *condition_;
+		}
+		[[nodiscard]] const Statement& GetIfBody() const {
+			return *if_body_;
+		}
+		// Возвращает nullptr, если ветка else отсутствует
+		[[nodiscard]] const Statement* GetElseBody() const {
+			return else_body_.get();
+		}
 	private:
 		std::unique_ptr<Statement> condition_, if_body_, else_body_;
 	};
 
-	// Операция сравнения
-	class Comparison : public BinaryOperation {
+	// Цикл while <condition>: <body>
+	class While : public Statement {
 	public:
-		// Comparator задаёт функцию, выполняющую сравнение значений аргументов
-		using Comparator = std::function<bool(const runtime::ObjectHolder&,
-			const runtime::ObjectHolder&, runtime::Context&)>;
+		While(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> body);
+
+		// Выполняет body, пока condition истинно. Условие вычисляется через EvaluateCondition.
+		// Инструкция return внутри body прекращает цикл. Возвращает None
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const Statement& GetCondition() const {
+			return *condition_;
+		}
+		[[nodiscard]] const Statement& GetBody() const {
+			return *body_;
+		}
+	private:
+		std::unique_ptr<Statement> condition_, body_;
+	};
 
-		Comparison(Comparator cmp, std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs);
+	/*
+	Цикл for <variable> in range(<begin>, <end>): <body>. Границы вычисляются один раз до начала
+	цикла и должны быть числами. Счётчик цикла хранится неупакованным целым.
+
+	Если значение переменной цикла в теле используется только как операнд арифметики, сравнений,
+	логических операций, str и print, оно не может пережить итерацию, и переменная связывается
+	с одним объектом Number, значение которого меняется на месте. Иначе (присваивание другой
+	переменной или полю, аргумент вызова, return) значение упаковывается в новый объект
+	на каждой итерации
+	*/
+	class ForRange : public Statement {
+	public:
+		ForRange(std::string variable, std::unique_ptr<Statement> begin, std::unique_ptr<Statement> end,
+			std::unique_ptr<Statement> body);
 
-		// Вычисляет значение выражений lhs и rhs и возвращает результат работы comparator,
-		// приведённый к типу runtime::Bool
+		// Выполняет body для значений переменной от begin до end - 1. Инструкция return внутри body
+		// прекращает цикл. Возвращает None
 		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const std::string& GetVariable() const {
+			return variable_;
+		}
+		[[nodiscard]] const Statement& GetBegin() const {
+			return *begin_;
+		}
+		[[nodiscard]] const Statement& GetEnd() const {
+			return *end_;
+		}
+		[[nodiscard]] const Statement& GetBody() const {
+			return *body_;
+		}
+		// Возвращает true, если значение переменной цикла может пережить итерацию и упаковывается заново
+		[[nodiscard]] bool IsVariableEscaping() const {
+			return escapes_;
+		}
+	private:
+		std::string variable_;
+		std::unique_ptr<Statement> begin_, end_, body_;
+		bool escapes_;
+	};
+
+	/*
+	Цикл for <variable> in <iterable>: <body> по элементам списка или ключам словаря в порядке
+	добавления. Контейнер вычисляется один раз, элементы перебираются по номеру, а размер
+	проверяется перед каждой итерацией, поэтому элементы, добавленные в теле цикла, тоже будут
+	перебраны
+	*/
+	class ForEach : public Statement {
+	public:
+		ForEach(std::string variable, std::unique_ptr<Statement> iterable, std::unique_ptr<Statement> body);
+
+		// Выполняет body для каждого элемента. Инструкция return внутри body прекращает цикл.
+		// Если iterable - не список и не словарь, выбрасывает runtime_error. Возвращает None
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] const std::string& GetVariable() const {
+			return variable_;
+		}
+		[[nodiscard]] const Statement& GetIterable() const {
+			return *iterable_;
+		}
+		[[nodiscard]] const Statement& GetBody() const {
+			return *body_;
+		}
+	private:
+		std::string variable_;
+		std::unique_ptr<Statement> iterable_, body_;
+	};
+
+	// Операция сравнения
+	class Comparison : public BinaryOperation, public FrameAllocation {
+	public:
+		// op задаёт операцию, выполняющую сравнение значений аргументов
+		Comparison(runtime::CompareOp op, std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs);
+
+		// Вычисляет значение выражений lhs и rhs и возвращает результат runtime::Compare,
+		// приведённый к типу runtime::Bool.
+		// Узел специализируется для пар чисел и пар строк (см. OperandProfile)
+		runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+		// Вычисляет то же сравнение, не создавая объект Bool
+		bool EvaluateCondition(runtime::Closure& closure, runtime::Context& context) override;
+
+		[[nodiscard]] runtime::CompareOp GetOp() const {
+			return op_;
+		}
 	private:
-		Comparator cmp_;
+		runtime::CompareOp op_;
+		OperandProfile profile_;
 	};
 
 }  // namespace ast
\ No newline at end of file
@@ -287,6 +287,35 @@ namespace ast {
 			ASSERT(context.output.str().empty());
 		}
 
+		void TestSpecializedOperations() {
+			runtime::DummyContext context;
+
+			Add sum(make_unique<VariableValue>("x"s), make_unique<VariableValue>("y"s));
+			Sub diff(make_unique<VariableValue>("x"s), make_unique<VariableValue>("y"s));
+			Comparison less(runtime::CompareOp::Less, make_unique<VariableValue>("x"s), make_unique<VariableValue>("y"s));
+
+			Closure closure = { {"x"s, ObjectHolder::Own(runtime::Number(5))},
+							   {"y"s, ObjectHolder::Own(runtime::Number(3))} };
+			for (int i = 0; i < 4; ++i) {
+				ASSERT_OBJECT_VALUE_EQUAL(sum.Execute(closure, context), 8);
+				ASSERT_OBJECT_VALUE_EQUAL(diff.Execute(closure, context), 2);
+				ASSERT_OBJECT_VALUE_EQUAL(less.Execute(closure, context), "False"s);
+			}
+
+			// Узлы, специализированные для чисел, продолжают работать после смены типов операндов
+			closure["x"s] = ObjectHolder::Own(runtime::String("ab"s));
+			closure["y"s] = ObjectHolder::Own(runtime::String("cd"s));
+			ASSERT_OBJECT_VALUE_EQUAL(sum.Execute(closure, context), "abcd"s);
+			ASSERT_OBJECT_VALUE_EQUAL(less.Execute(closure, context), "True"s);
+			ASSERT_THROWS(diff.Execute(closure, context), std::runtime_error);
+
+			closure["y"s] = ObjectHolder::Own(runtime::Number(1));
+			ASSERT_THROWS(sum.Execute(closure, context), std::runtime_error);
+			ASSERT_THROWS(less.Execute(closure, context), std::runtime_error);
+
+			ASSERT(context.output.str().empty());
+		}
+
 		void TestCompound() {
 			runtime::DummyContext context;
 
@@ -453,6 +482,67 @@ namespace ast {
 			test_not(false);
 		}
 
+		void TestEvaluateCondition() {
+			Closure closure;
+			runtime::DummyContext context;
+			ASSERT(!NumericConst(runtime::Number(0)).EvaluateCondition(closure, context));
+			ASSERT(NumericConst(runtime::Number(-3)).EvaluateCondition(closure, context));
+			ASSERT(!StringConst(runtime::String(""s)).EvaluateCondition(closure, context));
+			ASSERT(StringConst(runtime::String("a"s)).EvaluateCondition(closure, context));
+
+			Comparison less{ runtime::CompareOp::Less, make_unique<NumericConst>(runtime::Number(1)),
+				make_unique<NumericConst>(runtime::Number(2)) };
+			for (int i = 0; i < 4; ++i) {
+				ASSERT(less.EvaluateCondition(closure, context));
+			}
+
+			// Правый операнд не вычисляется, если результат известен по левому
+			Or or_statement{ make_unique<BoolConst>(true), make_unique<VariableValue>("undefined"s) };
+			ASSERT(or_statement.EvaluateCondition(closure, context));
+			And and_statement{ make_unique<NumericConst>(runtime::Number(0)), make_unique<VariableValue>("undefined"s) };
+			ASSERT(!and_statement.EvaluateCondition(closure, context));
+
+			Not not_statement{ make_unique<Comparison>(runtime::CompareOp::Equal,
+				make_unique<StringConst>(runtime::String("x"s)), make_unique<StringConst>(runtime::String("y"s))) };
+			ASSERT(not_statement.EvaluateCondition(closure, context));
+			ASSERT_EQUAL(runtime::IsTrue(not_statement.Execute(closure, context)), true);
+
+			ASSERT(context.output.str().empty());
+		}
+
+		void TestForRange() {
+			Closure closure;
+			runtime::DummyContext context;
+
+			// Переменная только читается: один объект на весь цикл
+			ForRange printing("i"s, make_unique<NumericConst>(runtime::Number(1)), make_unique<NumericConst>(runtime::Number(4)),
+				make_unique<Print>(make_unique<Add>(make_unique<VariableValue>("i"s), make_unique<NumericConst>(runtime::Number(10)))));
+			ASSERT(!printing.IsVariableEscaping());
+			printing.Execute(closure, context);
+			ASSERT_EQUAL(context.output.str(), "11\n12\n13\n"s);
+			ASSERT_OBJECT_VALUE_EQUAL(closure.at("i"s), 3);
+
+			// Значение переменной сохраняется в другой переменной и должно упаковываться заново
+			ForRange copying("i"s, make_unique<NumericConst>(runtime::Number(0)), make_unique<NumericConst>(runtime::Number(3)),
+				make_unique<Compound>(make_unique<Assignment>("prev"s, make_unique<VariableValue>("last"s)),
+					make_unique<Assignment>("last"s, make_unique<VariableValue>("i"s))));
+			ASSERT(copying.IsVariableEscaping());
+			closure["last"s] = ObjectHolder::None();
+			copying.Execute(closure, context);
+			ASSERT_OBJECT_VALUE_EQUAL(closure.at("prev"s), 1);
+			ASSERT_OBJECT_VALUE_EQUAL(closure.at("last"s), 2);
+
+			// Правый операнд сравнения передаётся методу __eq__ левого
+			ForRange comparing("i"s, make_unique<NumericConst>(runtime::Number(0)), make_unique<NumericConst>(runtime::Number(3)),
+				make_unique<Print>(make_unique<Comparison>(runtime::CompareOp::Equal, make_unique<VariableValue>("x"s),
+					make_unique<VariableValue>("i"s))));
+			ASSERT(comparing.IsVariableEscaping());
+			ForRange numeric("i"s, make_unique<NumericConst>(runtime::Number(0)), make_unique<NumericConst>(runtime::Number(3)),
+				make_unique<Print>(make_unique<Comparison>(runtime::CompareOp::Equal, make_unique<NumericConst>(runtime::Number(1)),
+					make_unique<VariableValue>("i"s))));
+			ASSERT(!numeric.IsVariableEscaping());
+		}
+
 	}  // namespace
 
 	void RunUnitTests(TestRunner& tr) {
@@ -469,6 +559,7 @@ namespace ast {
 		RUN_TEST(tr, ast::TestBadAddition);
 		RUN_TEST(tr, ast::TestSuccessfulClassInstanceAdd);
 		RUN_TEST(tr, ast::TestClassInstanceAddWithoutMethod);
+		RUN_TEST(tr, ast::TestSpecializedOperations);
 		RUN_TEST(tr, ast::TestCompound);
 		RUN_TEST(tr, ast::TestFields);
 		RUN_TEST(tr, ast::TestBaseClass);
@@ -476,6 +567,8 @@ namespace ast {
 		RUN_TEST(tr, ast::TestOr);
 		RUN_TEST(tr, ast::TestAnd);
 		RUN_TEST(tr, ast::TestNot);
+		RUN_TEST(tr, ast::TestEvaluateCondition);
+		RUN_TEST(tr, ast::TestForRange);
 	}
 
 }  // namespace ast
\ No newline at end of file